@@ -0,0 +1,175 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/CommandBuilder.h>
+#include <terminal/Parser.h>
+
+#include <unicode/utf8.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+using namespace std;
+using namespace terminal;
+using namespace terminal::parser;
+
+namespace
+{
+    /// Counts parser events, fully visible to the compiler.
+    struct CountingListener {
+        uint64_t events = 0;
+
+        void operator()(ActionClass, Action, char32_t) { ++events; }
+    };
+
+    /// The parser's state machine as it used to be driven before the parser became a template
+    /// over its listener, serving as the baseline: Every byte is decoded and looked up on its own,
+    /// and each transition invokes the type-erased action handler three times (on leaving a state,
+    /// for the transition itself, and on entering the next state), including for Action::Undefined
+    /// and Action::Ignore.
+    class LegacyParser {
+      public:
+        using ActionHandler = function<void(ActionClass, Action, char32_t)>;
+
+        explicit LegacyParser(ActionHandler _actionHandler) : actionHandler_{move(_actionHandler)} {}
+
+        void parseFragment(string const& _data)
+        {
+            static constexpr char32_t ReplacementCharacter {0xFFFD};
+
+            for (char const byte : _data)
+            {
+                auto const result = unicode::from_utf8(utf8DecoderState_, static_cast<uint8_t>(byte));
+                if (holds_alternative<unicode::Success>(result))
+                    processInput(get<unicode::Success>(result).value);
+                else if (holds_alternative<unicode::Invalid>(result))
+                    processInput(ReplacementCharacter);
+            }
+        }
+
+      private:
+        void processInput(char32_t _ch)
+        {
+            auto const s = static_cast<size_t>(state_);
+
+            ParserTable static constexpr table = ParserTable::get();
+
+            auto const ch = _ch < 0xFF ? _ch : static_cast<char32_t>(ParserTable::UnicodeCodepoint::Value);
+
+            if (auto const t = table.transitions[s][ch]; t != State::Undefined)
+            {
+                actionHandler_(ActionClass::Leave, table.exitEvents[s], _ch);
+                actionHandler_(ActionClass::Transition, table.events[s][ch], _ch);
+                state_ = t;
+                actionHandler_(ActionClass::Enter, table.entryEvents[static_cast<size_t>(t)], _ch);
+            }
+            else if (Action const a = table.events[s][ch]; a != Action::Undefined)
+                actionHandler_(ActionClass::Event, a, _ch);
+        }
+
+        State state_ = State::Ground;
+        unicode::utf8_decoder_state utf8DecoderState_{};
+        ActionHandler actionHandler_;
+    };
+
+    string makeWorkload(string_view _name, size_t _size)
+    {
+        string_view constexpr alphabet =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZ "
+            "abcdefghijklmnopqrstuvwxyz "
+            "0123456789 []{}();+-*/=";
+
+        string data;
+        data.reserve(_size + 64);
+
+        size_t i = 0;
+        while (data.size() < _size)
+        {
+            if (_name == "ascii")
+                data += alphabet[i % alphabet.size()];
+            else if (_name == "utf8")
+                data += "\xC3\xB6\xE2\x82\xAC\xE4\xB8\xAD\xF0\x9F\x98\x80 ";
+            else if (_name == "sgr")
+                data += fmt::format("\033[{};{};{}m{}", i % 8, 30 + i % 8, 40 + (i / 8) % 8, alphabet[i % alphabet.size()]);
+            else if (_name == "csi")
+                data += fmt::format("\033[{};{}H\033[K", 1 + i % 24, 1 + i % 80);
+
+            if (i % 80 == 79)
+                data += "\r\n";
+            ++i;
+        }
+
+        return data;
+    }
+
+    template <typename P>
+    double measure(P& _parser, string const& _data, size_t _repeat)
+    {
+        auto const start = chrono::steady_clock::now();
+        for (size_t i = 0; i < _repeat; ++i)
+            _parser.parseFragment(_data);
+        auto const end = chrono::steady_clock::now();
+
+        auto const ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+        return static_cast<double>(ns) / static_cast<double>(_data.size() * _repeat);
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    // Number of times each 1 MiB chunk of input is parsed.
+    size_t const repeat = argc > 1 ? static_cast<size_t>(max(atoi(argv[1]), 1)) : 16;
+    size_t constexpr chunkSize = 1024 * 1024;
+
+    cout << fmt::format("{:<8} {:>14} {:>14} {:>14}\n", "input", "legacy ns/B", "inline ns/B", "builder ns/B");
+
+    for (auto const name : {"ascii", "utf8", "sgr", "csi"})
+    {
+        auto const data = makeWorkload(name, chunkSize);
+
+        // Only the events a listener of the templated parser would receive are counted.
+        auto legacyCount = uint64_t{0};
+        auto legacyParser = LegacyParser{[&](ActionClass, Action _action, char32_t) {
+            if (_action != Action::Undefined && _action != Action::Ignore)
+                ++legacyCount;
+        }};
+        auto const legacy = measure(legacyParser, data, repeat);
+
+        auto counting = CountingListener{};
+        auto countingParser = Parser{counting};
+        auto const inlined = measure(countingParser, data, repeat);
+
+        // Full sequencing, with commands being dropped right away.
+        auto builder = CommandBuilder{Logger{}};
+        builder.setSink([](Command const&) {});
+        auto builderParser = Parser{builder};
+        auto const viaBuilder = measure(builderParser, data, repeat);
+
+        if (counting.events != legacyCount)
+            cerr << "Event count mismatch for " << name << ".\n";
+
+        cout << fmt::format("{:<8} {:>14.3f} {:>14.3f} {:>14.3f}\n", name, legacy, inlined, viaBuilder);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Screen.h>
+#include <terminal/ScreenEvents.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+
+using namespace std;
+using namespace terminal;
+
+// {{{ allocation counting
+namespace
+{
+    atomic<uint64_t> allocationCount{0};
+}
+
+void* operator new(size_t _size)
+{
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(_size != 0 ? _size : 1))
+        return p;
+    throw bad_alloc{};
+}
+
+void operator delete(void* _p) noexcept
+{
+    free(_p);
+}
+
+void operator delete(void* _p, size_t) noexcept
+{
+    free(_p);
+}
+// }}}
+
+namespace
+{
+    constexpr auto ScreenSize = Size{80, 25};
+    constexpr size_t HistoryLineCount = 1000;
+
+    /// Size of the chunks written to the screen at once, as if read from a PTY.
+    constexpr size_t ChunkSize = 4096;
+
+    string_view constexpr alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ "
+        "abcdefghijklmnopqrstuvwxyz "
+        "0123456789 []{}();+-*/=";
+
+    /// Appends one line of the given workload to @p _data.
+    void appendLine(string& _data, string_view _name, size_t _line)
+    {
+        auto const width = static_cast<size_t>(ScreenSize.width);
+
+        if (_name == "ascii")
+        {
+            for (size_t i = 0; i < width - 1; ++i)
+                _data += alphabet[(_line + i) % alphabet.size()];
+            _data += "\r\n";
+        }
+        else if (_name == "cjk")
+        {
+            // Double width characters filling the line.
+            for (size_t i = 0; i < width / 2 - 1; ++i)
+                _data += (_line + i) % 2 ? "\xE4\xB8\xAD" : "\xE6\x96\x87";
+            _data += "\r\n";
+        }
+        else if (_name == "emoji")
+        {
+            // Grapheme clusters of several codepoints: ZWJ sequences, skin tones and flags.
+            for (size_t i = 0; i < 12; ++i)
+            {
+                switch ((_line + i) % 3)
+                {
+                    case 0: _data += "\xF0\x9F\x91\xA8\xE2\x80\x8D\xF0\x9F\x91\xA9\xE2\x80\x8D\xF0\x9F\x91\xA7 "; break;
+                    case 1: _data += "\xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD "; break;
+                    case 2: _data += "\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA "; break;
+                }
+            }
+            _data += "\r\n";
+        }
+        else if (_name == "sgr")
+        {
+            for (size_t i = 0; i < width - 1; ++i)
+                _data += fmt::format("\033[{};{};{}m{}", (_line + i) % 8, 30 + i % 8, 40 + (_line / 8 + i) % 8,
+                                     alphabet[(_line + i) % alphabet.size()]);
+            _data += "\033[m\r\n";
+        }
+        else if (_name == "scroll")
+        {
+            // Scrolling within top/bottom and left/right margins, as split views do.
+            if (_line % static_cast<size_t>(ScreenSize.height) == 0)
+                _data += "\033[?69h\033[5;20r\033[10;70s\033[20;10H";
+            _data += fmt::format("{} {}", _line, alphabet.substr(0, 40));
+            _data += "\n\033[10G";
+        }
+        else if (_name == "redraw")
+        {
+            // Cursor addressed updates of the full screen, as full screen applications do.
+            auto const row = 1 + _line % static_cast<size_t>(ScreenSize.height);
+            _data += fmt::format("\033[{};1H\033[{}m", row, 31 + _line % 7);
+            for (size_t i = 0; i < width; ++i)
+                _data += alphabet[(_line * 7 + i) % alphabet.size()];
+        }
+        else if (_name == "hyperlink")
+        {
+            for (size_t i = 0; i < 4; ++i)
+                _data += fmt::format("\033]8;id={};https://example.com/{}/{}\033\\link {}\033]8;;\033\\ ",
+                                     i, _line, i, i);
+            _data += "\r\n";
+        }
+    }
+
+    string makeWorkload(string_view _name, size_t _size)
+    {
+        auto data = string{};
+        data.reserve(_size + 1024);
+        for (size_t line = 0; data.size() < _size; ++line)
+            appendLine(data, _name, line);
+        return data;
+    }
+
+    struct Result {
+        double megabytesPerSecond;
+        double nanosecondsPerByte;
+        double allocationsPerByte;
+    };
+
+    Result measure(string const& _data, size_t _repeat)
+    {
+        auto events = ScreenEvents{};
+        auto screen = Screen{ScreenSize, events, Logger{}, false, false, HistoryLineCount};
+
+        auto const allocationsBefore = allocationCount.load();
+        auto const start = chrono::steady_clock::now();
+
+        for (size_t i = 0; i < _repeat; ++i)
+            for (size_t offset = 0; offset < _data.size(); offset += ChunkSize)
+                screen.write(_data.data() + offset, min(ChunkSize, _data.size() - offset));
+
+        auto const end = chrono::steady_clock::now();
+        auto const allocations = allocationCount.load() - allocationsBefore;
+
+        auto const bytes = static_cast<double>(_data.size() * _repeat);
+        auto const ns = static_cast<double>(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+
+        return Result{
+            bytes / (1024.0 * 1024.0) / (ns / 1e9),
+            ns / bytes,
+            static_cast<double>(allocations) / bytes
+        };
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    size_t const sizeMB = argc > 1 ? static_cast<size_t>(max(atoi(argv[1]), 1)) : 16;
+    size_t constexpr workloadSize = 1024 * 1024;
+
+    cout << fmt::format("Writing {} MB per workload to a {}x{} screen, in chunks of {} bytes.\n\n",
+                        sizeMB, ScreenSize.width, ScreenSize.height, ChunkSize);
+    cout << fmt::format("{:<10} {:>10} {:>10} {:>12}\n", "workload", "MB/s", "ns/B", "allocs/B");
+
+    for (auto const name : {"ascii", "cjk", "emoji", "sgr", "scroll", "redraw", "hyperlink"})
+    {
+        auto const data = makeWorkload(name, workloadSize);
+        auto const result = measure(data, sizeMB);
+        cout << fmt::format("{:<10} {:>10.2f} {:>10.2f} {:>12.5f}\n",
+                            name, result.megabytesPerSecond, result.nanosecondsPerByte, result.allocationsPerByte);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyRecording.h>
+#include <terminal/Screen.h>
+#include <terminal/ScreenEvents.h>
+
+#include <crispy/FNV.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace terminal;
+
+namespace
+{
+    void usage()
+    {
+        cerr << "Usage: vtreplay [--realtime] [--repeat N] FILE\n"
+                "\n"
+                "Replays a PTY recording onto a headless screen, as fast as possible by default,\n"
+                "and reports the throughput as well as a hash of the screen contents after one replay.\n";
+    }
+
+    vector<PtyRecord> load(PtyRecording& _recording)
+    {
+        auto records = vector<PtyRecord>{};
+        while (auto record = _recording.next())
+            records.emplace_back(move(*record));
+        return records;
+    }
+
+    uint64_t screenHash(string_view _text)
+    {
+        auto const fnv = crispy::FNV<uint64_t>{1099511628211llu, 14695981039346656037llu};
+        auto memory = uint64_t{14695981039346656037llu};
+        for (char const ch : _text)
+            memory = fnv(memory, static_cast<uint8_t>(ch));
+        return memory;
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    bool realtime = false;
+    int repeat = 1;
+    string path;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        auto const arg = string_view{argv[i]};
+        if (arg == "--realtime")
+            realtime = true;
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = max(atoi(argv[++i]), 1);
+        else if (path.empty() && !arg.empty() && arg[0] != '-')
+            path = arg;
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (path.empty())
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        auto file = ifstream{path, ios::binary};
+        if (!file.good())
+        {
+            cerr << "Failed to open " << path << ".\n";
+            return EXIT_FAILURE;
+        }
+
+        // Loaded upfront, so that reading the file is not measured.
+        auto recording = PtyRecording{file};
+        auto const records = load(recording);
+
+        uint64_t bytes = 0;
+        uint64_t commands = 0;
+        string screenshot;
+        auto elapsed = chrono::steady_clock::duration{};
+
+        for (int round = 0; round < repeat; ++round)
+        {
+            // Each round starts over from the initial screen, so that the screen hash
+            // is the one of a single replay, regardless of the number of rounds.
+            auto events = ScreenEvents{};
+            auto screen = Screen{recording.initialScreenSize(), events};
+
+            auto const roundStart = chrono::steady_clock::now();
+            for (PtyRecord const& record : records)
+            {
+                if (realtime)
+                    this_thread::sleep_until(roundStart + record.time);
+
+                switch (record.type)
+                {
+                    case PtyRecord::Type::Output:
+                        screen.write(record.output.data(), record.output.size());
+                        bytes += record.output.size();
+                        break;
+                    case PtyRecord::Type::Resize:
+                        screen.resize(record.size);
+                        break;
+                }
+            }
+
+            elapsed += chrono::steady_clock::now() - roundStart;
+
+            commands += screen.commandCount();
+            if (round == 0)
+                screenshot = screen.screenshot();
+        }
+
+        auto const seconds = chrono::duration<double>(elapsed).count();
+        cout << fmt::format("records:      {}\n", records.size() * static_cast<size_t>(repeat));
+        cout << fmt::format("bytes:        {}\n", bytes);
+        cout << fmt::format("duration:     {:.3f} s\n", seconds);
+        cout << fmt::format("throughput:   {:.2f} MB/s\n", static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds);
+        cout << fmt::format("commands:     {}\n", commands);
+        cout << fmt::format("commands/s:   {:.0f}\n", static_cast<double>(commands) / seconds);
+        cout << fmt::format("screen hash:  {:016x}\n", screenHash(screenshot));
+    }
+    catch (exception const& e)
+    {
+        cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -22,6 +22,7 @@ namespace contour::actions {
 struct FollowHyperlink{};
 struct ToggleFullScreen{};
 struct ScreenshotVT{};
+struct ToggleRecording{ std::optional<std::string> path; };
 struct IncreaseFontSize{};
 struct DecreaseFontSize{};
 struct IncreaseOpacity{};
@@ -62,6 +63,7 @@ using Action = std::variant<
     ResetConfig,
     ToggleFullScreen,
     ScreenshotVT,
+    ToggleRecording,
     IncreaseFontSize,
     DecreaseFontSize,
     IncreaseOpacity,
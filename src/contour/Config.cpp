@@ -465,6 +465,14 @@ void parseInputMapping(Config& _config, YAML::Node const& _mapping)
                 return action;
         }
 
+        if (holds_alternative<actions::ToggleRecording>(action))
+        {
+            if (auto path = _parent["path"]; path && path.IsScalar())
+                return actions::ToggleRecording{path.as<string>()};
+            else
+                return action;
+        }
+
         if (holds_alternative<actions::SendChars>(action))
         {
             if (auto chars = _parent["chars"]; chars.IsScalar())
@@ -724,6 +732,7 @@ TerminalProfile loadTerminalProfile(YAML::Node const& _node,
     }
 
     softLoadValue(_node, "tab_width", profile.tabWidth);
+    softLoadValue(_node, "max_control_string_size", profile.maxControlStringSize);
 
     if (auto history = _node["history"]; history)
     {
@@ -735,6 +744,14 @@ TerminalProfile loadTerminalProfile(YAML::Node const& _node,
                 profile.maxHistoryLineCount = limit.as<size_t>();
         }
 
+        if (auto memoryPages = history["memory_pages"]; memoryPages)
+        {
+            if (memoryPages.as<int>() < 0)
+                profile.maxHistoryPagesInMemory = nullopt;
+            else
+                profile.maxHistoryPagesInMemory = memoryPages.as<size_t>();
+        }
+
         softLoadValue(history, "auto_scroll_on_update", profile.autoScrollOnUpdate);
         softLoadValue(history, "scroll_multiplier", profile.historyScrollMultiplier);
     }
@@ -784,6 +801,7 @@ void loadConfigFromFile(Config& _config,
     YAML::Node doc = YAML::LoadFile(_fileName.string());
 
     softLoadValue(doc, "word_delimiters", _config.wordDelimiters);
+    softLoadValue(doc, "text_shaping_cache_size", _config.textShapingCacheSize);
 
     if (auto profiles = doc["color_schemes"]; profiles)
     {
@@ -81,6 +81,7 @@ struct TerminalProfile {
     terminal::Size terminalSize;
 
     std::optional<int> maxHistoryLineCount;
+    std::optional<size_t> maxHistoryPagesInMemory;
     int historyScrollMultiplier;
     bool autoScrollOnUpdate;
 
@@ -89,6 +90,9 @@ struct TerminalProfile {
 
     int tabWidth;
 
+    /// Upper bound in bytes for a single OSC or DCS control string, such as an OSC 52 clipboard update.
+    size_t maxControlStringSize = 8 * 1024 * 1024;
+
     terminal::ColorProfile colors;
 
     terminal::CursorShape cursorShape;
@@ -130,6 +134,9 @@ struct Config {
     // selection
     std::string wordDelimiters;
 
+    // rendering
+    size_t textShapingCacheSize = 8192;
+
     // input mapping
     std::map<QKeySequence, std::vector<actions::Action>> keyMappings;
     std::unordered_map<terminal::MouseEvent, std::vector<actions::Action>> mouseMappings;
@@ -532,6 +532,12 @@ void TerminalWindow::initializeGL()
     terminalView_->terminal().setLogRawOutput((config_.loggingMask & LogMask::RawOutput) != LogMask::None);
     terminalView_->terminal().setLogTraceOutput((config_.loggingMask & LogMask::TraceOutput) != LogMask::None);
     terminalView_->terminal().setTabWidth(profile().tabWidth);
+    terminalView_->terminal().setMaxHistoryPagesInMemory(profile().maxHistoryPagesInMemory);
+    terminalView_->terminal().setMaxPayloadSize(profile().maxControlStringSize);
+    terminalView_->setTextShapingCacheCapacity(config_.textShapingCacheSize);
+#if defined(CONTOUR_VT_METRICS)
+    terminalView_->terminal().screen().setRecordCommands(true);
+#endif
 }
 
 void TerminalWindow::resizeEvent(QResizeEvent* _event)
@@ -674,6 +680,9 @@ bool TerminalWindow::reloadConfigValues(config::Config _newConfig, string const&
 
     terminalView_->terminal().setWordDelimiters(_newConfig.wordDelimiters);
 
+    if (_newConfig.textShapingCacheSize != config_.textShapingCacheSize)
+        terminalView_->setTextShapingCacheCapacity(_newConfig.textShapingCacheSize);
+
     terminalView_->terminal().setLogRawOutput((_newConfig.loggingMask & LogMask::RawOutput) != LogMask::None);
     terminalView_->terminal().setLogTraceOutput((_newConfig.loggingMask & LogMask::TraceOutput) != LogMask::None);
 
@@ -824,7 +833,7 @@ void TerminalWindow::mouseMoveEvent(QMouseEvent* _event)
             auto const currentMousePosition = terminalView_->terminal().currentMousePosition();
             if (terminalView_->terminal().screen().contains(currentMousePosition))
             {
-                if (terminalView_->terminal().screen().at(currentMousePosition).hyperlink())
+                if (terminalView_->terminal().screen().hyperlinkAt(currentMousePosition))
                     setCursor(Qt::CursorShape::PointingHandCursor);
                 else
                     setDefaultCursor();
@@ -979,6 +988,27 @@ bool TerminalWindow::executeAction(Action const& _action)
             ofs << screenshot;
             return Result::Silently;
         },
+        [&](actions::ToggleRecording const& v) -> Result {
+            auto& terminal = terminalView_->terminal();
+            if (terminal.recording())
+            {
+                terminal.stopRecording();
+                cerr << "Stopped recording." << endl;
+                return Result::Silently;
+            }
+
+            auto const path = v.path.value_or("recording.vtrec");
+            try
+            {
+                terminal.startRecording(path);
+                cerr << fmt::format("Recording to '{}'.", path) << endl;
+            }
+            catch (std::exception const& e)
+            {
+                cerr << fmt::format("Failed to start recording to '{}'. {}", path, e.what()) << endl;
+            }
+            return Result::Silently;
+        },
         [this](actions::SendChars const& chars) -> Result {
             for (auto const ch : chars.chars)
                 terminalView_->terminal().send(terminal::CharInputEvent{static_cast<char32_t>(ch), terminal::Modifier::None}, now_);
@@ -1063,7 +1093,9 @@ bool TerminalWindow::executeAction(Action const& _action)
         },
         [this](actions::Quit) -> Result {
             // XXX: later warn here when more then one terminal view is open
-            terminalView_->terminal().device().close();
+            // The PTY is not watched anymore once closed, so the window is closed right away.
+            terminalView_->terminal().close();
+            close();
             return Result::Silently;
         },
         [this](actions::ResetFontSize) -> Result {
@@ -1099,7 +1131,7 @@ bool TerminalWindow::executeAction(Action const& _action)
             auto const currentMousePosition = terminalView_->terminal().currentMousePosition();
             if (terminalView_->terminal().screen().contains(currentMousePosition))
             {
-                if (auto hyperlink = terminalView_->terminal().screen().at(currentMousePosition).hyperlink(); hyperlink != nullptr)
+                if (auto hyperlink = terminalView_->terminal().screen().hyperlinkAt(currentMousePosition); hyperlink != nullptr)
                 {
                     followHyperlink(*hyperlink);
                     return Result::Silently;
@@ -1186,6 +1218,8 @@ void TerminalWindow::setProfile(config::TerminalProfile newProfile)
         terminalView_->setTerminalSize(newScreenSize);
         // TODO: maybe update margin after this call?
     terminalView_->terminal().setMaxHistoryLineCount(newProfile.maxHistoryLineCount);
+    terminalView_->terminal().setMaxHistoryPagesInMemory(newProfile.maxHistoryPagesInMemory);
+    terminalView_->terminal().setMaxPayloadSize(newProfile.maxControlStringSize);
 
     terminalView_->setColorProfile(newProfile.colors);
 
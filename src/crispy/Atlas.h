@@ -18,14 +18,21 @@
 #include <fmt/format.h>
 #include <iostream>
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <iomanip> // setprecision
-#include <list>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <optional>
 #include <ostream>
+#include <string>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -99,14 +106,29 @@ class CommandListener {
     virtual void destroyAtlas(DestroyAtlas const&) = 0;
 };
 
+/// Listener API to textures being removed from a TextureAtlasAllocator without their owner asking for it,
+/// that is, by being evicted to make room for other textures, or by clearing the whole atlas.
+class EvictionListener {
+  public:
+    virtual ~EvictionListener() = default;
+
+    /// Invoked right before the given texture is removed from the atlas, invalidating it.
+    virtual void textureEvicted(TextureInfo const& _texture) = 0;
+};
+
 /**
  * Texture Atlas API.
  *
  * This Texture atlas stores textures with given dimension in a 3 dimensional array of atlases.
  * Thus, you may say a 4D atlas ;-)
  *
- * @param Key a comparable key (such as @c char or @c uint32_t) to use to store and access textures.
- * @param Metadata some optionally accessible metadata that is attached with each texture.
+ * Textures are packed into shelves, that is, rows of textures of similar height stacked on top of
+ * each other on each 2D layer of the atlas. Once no space is left, the least recently used
+ * evictable textures are evicted to make room for new ones, except for those used in the current
+ * frame, as their render commands may still be pending.
+ *
+ * Space freed within a shelf is merged with adjacent free space, and empty shelves at the top of
+ * a layer are dropped, so that the space can be reused for textures of any height.
  */
 class TextureAtlasAllocator {
   public:
@@ -131,16 +153,15 @@ class TextureAtlasAllocator {
                           CommandListener& _listener,
                           std::string _name = {})
       : instanceBaseId_{ _instanceBaseId },
-        maxInstances_{ _maxInstances },
-        depth_{ _depth },
+        maxInstances_{ std::max(_maxInstances, 1u) },
+        depth_{ std::max(_depth, 1u) },
         width_{ _width },
         height_{ _height },
         format_{ _format },
         name_{ std::move(_name) },
-        commandListener_{ _listener },
-        currentInstanceId_{ instanceBaseId_ }
+        commandListener_{ _listener }
     {
-        notifyCreateAtlas();
+        addLayer();
     }
 
     TextureAtlasAllocator(TextureAtlasAllocator const&) = delete;
@@ -150,7 +171,7 @@ class TextureAtlasAllocator {
 
     ~TextureAtlasAllocator()
     {
-        for (unsigned id = instanceBaseId_; id <= currentInstanceId_; ++id)
+        for (unsigned id = instanceBaseId_; id < instanceBaseId_ + instanceCount(); ++id)
             commandListener_.destroyAtlas(DestroyAtlas{id, name_});
     }
 
@@ -161,143 +182,422 @@ class TextureAtlasAllocator {
     constexpr unsigned height() const noexcept { return height_; }
 
     /// @return number of internally used 3D texture atlases.
-    constexpr unsigned currentInstance() const noexcept { return currentInstanceId_; }
-
-    /// @return number of 2D text atlases in use in current 3D texture atlas.
-    constexpr unsigned currentZ() const noexcept { return currentZ_; }
+    unsigned instanceCount() const noexcept { return static_cast<unsigned>(layers_.size() + depth_ - 1) / depth_; }
 
-    /// @return current X offset into the current 3D texture atlas.
-    constexpr unsigned currentX() const noexcept { return currentX_; }
+    /// @return number of textures stored.
+    size_t size() const noexcept { return slots_.size() - freeSlots_.size(); }
 
-    /// @return current Y offset into the current 3D texture atlas.
-    constexpr unsigned currentY() const noexcept { return currentY_; }
+    /// @return number of shelves textures are packed into.
+    size_t shelfCount() const noexcept { return shelves_.size() - freeShelves_.size(); }
 
-    constexpr unsigned maxTextureHeightInCurrentRow() const noexcept { return maxTextureHeightInCurrentRow_; }
+    /// @return number of textures evicted so far.
+    uint64_t evictions() const noexcept { return evictions_; }
 
+    /// Removes all textures, notifying the eviction listeners of those that have one.
     void clear()
     {
-        currentInstanceId_ = instanceBaseId_;
-        currentZ_ = 0;
-        currentX_ = 0;
-        currentY_ = 0;
-        maxTextureHeightInCurrentRow_ = 0;
+        for (Slot const& slot : slots_)
+            if (slot.used && slot.listener)
+                slot.listener->textureEvicted(slot);
+
+        slots_.clear();
+        freeSlots_.clear();
+        shelves_.clear();
+        freeShelves_.clear();
+        for (Layer& layer : layers_)
+            layer.shelves.clear();
+        lruHead_ = npos;
+        lruTail_ = npos;
     }
 
-    TextureInfo& get(size_t _index) { return *std::next(std::begin(textureInfos_), _index); }
-    TextureInfo const& get(size_t _index) const { return *std::next(std::begin(textureInfos_), _index); }
-
     /// Inserts a new texture into the atlas.
     ///
-    /// @param _id       a unique identifier used for accessing this texture
     /// @param _width    texture width in pixels
     /// @param _height   texture height in pixels
     /// @param _format   data format
     /// @param _data     raw texture data to be inserted
     /// @param _user     user defined data that is supplied along with TexCoord's 4th component
+    /// @param _listener optional listener to be notified when this texture is evicted
+    /// @param _evictable whether or not this texture may be evicted to make room for other textures
     ///
-    /// @return index to the created TextureInfo or std::nullopt if failed.
+    /// @return the created TextureInfo, valid until released or evicted, or nullptr if failed.
     TextureInfo const* insert(unsigned _width,
                               unsigned _height,
                               unsigned _targetWidth,
                               unsigned _targetHeight,
                               unsigned _format,
                               Buffer&& _data,
-                              unsigned _user = 0)
+                              unsigned _user = 0,
+                              EvictionListener* _listener = nullptr,
+                              bool _evictable = false)
     {
         // fail early if to-be-inserted texture is too large to fit a single page in the whole atlas
         if (_height > height_ || _width > width_)
             return nullptr;
 
-        // ensure we have enough width space in current row
-        if (currentX_ + _width >= width_ && !advanceY())
-            return nullptr;
+        auto placement = findPlacement(_width, _height);
+        while (!placement.has_value() && lruTail_ != npos && slots_[lruTail_].lastUsed != frame_)
+        {
+            evict(lruTail_);
+            placement = findPlacement(_width, _height);
+        }
 
-        // ensure we have enoguh height space in current row
-        if (currentY_ + _height > height_ && !advanceZ())
+        if (!placement.has_value())
             return nullptr;
 
-        textureInfos_.emplace_back(TextureInfo{
-            currentInstanceId_,
+        Shelf& shelf = shelves_[placement->shelf];
+        Layer const& layer = layers_[shelf.layer];
+        shelf.allocate(placement->x, _width);
+
+        auto const index = allocateSlot(TextureInfo{
+            layer.instance,
             name_,
-            currentX_,
-            currentY_,
-            currentZ_,
+            placement->x,
+            shelf.y,
+            layer.z,
             _width,
             _height,
             _targetWidth,
             _targetHeight,
-            static_cast<float>(currentX_) / static_cast<float>(width_),
-            static_cast<float>(currentY_) / static_cast<float>(height_),
+            static_cast<float>(placement->x) / static_cast<float>(width_),
+            static_cast<float>(shelf.y) / static_cast<float>(height_),
             static_cast<float>(_width) / static_cast<float>(width_),
             static_cast<float>(_height) / static_cast<float>(height_),
             _user
         });
-
-        currentX_ += _width;
-
-        if (_height > maxTextureHeightInCurrentRow_)
-            maxTextureHeightInCurrentRow_ = _height;
-
-        TextureInfo const& info = textureInfos_.back();
+        Slot& slot = slots_[index];
+        slot.shelf = placement->shelf;
+        slot.listener = _listener;
+        slot.evictable = _evictable;
+        slot.used = true;
+        slot.lastUsed = frame_;
+        if (_evictable)
+            linkFront(index);
 
         commandListener_.uploadTexture(UploadTexture{
-            std::ref(info),
+            std::ref(static_cast<TextureInfo const&>(slot)),
             std::move(_data),
             _format
         });
 
-        return &info;
+        return &slot;
     }
 
+    /// Removes the given texture, which must have been returned by insert(), from the atlas.
+    void release(TextureInfo const& _texture)
+    {
+        releaseSlot(slotIndex(_texture));
+    }
+
+    /// Marks the given texture as used in the current frame, protecting it from eviction
+    /// until the next frame.
+    void touch(TextureInfo const& _texture)
+    {
+        auto const index = slotIndex(_texture);
+        Slot& slot = slots_[index];
+        slot.lastUsed = frame_;
+        if (slot.evictable && lruHead_ != index)
+        {
+            unlink(index);
+            linkFront(index);
+        }
+    }
+
+    /// Starts a new frame, once the render commands of the current one have been executed.
+    void nextFrame() noexcept { ++frame_; }
+
   private:
-    constexpr bool advanceY()
+    static constexpr unsigned npos = std::numeric_limits<unsigned>::max();
+
+    /// A free range within a shelf.
+    struct Region {
+        unsigned x;
+        unsigned width;
+    };
+
+    /// A row of textures on a layer.
+    struct Shelf {
+        unsigned layer = 0;                 // index into layers_
+        unsigned y = 0;
+        unsigned height = 0;
+        unsigned end = 0;                   // x-offset past the right-most texture
+        unsigned textureCount = 0;
+        std::vector<Region> free = {};      // free space left of end, ordered by x and never adjacent
+
+        /// @return the x-offset of the first free space of at least the given width, if any.
+        std::optional<unsigned> fit(unsigned _width, unsigned _atlasWidth) const noexcept
+        {
+            for (Region const& region : free)
+                if (region.width >= _width)
+                    return region.x;
+
+            if (end + _width <= _atlasWidth)
+                return end;
+
+            return std::nullopt;
+        }
+
+        void allocate(unsigned _x, unsigned _width)
+        {
+            ++textureCount;
+            if (_x == end)
+            {
+                end += _width;
+                return;
+            }
+
+            auto region = std::find_if(free.begin(), free.end(), [&](Region const& r) { return r.x == _x; });
+            assert(region != free.end() && region->width >= _width);
+            region->x += _width;
+            region->width -= _width;
+            if (region->width == 0)
+                free.erase(region);
+        }
+
+        void deallocate(unsigned _x, unsigned _width)
+        {
+            --textureCount;
+            if (textureCount == 0)
+            {
+                end = 0;
+                free.clear();
+                return;
+            }
+
+            if (_width == 0)
+                return;
+
+            if (_x + _width == end)
+            {
+                end = _x;
+                if (!free.empty() && free.back().x + free.back().width == end)
+                {
+                    end = free.back().x;
+                    free.pop_back();
+                }
+                return;
+            }
+
+            auto next = std::find_if(free.begin(), free.end(), [&](Region const& r) { return r.x > _x; });
+            auto const mergesWithPrevious = next != free.begin() && std::prev(next)->x + std::prev(next)->width == _x;
+            auto const mergesWithNext = next != free.end() && _x + _width == next->x;
+
+            if (mergesWithPrevious && mergesWithNext)
+            {
+                std::prev(next)->width += _width + next->width;
+                free.erase(next);
+            }
+            else if (mergesWithPrevious)
+                std::prev(next)->width += _width;
+            else if (mergesWithNext)
+            {
+                next->x = _x;
+                next->width += _width;
+            }
+            else
+                free.insert(next, Region{_x, _width});
+        }
+    };
+
+    /// A 2D layer of a 3D texture atlas.
+    struct Layer {
+        unsigned instance;
+        unsigned z;
+        std::vector<unsigned> shelves = {}; // indices into shelves_, from bottom to top
+
+        unsigned top(std::vector<Shelf> const& _shelves) const noexcept
+        {
+            return shelves.empty() ? 0 : _shelves[shelves.back()].y + _shelves[shelves.back()].height;
+        }
+    };
+
+    struct Slot : public TextureInfo {
+        unsigned index = 0;                 // index into slots_
+        unsigned shelf = 0;                 // index into shelves_
+        EvictionListener* listener = nullptr;
+        bool evictable = false;
+        bool used = false;
+        uint64_t lastUsed = 0;              // frame the texture was last used in
+        unsigned prev = npos;               // more recently used evictable texture
+        unsigned next = npos;               // less recently used evictable texture
+    };
+
+    struct Placement {
+        unsigned shelf;
+        unsigned x;
+    };
+
+    unsigned slotIndex(TextureInfo const& _texture) const noexcept
+    {
+        auto const index = static_cast<Slot const&>(_texture).index;
+        assert(index < slots_.size() && &slots_[index] == &_texture && slots_[index].used);
+        return index;
+    }
+
+    /// Finds space for a texture, preferring a shelf of about its height over a new shelf,
+    /// and a new shelf over a shelf wasting more space.
+    std::optional<Placement> findPlacement(unsigned _width, unsigned _height)
+    {
+        if (auto placement = findShelf(_width, _height, _height + _height / 2); placement.has_value())
+            return placement;
+
+        if (auto placement = addShelf(_height); placement.has_value())
+            return placement;
+
+        return findShelf(_width, _height, height_);
+    }
+
+    std::optional<Placement> findShelf(unsigned _width, unsigned _minHeight, unsigned _maxHeight) const
     {
-        if (currentY_ + maxTextureHeightInCurrentRow_ <= height_)
+        auto best = std::optional<Placement>{};
+        auto bestHeight = npos;
+        for (Layer const& layer : layers_)
         {
-            currentY_ += maxTextureHeightInCurrentRow_;
-            currentX_ = 0;
-            maxTextureHeightInCurrentRow_ = 0;
-            return true;
+            for (unsigned const index : layer.shelves)
+            {
+                Shelf const& shelf = shelves_[index];
+                if (shelf.height < _minHeight || shelf.height > _maxHeight || shelf.height >= bestHeight)
+                    continue;
+
+                if (auto const x = shelf.fit(_width, width_); x.has_value())
+                {
+                    best = Placement{index, *x};
+                    bestHeight = shelf.height;
+                }
+            }
         }
-        else
-            return advanceZ();
+        return best;
     }
 
-    constexpr bool advanceZ()
+    std::optional<Placement> addShelf(unsigned _height)
     {
-        if (currentZ_ < depth_)
+        auto layerIndex = npos;
+        for (unsigned i = 0; i < layers_.size() && layerIndex == npos; ++i)
+            if (layers_[i].top(shelves_) + _height <= height_)
+                layerIndex = i;
+
+        if (layerIndex == npos)
+        {
+            if (!addLayer())
+                return std::nullopt;
+            layerIndex = static_cast<unsigned>(layers_.size() - 1);
+        }
+
+        Layer& layer = layers_[layerIndex];
+        auto index = npos;
+        if (!freeShelves_.empty())
         {
-            currentZ_++;
-            currentY_ = 0;
-            currentX_ = 0;
-            maxTextureHeightInCurrentRow_ = 0;
-            return true;
+            index = freeShelves_.back();
+            freeShelves_.pop_back();
         }
         else
-            return advanceInstance();
+        {
+            index = static_cast<unsigned>(shelves_.size());
+            shelves_.emplace_back();
+        }
+
+        shelves_[index] = Shelf{layerIndex, layer.top(shelves_), _height};
+        layer.shelves.push_back(index);
+
+        return Placement{index, 0};
     }
 
-    constexpr bool advanceInstance()
+    bool addLayer()
     {
-        if (currentInstanceId_ < instanceBaseId_ + maxInstances_)
+        if (layers_.size() == static_cast<size_t>(maxInstances_) * depth_)
+            return false;
+
+        auto const index = static_cast<unsigned>(layers_.size());
+        layers_.emplace_back(Layer{instanceBaseId_ + index / depth_, index % depth_});
+
+        if (index % depth_ == 0)
+            notifyCreateAtlas(layers_.back().instance);
+
+        return true;
+    }
+
+    unsigned allocateSlot(TextureInfo const& _info)
+    {
+        if (!freeSlots_.empty())
+        {
+            auto const index = freeSlots_.back();
+            freeSlots_.pop_back();
+            static_cast<TextureInfo&>(slots_[index]) = _info;
+            return index;
+        }
+
+        auto const index = static_cast<unsigned>(slots_.size());
+        slots_.emplace_back(Slot{_info, index});
+        return index;
+    }
+
+    void evict(unsigned _index)
+    {
+        ++evictions_;
+        if (EvictionListener* listener = slots_[_index].listener; listener != nullptr)
+            listener->textureEvicted(slots_[_index]);
+        releaseSlot(_index);
+    }
+
+    void releaseSlot(unsigned _index)
+    {
+        Slot& slot = slots_[_index];
+        if (slot.evictable)
+            unlink(_index);
+
+        Shelf& shelf = shelves_[slot.shelf];
+        shelf.deallocate(slot.x, slot.width);
+
+        // Drop empty shelves at the top of the layer, making their space available to any height.
+        if (shelf.textureCount == 0)
         {
-            currentInstanceId_++;
-            currentZ_ = 0;
-            currentY_ = 0;
-            currentX_ = 0;
-            maxTextureHeightInCurrentRow_ = 0;
-
-            notifyCreateAtlas();
-            return true;
+            Layer& layer = layers_[shelf.layer];
+            while (!layer.shelves.empty() && shelves_[layer.shelves.back()].textureCount == 0)
+            {
+                freeShelves_.push_back(layer.shelves.back());
+                layer.shelves.pop_back();
+            }
         }
+
+        slot.used = false;
+        slot.listener = nullptr;
+        slot.evictable = false;
+        freeSlots_.push_back(_index);
+    }
+
+    void unlink(unsigned _index) noexcept
+    {
+        Slot& slot = slots_[_index];
+        if (slot.prev != npos)
+            slots_[slot.prev].next = slot.next;
         else
-            return false;
+            lruHead_ = slot.next;
+
+        if (slot.next != npos)
+            slots_[slot.next].prev = slot.prev;
+        else
+            lruTail_ = slot.prev;
+
+        slot.prev = npos;
+        slot.next = npos;
+    }
+
+    void linkFront(unsigned _index) noexcept
+    {
+        Slot& slot = slots_[_index];
+        slot.prev = npos;
+        slot.next = lruHead_;
+        if (lruHead_ != npos)
+            slots_[lruHead_].prev = _index;
+        lruHead_ = _index;
+        if (lruTail_ == npos)
+            lruTail_ = _index;
     }
 
-    void notifyCreateAtlas()
+    void notifyCreateAtlas(unsigned _instanceId)
     {
         commandListener_.createAtlas({
-            currentInstanceId_,
+            _instanceId,
             name_,
             width_,
             height_,
@@ -317,20 +617,26 @@ class TextureAtlasAllocator {
     std::string const name_;            // atlas human readable name (only for debugging)
     CommandListener& commandListener_;  // atlas event listener (used to perform allocation/modification actions)
 
-    unsigned currentInstanceId_;        // (OpenGL) texture count already in use
-    unsigned currentZ_ = 0;             // index to current atlas that is being filled
-    unsigned currentX_ = 0;             // current X-offset to start drawing to
-    unsigned currentY_ = 0;             // current Y-offset to start drawing to
-    unsigned maxTextureHeightInCurrentRow_ = 0; // current maximum height in the current row (used to increment currentY_ to get to the next row)
+    std::vector<Layer> layers_;         // layers in use, in order of instance and z
+    std::vector<Shelf> shelves_;        // shelves of all layers
+    std::vector<unsigned> freeShelves_; // indices of unused entries in shelves_
+    std::deque<Slot> slots_;            // textures, deque'd to keep the TextureInfo references stable
+    std::vector<unsigned> freeSlots_;   // indices of unused entries in slots_
 
-    std::list<TextureInfo> textureInfos_;
+    unsigned lruHead_ = npos;           // most recently used evictable texture
+    unsigned lruTail_ = npos;           // least recently used evictable texture
+    uint64_t frame_ = 0;
+    uint64_t evictions_ = 0;
 };
 
 template <typename Key, typename Metadata = int>
-class MetadataTextureAtlas {
+class MetadataTextureAtlas : private EvictionListener {
   public:
-    explicit MetadataTextureAtlas(TextureAtlasAllocator& _allocator) :
-        atlas_{ _allocator }
+    /// @param _evictable whether or not the textures may be evicted when running out of space,
+    ///                   for textures that can be recreated on demand, such as glyphs.
+    explicit MetadataTextureAtlas(TextureAtlasAllocator& _allocator, bool _evictable = false) :
+        atlas_{ _allocator },
+        evictable_{ _evictable }
     {
     }
 
@@ -339,6 +645,11 @@ class MetadataTextureAtlas {
     MetadataTextureAtlas(MetadataTextureAtlas&&) = delete; // TODO
     MetadataTextureAtlas& operator=(MetadataTextureAtlas&&) = delete; // TODO
 
+    ~MetadataTextureAtlas() override
+    {
+        clear();
+    }
+
     //std::string const& name() const noexcept { return name_; }
     constexpr unsigned maxInstances() const noexcept { return atlas_.maxInstances(); }
     constexpr unsigned depth() const noexcept { return atlas_.depth(); }
@@ -346,24 +657,28 @@ class MetadataTextureAtlas {
     constexpr unsigned height() const noexcept { return atlas_.height(); }
 
     /// @return number of textures stored in this texture atlas.
-    constexpr size_t size() const noexcept { return allocations_.size(); }
+    size_t size() const noexcept { return allocations_.size(); }
 
     /// @return boolean indicating whether or not this atlas is empty (has no textures present).
-    constexpr bool empty() const noexcept { return allocations_.size() == 0; }
+    bool empty() const noexcept { return allocations_.empty(); }
 
     TextureAtlasAllocator& allocator() noexcept { return atlas_; }
     TextureAtlasAllocator const& allocator() const noexcept { return atlas_; }
 
-    /// Clears userdata, if the TextureAtlasAllocator has to be cleared too, that has to be done
-    /// explicitly.
+    /// Removes all textures of this atlas from the TextureAtlasAllocator.
     void clear()
     {
+        for (auto const& [texture, key] : keys_)
+        {
+            (void) key;
+            atlas_.release(*texture);
+        }
         allocations_.clear();
-        metadata_.clear();
+        keys_.clear();
     }
 
     /// Tests whether given sub-texture is being present in this texture atlas.
-    constexpr bool contains(Key const& _id) const
+    bool contains(Key const& _id) const
     {
         return allocations_.find(_id) != allocations_.end();
     }
@@ -396,37 +711,52 @@ class MetadataTextureAtlas {
     {
         assert(allocations_.find(_id) == allocations_.end());
 
-        TextureInfo const* textureInfo = atlas_.insert(_width, _height, _targetWidth, _targetHeight, _format, std::move(_data), _user);
+        TextureInfo const* textureInfo = atlas_.insert(_width, _height, _targetWidth, _targetHeight, _format,
+                                                       std::move(_data), _user, this, evictable_);
         if (!textureInfo)
             return std::nullopt;
 
-        allocations_.emplace(std::pair{_id, std::ref(*textureInfo)});
-
-        if constexpr (!std::is_same_v<Metadata, void>)
-            metadata_.emplace(std::pair{_id, std::move(_metadata)});
+        allocations_.emplace(_id, Allocation{textureInfo, std::move(_metadata)});
+        keys_.emplace(textureInfo, _id);
 
         return get(_id);
     }
 
     /// Retrieves TextureInfo and Metadata tuple if available, std::nullopt otherwise.
-    [[nodiscard]] std::optional<DataRef> get(Key const& _id) const
+    ///
+    /// The texture is marked as used in the current frame, protecting it from eviction.
+    [[nodiscard]] std::optional<DataRef> get(Key const& _id)
     {
         if (auto const i = allocations_.find(_id); i != allocations_.end())
-            return DataRef{std::ref(i->second), std::ref(metadata_.at(_id))};
+        {
+            atlas_.touch(*i->second.texture);
+            return DataRef{std::cref(*i->second.texture), std::cref(i->second.metadata)};
+        }
         else
             return std::nullopt;
     }
 
   private:
-    TextureAtlasAllocator& atlas_;
-
-    std::map<Key, TextureInfo> allocations_ = {};
+    void textureEvicted(TextureInfo const& _texture) override
+    {
+        if (auto const i = keys_.find(&_texture); i != keys_.end())
+        {
+            allocations_.erase(i->second);
+            keys_.erase(i);
+        }
+    }
 
     // conditionally transform void to int as I can't conditionally enable/disable this member var.
-    std::map<
-        Key,
-        std::conditional_t<std::is_same_v<Metadata, void>, int, Metadata>
-    > metadata_ = {};
+    struct Allocation {
+        TextureInfo const* texture;
+        std::conditional_t<std::is_same_v<Metadata, void>, int, Metadata> metadata;
+    };
+
+    TextureAtlasAllocator& atlas_;
+    bool const evictable_;
+
+    std::unordered_map<Key, Allocation> allocations_ = {};
+    std::unordered_map<TextureInfo const*, Key> keys_ = {};
 };
 
 } // end namespace
@@ -521,11 +851,12 @@ namespace fmt { // {{{
         template <typename FormatContext>
         auto format(crispy::atlas::TextureAtlasAllocator const& _atlas, FormatContext& ctx)
         {
-            return format_to(ctx.out(), "TextureAtlasAllocator<instance: {}/{}, dim: {}x{}x{}, at: {}x{}x{}, rowHeight:{}>",
-                _atlas.currentInstance(), _atlas.maxInstances(),
+            return format_to(ctx.out(), "TextureAtlasAllocator<instances: {}/{}, dim: {}x{}x{}, textures: {}, shelves: {}, evictions: {}>",
+                _atlas.instanceCount(), _atlas.maxInstances(),
                 _atlas.width(), _atlas.height(), _atlas.depth(),
-                _atlas.currentX(), _atlas.currentY(), _atlas.currentZ(),
-                _atlas.maxTextureHeightInCurrentRow()
+                _atlas.size(),
+                _atlas.shelfCount(),
+                _atlas.evictions()
             );
         }
     };
@@ -0,0 +1,161 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <crispy/Atlas.h>
+
+#include <QtGui/QVector4D>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace crispy::atlas {
+
+/// RGBA color with 8 bits per channel, as uploaded to the GPU.
+using PackedColor = std::array<uint8_t, 4>;
+
+/// Converts a color of floating point components between 0.0 and 1.0 to a PackedColor.
+inline PackedColor packColor(QVector4D const& _color) noexcept
+{
+    auto const pack = [](float _value) {
+        return static_cast<uint8_t>(std::lround(std::clamp(_value, 0.0f, 1.0f) * 255.0f));
+    };
+    return PackedColor{pack(_color[0]), pack(_color[1]), pack(_color[2]), pack(_color[3])};
+}
+
+/// Clamps a window coordinate to the range of an instance coordinate.
+constexpr int16_t toInstanceCoordinate(int _value) noexcept
+{
+    return static_cast<int16_t>(std::clamp(_value,
+                                           int{std::numeric_limits<int16_t>::min()},
+                                           int{std::numeric_limits<int16_t>::max()}));
+}
+
+/// Clamps a size in pixels to the range of an instance size.
+constexpr uint16_t toInstanceSize(unsigned _value) noexcept
+{
+    return static_cast<uint16_t>(std::min(_value, unsigned{std::numeric_limits<uint16_t>::max()}));
+}
+
+/// Instance record of a texture being rendered, which the vertex shader expands into a quad.
+///
+/// This replaces 6 vertices of 11 floats each per rendered texture.
+struct TextureInstance {
+    int16_t x;                      // window x coordinate to render the texture to
+    int16_t y;                      // window y coordinate to render the texture to
+    uint16_t width;                 // width of the texture when being rendered
+    uint16_t height;                // height of the texture when being rendered
+    float relativeX;                // atlas coordinates, relative to the atlas size
+    float relativeY;
+    float relativeWidth;
+    float relativeHeight;
+    uint16_t z;                     // atlas layer
+    uint16_t user;                  // TextureInfo::user, such as whether or not the texture is colored
+    PackedColor color;
+};
+
+static_assert(sizeof(TextureInstance) == 32);
+
+inline TextureInstance makeTextureInstance(RenderTexture const& _render) noexcept
+{
+    TextureInfo const& texture = _render.texture.get();
+    return TextureInstance{
+        toInstanceCoordinate(_render.x),
+        toInstanceCoordinate(_render.y),
+        toInstanceSize(texture.targetWidth),
+        toInstanceSize(texture.targetHeight),
+        texture.relativeX,
+        texture.relativeY,
+        texture.relativeWidth,
+        texture.relativeHeight,
+        static_cast<uint16_t>(texture.z),
+        static_cast<uint16_t>(texture.user),
+        packColor(_render.color)
+    };
+}
+
+/// Instance record of a filled rectangle, such as the background of a range of cells,
+/// which the vertex shader expands into a quad.
+struct RectangleInstance {
+    int16_t x;
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
+    PackedColor color;
+};
+
+static_assert(sizeof(RectangleInstance) == 12);
+
+inline RectangleInstance makeRectangleInstance(int _x, int _y, unsigned _width, unsigned _height,
+                                               QVector4D const& _color) noexcept
+{
+    return RectangleInstance{
+        toInstanceCoordinate(_x),
+        toInstanceCoordinate(_y),
+        toInstanceSize(_width),
+        toInstanceSize(_height),
+        packColor(_color)
+    };
+}
+
+/// Invokes @p _update with the offset and count of each range of @p _current instances that
+/// differ from @p _previous, such as to upload only those that changed since the last frame.
+///
+/// Ranges separated by less than @p _minGap equal instances are merged into one.
+/// Instances beyond the end of @p _previous are considered changed.
+template <typename Instance, typename Callback>
+void forEachChangedRange(std::vector<Instance> const& _previous,
+                         std::vector<Instance> const& _current,
+                         size_t _minGap,
+                         Callback _update)
+{
+    static_assert(std::is_trivially_copyable_v<Instance>);
+
+    auto const equal = [&](size_t i) {
+        return i < _previous.size() && std::memcmp(&_previous[i], &_current[i], sizeof(Instance)) == 0;
+    };
+
+    auto i = size_t{0};
+    while (i < _current.size())
+    {
+        while (i < _current.size() && equal(i))
+            ++i;
+        if (i == _current.size())
+            break;
+
+        auto const begin = i;
+        auto end = i + 1;
+        for (auto equalCount = size_t{0}; end + equalCount < _current.size(); )
+        {
+            if (!equal(end + equalCount))
+            {
+                end += equalCount + 1;
+                equalCount = 0;
+            }
+            else if (++equalCount >= _minGap)
+                break;
+        }
+
+        _update(begin, end - begin);
+        i = end;
+    }
+}
+
+} // end namespace
@@ -0,0 +1,117 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/AtlasInstance.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace crispy::atlas;
+
+TEST_CASE("AtlasInstance.packColor", "[atlas]")
+{
+    CHECK(packColor(QVector4D(0.0f, 1.0f, 0.5f, 1.0f)) == PackedColor{0, 255, 128, 255});
+    CHECK(packColor(QVector4D(-1.0f, 2.0f, 0.2f, 0.0f)) == PackedColor{0, 255, 51, 0});
+}
+
+TEST_CASE("AtlasInstance.texture", "[atlas]")
+{
+    auto const name = string("atlas");
+    auto const texture = TextureInfo{1, name, 64, 32, 3, 10, 20, 20, 40, 0.25f, 0.125f, 0.0390625f, 0.078125f, 1};
+
+    auto const instance = makeTextureInstance(RenderTexture{texture, -5, 700, 0, QVector4D(1.0f, 0.0f, 0.0f, 1.0f)});
+    CHECK(instance.x == -5);
+    CHECK(instance.y == 700);
+    CHECK(instance.width == 20);
+    CHECK(instance.height == 40);
+    CHECK(instance.relativeX == 0.25f);
+    CHECK(instance.relativeY == 0.125f);
+    CHECK(instance.relativeWidth == 0.0390625f);
+    CHECK(instance.relativeHeight == 0.078125f);
+    CHECK(instance.z == 3);
+    CHECK(instance.user == 1);
+    CHECK(instance.color == PackedColor{255, 0, 0, 255});
+
+    // Positions out of range are clamped rather than wrapped around.
+    auto const outside = makeTextureInstance(RenderTexture{texture, 40000, -40000, 0, QVector4D()});
+    CHECK(outside.x == 32767);
+    CHECK(outside.y == -32768);
+}
+
+TEST_CASE("AtlasInstance.rectangle", "[atlas]")
+{
+    auto const instance = makeRectangleInstance(80, 16, 640, 70000, QVector4D(0.0f, 0.0f, 1.0f, 0.5f));
+    CHECK(instance.x == 80);
+    CHECK(instance.y == 16);
+    CHECK(instance.width == 640);
+    CHECK(instance.height == 65535);
+    CHECK(instance.color == PackedColor{0, 0, 255, 128});
+}
+
+TEST_CASE("AtlasInstance.forEachChangedRange", "[atlas]")
+{
+    auto const changedRanges = [](vector<int> const& _previous, vector<int> const& _current, size_t _minGap) {
+        auto ranges = vector<pair<size_t, size_t>>{};
+        forEachChangedRange(_previous, _current, _minGap, [&](size_t _offset, size_t _count) {
+            ranges.emplace_back(_offset, _count);
+        });
+        return ranges;
+    };
+    using Ranges = vector<pair<size_t, size_t>>;
+
+    auto const previous = vector<int>{1, 2, 3, 4, 5, 6, 7, 8};
+
+    CHECK(changedRanges(previous, previous, 1).empty());
+    CHECK(changedRanges(previous, {1, 2, 3}, 1).empty());
+    CHECK(changedRanges({}, {1, 2, 3}, 1) == Ranges{{0, 3}});
+
+    auto const current = vector<int>{1, 0, 3, 0, 5, 6, 7, 0, 9, 10};
+    CHECK(changedRanges(previous, current, 1) == Ranges{{1, 1}, {3, 1}, {7, 3}});
+    CHECK(changedRanges(previous, current, 2) == Ranges{{1, 3}, {7, 3}});
+    CHECK(changedRanges(previous, current, 4) == Ranges{{1, 9}});
+}
+
+TEST_CASE("AtlasInstance.forEachChangedRange.blinkingCursor", "[atlas]")
+{
+    auto const name = string("atlas");
+    auto const glyph = TextureInfo{0, name, 0, 0, 0, 10, 20, 10, 20, 0.0f, 0.0f, 0.15625f, 0.625f, 0};
+    auto const cursor = TextureInfo{0, name, 10, 0, 0, 10, 20, 10, 20, 0.15625f, 0.0f, 0.15625f, 0.625f, 0};
+
+    // The cursor takes the first instance of a frame, followed by the glyphs of all rows.
+    auto const frame = [&](bool _cursorVisible) {
+        auto instances = vector<TextureInstance>{};
+        if (_cursorVisible)
+            instances.emplace_back(makeTextureInstance(RenderTexture{cursor, 0, 0, 0, QVector4D(1, 1, 1, 1)}));
+        else
+            instances.emplace_back(TextureInstance{});
+        for (int row = 0; row < 24; ++row)
+            for (int column = 0; column < 80; ++column)
+                instances.emplace_back(makeTextureInstance(RenderTexture{glyph, column * 10, row * 20, 0, QVector4D(1, 1, 1, 1)}));
+        return instances;
+    };
+
+    auto ranges = vector<pair<size_t, size_t>>{};
+    auto const collect = [&](size_t _offset, size_t _count) { ranges.emplace_back(_offset, _count); };
+
+    // Blinking the cursor off and on again uploads nothing but the cursor's instance.
+    forEachChangedRange(frame(true), frame(false), 16, collect);
+    CHECK(ranges == vector<pair<size_t, size_t>>{{0, 1}});
+
+    ranges.clear();
+    forEachChangedRange(frame(false), frame(true), 16, collect);
+    CHECK(ranges == vector<pair<size_t, size_t>>{{0, 1}});
+}
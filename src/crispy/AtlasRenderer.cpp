@@ -13,12 +13,14 @@
  */
 #include <crispy/AtlasRenderer.h>
 #include <crispy/Atlas.h>
+#include <crispy/AtlasInstance.h>
 #include <crispy/algorithm.h>
 
 #include <QtGui/QOpenGLExtraFunctions>
 #include <QtGui/QOpenGLTexture>
 
 #include <algorithm>
+#include <cstddef>
 #include <iostream>
 
 using namespace std;
@@ -32,9 +34,7 @@ struct Renderer::ExecutionScheduler : public CommandListener
 {
     std::vector<CreateAtlas> createAtlases;
     std::vector<UploadTexture> uploadTextures;
-    std::vector<RenderTexture> renderTextures;
-    std::vector<GLfloat> buffer;
-    GLsizei vertexCount = 0;
+    std::vector<TextureInstance> instances;
     std::vector<DestroyAtlas> destroyAtlases;
 
     void createAtlas(CreateAtlas const& _atlas) override
@@ -49,45 +49,7 @@ struct Renderer::ExecutionScheduler : public CommandListener
 
     void renderTexture(RenderTexture const& _render) override
     {
-        renderTextures.emplace_back(_render);
-
-        // Vertices
-        GLfloat const x = _render.x;
-        GLfloat const y = _render.y;
-        GLfloat const z = _render.z;
-      //GLfloat const w = _render.w;
-        GLfloat const r = _render.texture.get().targetWidth;
-        GLfloat const s = _render.texture.get().targetHeight;
-
-        // TexCoords
-        GLfloat const rx = _render.texture.get().relativeX;
-        GLfloat const ry = _render.texture.get().relativeY;
-        GLfloat const w = _render.texture.get().relativeWidth;
-        GLfloat const h = _render.texture.get().relativeHeight;
-        GLfloat const i = _render.texture.get().z;
-        GLfloat const u = _render.texture.get().user;
-
-        // color
-        GLfloat const cr = _render.color[0];
-        GLfloat const cg = _render.color[1];
-        GLfloat const cb = _render.color[2];
-        GLfloat const ca = _render.color[3];
-
-        GLfloat const vertices[6 * 11] = {
-            // first triangle
-        // <X      Y      Z> <X       Y       I  U>  <R   G   B   A>
-            x,     y + s, z,  rx,     ry,     i, u,  cr, cg, cb, ca,
-            x,     y,     z,  rx,     ry + h, i, u,  cr, cg, cb, ca,
-            x + r, y,     z,  rx + w, ry + h, i, u,  cr, cg, cb, ca,
-
-            // second triangle
-            x,     y + s, z,  rx,     ry,     i, u,  cr, cg, cb, ca,
-            x + r, y,     z,  rx + w, ry + h, i, u,  cr, cg, cb, ca,
-            x + r, y + s, z,  rx + w, ry,     i, u,  cr, cg, cb, ca,
-        };
-
-        copy(vertices, back_inserter(buffer));
-        vertexCount += 6;
+        instances.emplace_back(makeTextureInstance(_render));
     }
 
     void destroyAtlas(DestroyAtlas const& _atlas) override
@@ -99,7 +61,7 @@ struct Renderer::ExecutionScheduler : public CommandListener
     {
         return createAtlases.size()
              + uploadTextures.size()
-             + renderTextures.size()
+             + instances.size()
              + destroyAtlases.size();
     }
 
@@ -107,10 +69,8 @@ struct Renderer::ExecutionScheduler : public CommandListener
     {
         createAtlases.clear();
         uploadTextures.clear();
-        renderTextures.clear();
         destroyAtlases.clear();
-        buffer.clear();
-        vertexCount = 0;
+        instances.clear();
     }
 };
 
@@ -124,35 +84,30 @@ Renderer::Renderer() :
     glGenVertexArrays(1, &vao_);
     glBindVertexArray(vao_);
 
-    auto constexpr BufferStride = (3 + 4 + 4) * sizeof(GLfloat);
-    auto constexpr VertexOffset = (void const*) 0;
-    auto const TexCoordOffset = (void const*) (3 * sizeof(GLfloat));
-    auto const ColorOffset = (void const*) (7 * sizeof(GLfloat));
-
     glGenBuffers(1, &vbo_);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, 0/* sizeof(GLfloat) * 6 * 11 * 200 * 100*/, nullptr, GL_STREAM_DRAW);
-
-    // 0 (vec3): vertex buffer
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, BufferStride, VertexOffset);
-    glEnableVertexAttribArray(0);
-
-    // 1 (vec3): texture coordinates buffer
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, BufferStride, TexCoordOffset);
-    glEnableVertexAttribArray(1);
-
-    // 2 (vec4): color buffer
-    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, BufferStride, ColorOffset);
-    glEnableVertexAttribArray(2);
-
-    // setup EBO
-    // glGenBuffers(1, &ebo_);
-    // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-    // static const GLuint indices[6] = { 0, 1, 3, 1, 2, 3 };
-    // glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // TODO: later for instanced rendering
-    //glVertexAttribDivisor(0, 1);
+    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
+
+    // Each texture is one instance, expanded into a quad by the vertex shader.
+    auto constexpr Stride = sizeof(TextureInstance);
+    auto const offset = [](size_t _offset) { return reinterpret_cast<void const*>(_offset); };
+
+    // 0 (vec2): target position
+    glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, Stride, offset(offsetof(TextureInstance, x)));
+    // 1 (vec2): target size
+    glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_FALSE, Stride, offset(offsetof(TextureInstance, width)));
+    // 2 (vec4): atlas coordinates
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, Stride, offset(offsetof(TextureInstance, relativeX)));
+    // 3 (vec2): atlas layer and user value
+    glVertexAttribPointer(3, 2, GL_UNSIGNED_SHORT, GL_FALSE, Stride, offset(offsetof(TextureInstance, z)));
+    // 4 (vec4): color
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, Stride, offset(offsetof(TextureInstance, color)));
+
+    for (GLuint location = 0; location <= 4; ++location)
+    {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
 }
 
 Renderer::~Renderer()
@@ -162,7 +117,6 @@ Renderer::~Renderer()
 
     glDeleteVertexArrays(1, &vao_);
     glDeleteBuffers(1, &vbo_);
-    //glDeleteBuffers(1, &ebo_);
 }
 
 CommandListener& Renderer::scheduler() noexcept
@@ -170,6 +124,11 @@ CommandListener& Renderer::scheduler() noexcept
     return *scheduler_;
 }
 
+std::vector<TextureInstance>& Renderer::instances() noexcept
+{
+    return scheduler_->instances;
+}
+
 unsigned Renderer::maxTextureDepth()
 {
     GLint value;
@@ -212,31 +171,21 @@ void Renderer::execute()
     for (UploadTexture const& params : scheduler_->uploadTextures)
         uploadTexture(params);
 
-    // order and prepare texture geometry
-    sort(scheduler_->renderTextures.begin(),
-         scheduler_->renderTextures.end(),
-         [](RenderTexture const& a, RenderTexture const& b) { return a.texture.get().atlas < b.texture.get().atlas; });
-
-    for (RenderTexture const& params : scheduler_->renderTextures)
-        renderTexture(params);
-
-    // upload vertices and render (iff there is anything to render)
-    if (!scheduler_->renderTextures.empty())
+    // upload instances and render (iff there is anything to render)
+    if (!scheduler_->instances.empty())
     {
-        glBindVertexArray(vao_);
+        // The instances of a single draw call may refer to any atlas, so all of them are bound.
+        for (auto const& [key, textureId] : atlasMap_)
+        {
+            selectTextureUnit(key.atlasTexture);
+            bindTexture2DArray(textureId);
+        }
 
-        // upload buffer
+        glBindVertexArray(vao_);
         glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-        glBufferData(GL_ARRAY_BUFFER,
-                     scheduler_->buffer.size() * sizeof(GLfloat),
-                     scheduler_->buffer.data(),
-                     GL_STREAM_DRAW);
+        uploadInstances();
 
-        glDrawArrays(GL_TRIANGLES, 0, scheduler_->vertexCount);
-
-        // TODO: Instead of on glDrawArrays (and many if's in the shader for each GL_TEXTUREi),
-        //       make a loop over each GL_TEXTUREi and draw a sub range of the vertices and a
-        //       fixed GL_TEXTURE0. - will this be noticable faster?
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(scheduler_->instances.size()));
     }
 
     // destroy any pending atlases that were meant to be destroyed
@@ -249,6 +198,29 @@ void Renderer::execute()
     currentTextureId_ = std::numeric_limits<GLuint>::max();
 }
 
+void Renderer::uploadInstances()
+{
+    auto const& instances = scheduler_->instances;
+
+    if (instances.size() > bufferCapacity_)
+    {
+        bufferCapacity_ = max(instances.size(), 2 * bufferCapacity_);
+        glBufferData(GL_ARRAY_BUFFER, bufferCapacity_ * sizeof(TextureInstance), nullptr, GL_DYNAMIC_DRAW);
+        uploadedInstances_.clear();
+    }
+
+    // Only upload what differs from the previous frame, which is little to nothing
+    // for mostly unchanged screens, as the instances of unchanged rows are reused as is.
+    forEachChangedRange(uploadedInstances_, instances, 16, [&](size_t _offset, size_t _count) {
+        glBufferSubData(GL_ARRAY_BUFFER,
+                        static_cast<GLintptr>(_offset * sizeof(TextureInstance)),
+                        static_cast<GLsizeiptr>(_count * sizeof(TextureInstance)),
+                        instances.data() + _offset);
+    });
+
+    uploadedInstances_ = instances;
+}
+
 void Renderer::createAtlas(CreateAtlas const& _atlas)
 {
     GLuint textureId{};
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <crispy/Atlas.h>
+#include <crispy/AtlasInstance.h>
 
 #include <QtGui/QMatrix4x4>
 #include <QtGui/QOpenGLExtraFunctions>
@@ -22,6 +23,7 @@
 #include <limits>
 #include <algorithm>
 #include <memory>
+#include <vector>
 
 namespace crispy::atlas {
 
@@ -49,6 +51,11 @@ class Renderer : public QOpenGLExtraFunctions, public CommandListener {
     /// @return an interface to be used to schedule render commands.
     CommandListener& scheduler() noexcept;
 
+    /// @return the instances scheduled for rendering so far, in the order they were scheduled.
+    ///
+    /// Instances may be appended directly, such as those kept from a previous frame.
+    std::vector<TextureInstance>& instances() noexcept;
+
     /// Executes all prepared pending commands in proper order.
     ///
     /// First, schedule commands in order to prepare and fill command queue, then execute.
@@ -63,13 +70,18 @@ class Renderer : public QOpenGLExtraFunctions, public CommandListener {
     void renderTexture(RenderTexture const& _render) override;
     void destroyAtlas(DestroyAtlas const& _atlas) override;
 
+    void uploadInstances();
     void selectTextureUnit(unsigned _id);
     void bindTexture2DArray(GLuint _textureId);
 
   private:
     GLuint vao_;                // Vertex Array Object, covering all buffer objects
-    GLuint vbo_;                // Buffer containing the vertex coordinates
+    GLuint vbo_;                // Buffer containing the texture instance records
     GLuint ebo_;
+    size_t bufferCapacity_ = 0;  // number of instances the vbo_ has storage for
+
+    /// The instances as uploaded to vbo_ by the previous frame.
+    std::vector<TextureInstance> uploadedInstances_;
 
     std::unique_ptr<ExecutionScheduler> scheduler_;
 
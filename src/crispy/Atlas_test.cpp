@@ -0,0 +1,195 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/Atlas.h>
+
+#include <catch2/catch.hpp>
+
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace crispy::atlas;
+
+namespace
+{
+    struct MockCommandListener : public CommandListener {
+        vector<unsigned> createdAtlases;
+        vector<TextureInfo> uploadedTextures;
+        vector<unsigned> destroyedAtlases;
+
+        void createAtlas(CreateAtlas const& _atlas) override { createdAtlases.push_back(_atlas.atlas); }
+        void uploadTexture(UploadTexture const& _texture) override { uploadedTextures.push_back(_texture.texture.get()); }
+        void renderTexture(RenderTexture const&) override {}
+        void destroyAtlas(DestroyAtlas const& _atlas) override { destroyedAtlases.push_back(_atlas.atlas); }
+    };
+
+    pair<unsigned, unsigned> position(TextureInfo const* _texture)
+    {
+        REQUIRE(_texture != nullptr);
+        return {_texture->x, _texture->y};
+    }
+
+    TextureInfo const* insert(TextureAtlasAllocator& _allocator, unsigned _width, unsigned _height)
+    {
+        return _allocator.insert(_width, _height, _width, _height, 0, Buffer(_width * _height));
+    }
+}
+
+TEST_CASE("TextureAtlasAllocator.shelves", "[atlas]")
+{
+    auto listener = MockCommandListener{};
+    {
+        auto allocator = TextureAtlasAllocator{3, 1, 1, 64, 64, 0, listener};
+        CHECK(listener.createdAtlases == vector<unsigned>{3});
+
+        // Textures of the same height fill up a shelf before starting the next one.
+        for (unsigned x = 0; x < 64; x += 16)
+            CHECK(position(insert(allocator, 16, 16)) == pair{x, 0u});
+        CHECK(position(insert(allocator, 16, 14)) == pair{0u, 16u});
+
+        // Much lower textures get a shelf of their own.
+        CHECK(position(insert(allocator, 8, 4)) == pair{0u, 30u});
+        CHECK(position(insert(allocator, 8, 12)) == pair{16u, 16u});
+
+        CHECK(allocator.size() == 7);
+        CHECK(allocator.shelfCount() == 3);
+        CHECK(listener.uploadedTextures.size() == 7);
+        CHECK(listener.uploadedTextures.back().y == 16);
+
+        // Too large for the atlas at all.
+        CHECK(insert(allocator, 65, 1) == nullptr);
+    }
+    CHECK(listener.destroyedAtlases == vector<unsigned>{3});
+}
+
+TEST_CASE("TextureAtlasAllocator.instances", "[atlas]")
+{
+    auto listener = MockCommandListener{};
+    {
+        auto allocator = TextureAtlasAllocator{0, 2, 2, 16, 16, 0, listener};
+
+        // Each texture fills a whole layer, the 3rd one requiring a new instance.
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            auto const texture = insert(allocator, 16, 16);
+            REQUIRE(texture != nullptr);
+            CHECK(texture->atlas == i / 2);
+            CHECK(texture->z == i % 2);
+        }
+        CHECK(listener.createdAtlases == vector<unsigned>{0, 1});
+
+        // No eviction of textures that are not evictable.
+        allocator.nextFrame();
+        CHECK(insert(allocator, 1, 1) == nullptr);
+        CHECK(allocator.evictions() == 0);
+    }
+    CHECK(listener.destroyedAtlases == vector<unsigned>{0, 1});
+}
+
+TEST_CASE("TextureAtlasAllocator.release", "[atlas]")
+{
+    auto listener = MockCommandListener{};
+    auto allocator = TextureAtlasAllocator{0, 1, 1, 32, 32, 0, listener};
+
+    auto const a = insert(allocator, 8, 16);
+    auto const b = insert(allocator, 8, 16);
+    auto const c = insert(allocator, 8, 16);
+    auto const d = insert(allocator, 8, 16);
+    auto const e = insert(allocator, 32, 16);
+    REQUIRE(e != nullptr);
+    CHECK(insert(allocator, 1, 1) == nullptr);
+
+    // Adjacent free space is merged.
+    allocator.release(*b);
+    allocator.release(*c);
+    auto const bc = insert(allocator, 16, 16);
+    CHECK(position(bc) == pair{8u, 0u});
+
+    // Empty shelves at the top of a layer are dropped, making room for textures of any height.
+    allocator.release(*e);
+    CHECK(allocator.shelfCount() == 1);
+    CHECK(position(insert(allocator, 32, 8)) == pair{0u, 16u});
+
+    // Empty shelves below are kept, and reused for textures of about their height.
+    allocator.release(*a);
+    allocator.release(*bc);
+    allocator.release(*d);
+    CHECK(allocator.size() == 1);
+    CHECK(allocator.shelfCount() == 2);
+    CHECK(position(insert(allocator, 32, 12)) == pair{0u, 0u});
+}
+
+TEST_CASE("MetadataTextureAtlas.eviction", "[atlas]")
+{
+    auto listener = MockCommandListener{};
+    auto allocator = TextureAtlasAllocator{0, 1, 1, 32, 32, 0, listener};
+    auto atlas = MetadataTextureAtlas<int, int>{allocator, true};
+    auto const insertKey = [&](int _key) { return atlas.insert(_key, 16, 16, 16, 16, 0, Buffer(16 * 16), 0, _key * 10); };
+
+    for (int key = 1; key <= 4; ++key)
+        REQUIRE(insertKey(key).has_value());
+    REQUIRE(atlas.get(3).has_value());
+    CHECK(get<1>(*atlas.get(3)).get() == 30);
+
+    // Nothing is evicted for textures used in the current frame.
+    CHECK_FALSE(insertKey(5).has_value());
+    CHECK(allocator.evictions() == 0);
+
+    // The least recently used texture is evicted, and the new one takes its place.
+    allocator.nextFrame();
+    REQUIRE(atlas.get(1).has_value());
+    auto const five = insertKey(5);
+    REQUIRE(five.has_value());
+    CHECK(get<0>(*five).get().x == 16);
+    CHECK(get<0>(*five).get().y == 0);
+    CHECK_FALSE(atlas.contains(2));
+    CHECK(allocator.evictions() == 1);
+
+    REQUIRE(insertKey(6).has_value());
+    REQUIRE(insertKey(7).has_value());
+    CHECK_FALSE(atlas.contains(3));
+    CHECK_FALSE(atlas.contains(4));
+    CHECK_FALSE(insertKey(8).has_value());
+    CHECK(atlas.size() == 4);
+    CHECK(listener.uploadedTextures.size() == 7);
+
+    // Clearing the allocator clears its users.
+    allocator.clear();
+    CHECK(atlas.empty());
+    CHECK(allocator.size() == 0);
+    REQUIRE(insertKey(2).has_value());
+    CHECK(get<0>(*atlas.get(2)).get().x == 0);
+}
+
+TEST_CASE("MetadataTextureAtlas.clear", "[atlas]")
+{
+    auto listener = MockCommandListener{};
+    auto allocator = TextureAtlasAllocator{0, 1, 1, 32, 32, 0, listener};
+    auto glyphs = MetadataTextureAtlas<int, int>{allocator, true};
+    auto decorations = MetadataTextureAtlas<int, int>{allocator};
+
+    REQUIRE(decorations.insert(1, 32, 16, 32, 16, 0, Buffer(32 * 16)).has_value());
+    REQUIRE(glyphs.insert(1, 32, 16, 32, 16, 0, Buffer(32 * 16)).has_value());
+
+    // Textures that are not evictable stay.
+    allocator.nextFrame();
+    REQUIRE(glyphs.insert(2, 32, 16, 32, 16, 0, Buffer(32 * 16)).has_value());
+    CHECK(decorations.contains(1));
+    CHECK_FALSE(glyphs.contains(1));
+
+    // Clearing an atlas releases its textures.
+    decorations.clear();
+    CHECK(allocator.size() == 1);
+    CHECK(glyphs.insert(3, 32, 16, 32, 16, 0, Buffer(32 * 16)).has_value());
+}
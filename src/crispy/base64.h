@@ -13,7 +13,9 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace crispy::base64 {
 
@@ -205,4 +207,118 @@ inline std::string decode(const std::string_view& input)
     return output;
 }
 
+/// Incrementally decodes base64 encoded input that arrives in arbitrarily sized chunks,
+/// such as a large payload that is being received in multiple reads.
+///
+/// Characters outside the base64 alphabet (e.g. line breaks) are skipped,
+/// and any input following the first padding character is ignored.
+class Decoder {
+  public:
+    /// Decodes @p _input and appends the decoded bytes to @p _output.
+    ///
+    /// Up to three trailing characters that do not form a complete quantum yet are
+    /// kept back until the next call to decode() or finish().
+    void decode(std::string_view _input, std::string& _output)
+    {
+        if (finished_ || _input.empty())
+            return;
+
+        auto const offset = _output.size();
+        _output.resize(offset + (pendingCount_ + _input.size() + 3) / 4 * 3);
+
+        auto in = reinterpret_cast<uint8_t const*>(_input.data());
+        auto const end = in + _input.size();
+        auto out = reinterpret_cast<uint8_t*>(&_output[0] + offset);
+
+        while (in != end)
+        {
+            // Fast path: decode whole quanta for as long as they consist of alphabet characters only.
+            if (pendingCount_ == 0)
+            {
+                while (end - in >= 4)
+                {
+                    auto const a = detail::indexmap[in[0]];
+                    auto const b = detail::indexmap[in[1]];
+                    auto const c = detail::indexmap[in[2]];
+                    auto const d = detail::indexmap[in[3]];
+                    if ((a | b | c | d) & 0x40)
+                        break;
+
+                    auto const value = static_cast<uint32_t>(a << 18 | b << 12 | c << 6 | d);
+                    *out++ = static_cast<uint8_t>(value >> 16);
+                    *out++ = static_cast<uint8_t>(value >> 8);
+                    *out++ = static_cast<uint8_t>(value);
+                    in += 4;
+                }
+                if (in == end)
+                    break;
+            }
+
+            auto const ch = *in++;
+            if (ch == '=')
+            {
+                out = flush(out);
+                finished_ = true;
+                break;
+            }
+
+            if (auto const index = detail::indexmap[ch]; index <= 63)
+            {
+                pending_ = (pending_ << 6) | index;
+                if (++pendingCount_ == 4)
+                {
+                    *out++ = static_cast<uint8_t>(pending_ >> 16);
+                    *out++ = static_cast<uint8_t>(pending_ >> 8);
+                    *out++ = static_cast<uint8_t>(pending_);
+                    pending_ = 0;
+                    pendingCount_ = 0;
+                }
+            }
+        }
+
+        _output.resize(static_cast<size_t>(reinterpret_cast<char*>(out) - &_output[0]));
+    }
+
+    /// Decodes any characters that have been kept back and resets the decoder,
+    /// making it ready for the next input stream.
+    void finish(std::string& _output)
+    {
+        auto const offset = _output.size();
+        _output.resize(offset + 2);
+        auto const out = flush(reinterpret_cast<uint8_t*>(&_output[0] + offset));
+        _output.resize(static_cast<size_t>(reinterpret_cast<char*>(out) - &_output[0]));
+        finished_ = false;
+    }
+
+    /// Discards any pending state, e.g. in order to start over with a new input stream.
+    void reset() noexcept
+    {
+        pending_ = 0;
+        pendingCount_ = 0;
+        finished_ = false;
+    }
+
+  private:
+    /// Writes the bytes of an incomplete quantum, if any, and clears it.
+    uint8_t* flush(uint8_t* _out) noexcept
+    {
+        // A single trailing character carries less than a byte, and is thus dropped.
+        if (pendingCount_ >= 2)
+        {
+            auto const value = pending_ << (6 * (4 - pendingCount_));
+            *_out++ = static_cast<uint8_t>(value >> 16);
+            if (pendingCount_ == 3)
+                *_out++ = static_cast<uint8_t>(value >> 8);
+        }
+        pending_ = 0;
+        pendingCount_ = 0;
+        return _out;
+    }
+
+  private:
+    uint32_t pending_ = 0;      // sextets of the incomplete quantum received so far
+    unsigned pendingCount_ = 0; // number of sextets in pending_
+    bool finished_ = false;     // padding has been seen, ignore any further input
+};
+
 } // end namespace xzero
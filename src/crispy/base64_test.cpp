@@ -13,6 +13,9 @@
  */
 #include <crispy/base64.h>
 #include <catch2/catch.hpp>
+#include <fmt/format.h>
+#include <string>
+#include <string_view>
 
 using namespace crispy;
 
@@ -33,3 +36,46 @@ TEST_CASE("base64.decode", "[base64]")
     CHECK("abcd" == base64::decode("YWJjZA=="));
     CHECK("foo:bar" == base64::decode("Zm9vOmJhcg=="));
 }
+
+TEST_CASE("base64.Decoder", "[base64]")
+{
+    auto const text = std::string("The quick brown fox jumps over the lazy dog.\n\x00\x01\xFE\xFF", 49);
+
+    for (size_t length = 0; length <= text.size(); ++length)
+    {
+        auto const input = text.substr(0, length);
+        auto const encoded = base64::encode(input);
+
+        for (size_t chunkSize = 1; chunkSize <= 7; ++chunkSize)
+        {
+            INFO(fmt::format("length: {}, chunk size: {}", length, chunkSize));
+            auto decoder = base64::Decoder{};
+            auto output = std::string{};
+            for (size_t i = 0; i < encoded.size(); i += chunkSize)
+                decoder.decode(std::string_view(encoded).substr(i, chunkSize), output);
+            decoder.finish(output);
+            CHECK(output == input);
+        }
+    }
+}
+
+TEST_CASE("base64.Decoder.unpadded", "[base64]")
+{
+    auto decoder = base64::Decoder{};
+    auto output = std::string{};
+    decoder.decode("Zm9v", output);
+    decoder.decode("Ym", output);
+    CHECK(output == "foo");
+    decoder.decode("Fy", output);
+    decoder.finish(output);
+    CHECK(output == "foobar");
+}
+
+TEST_CASE("base64.Decoder.skips_invalid", "[base64]")
+{
+    auto decoder = base64::Decoder{};
+    auto output = std::string{};
+    decoder.decode("Zm9v\r\nOmJh\ncg==ignored", output);
+    decoder.finish(output);
+    CHECK(output == "foo:bar");
+}
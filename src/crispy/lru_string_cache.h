@@ -0,0 +1,275 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <crispy/FNV.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace crispy {
+
+/// Cache of values keyed by a string and a small tag, holding at most a fixed number of entries
+/// and evicting the least recently used one to make room for a new one.
+///
+/// The keys are stored back to back in a single buffer rather than allocated one by one, and the
+/// entries are indexed by an open addressing hash table. The key buffer is compacted once more than
+/// half of it belongs to evicted entries.
+template <typename Char, typename Value>
+class lru_string_cache {
+  public:
+    using string_view_type = std::basic_string_view<Char>;
+    using tag_type = uint32_t;
+
+    explicit lru_string_cache(size_t _capacity) { reset(_capacity); }
+
+    size_t size() const noexcept { return entries_.size(); }
+    size_t capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return entries_.empty(); }
+
+    /// @returns the number of key characters stored, including those of evicted entries not yet reclaimed.
+    size_t key_storage_size() const noexcept { return keys_.size(); }
+
+    // Statistics, accumulated over the lifetime of the cache.
+    uint64_t hits() const noexcept { return hits_; }
+    uint64_t misses() const noexcept { return misses_; }
+    uint64_t evictions() const noexcept { return evictions_; }
+
+    /// @returns the value cached for the given key, marking it most recently used, or nullptr.
+    Value* try_get(string_view_type _key, tag_type _tag)
+    {
+        if (auto const slot = find(_key, _tag, hash(_key, _tag)); slot != npos)
+        {
+            ++hits_;
+            unlink(slot);
+            link_front(slot);
+            return &entries_[slot].value;
+        }
+
+        ++misses_;
+        return nullptr;
+    }
+
+    /// Caches @p _value for the given key, which must not be cached yet, evicting the least
+    /// recently used entry if the cache is full.
+    ///
+    /// @returns a reference to the cached value, valid until the cache is modified.
+    Value& emplace(string_view_type _key, tag_type _tag, Value _value)
+    {
+        auto slot = npos;
+        if (entries_.size() < capacity_)
+        {
+            slot = static_cast<uint32_t>(entries_.size());
+            entries_.emplace_back();
+        }
+        else
+        {
+            slot = tail_;
+            erase_index(slot);
+            unlink(slot);
+            garbage_ += entries_[slot].key_size;
+            ++evictions_;
+        }
+
+        if (garbage_ > MinCompactionSize && garbage_ * 2 > keys_.size())
+            compact();
+
+        Entry& entry = entries_[slot];
+        entry.key_offset = keys_.size();
+        entry.key_size = _key.size();
+        entry.tag = _tag;
+        entry.hash = hash(_key, _tag);
+        entry.value = std::move(_value);
+        keys_.insert(keys_.end(), _key.begin(), _key.end());
+
+        link_front(slot);
+        insert_index(slot);
+
+        return entry.value;
+    }
+
+    /// Removes all entries, keeping the statistics.
+    void clear()
+    {
+        entries_.clear();
+        keys_.clear();
+        std::fill(index_.begin(), index_.end(), npos);
+        head_ = npos;
+        tail_ = npos;
+        garbage_ = 0;
+    }
+
+    /// Changes the maximum number of entries, which clears the cache.
+    void set_capacity(size_t _capacity)
+    {
+        clear();
+        reset(_capacity);
+    }
+
+    /// Invokes @p _callback with the key, tag and value of each entry, most recently used first.
+    template <typename Callback>
+    void for_each(Callback _callback) const
+    {
+        for (auto slot = head_; slot != npos; slot = entries_[slot].next)
+            _callback(key(entries_[slot]), entries_[slot].tag, entries_[slot].value);
+    }
+
+  private:
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+    static constexpr size_t MinCompactionSize = 4096;
+
+    struct Entry {
+        size_t key_offset = 0;
+        size_t key_size = 0;
+        tag_type tag = 0;
+        size_t hash = 0;
+        uint32_t prev = npos;       // more recently used entry
+        uint32_t next = npos;       // less recently used entry
+        Value value{};
+    };
+
+    static size_t hash(string_view_type _key, tag_type _tag) noexcept
+    {
+        auto const fnv = FNV<size_t>{};
+        auto memory = size_t{2166136261u};
+        for (Char const ch : _key)
+            memory = fnv(memory, static_cast<size_t>(ch));
+        return fnv(memory, static_cast<size_t>(_tag));
+    }
+
+    string_view_type key(Entry const& _entry) const noexcept
+    {
+        return string_view_type(keys_.data() + _entry.key_offset, _entry.key_size);
+    }
+
+    void reset(size_t _capacity)
+    {
+        capacity_ = std::clamp(_capacity, size_t{1}, size_t{npos - 1});
+
+        // At most half full, keeping the probe sequences short.
+        auto indexSize = size_t{8};
+        while (indexSize < capacity_ * 2)
+            indexSize *= 2;
+        index_.assign(indexSize, npos);
+        entries_.shrink_to_fit();
+    }
+
+    uint32_t find(string_view_type _key, tag_type _tag, size_t _hash) const noexcept
+    {
+        auto const mask = index_.size() - 1;
+        for (auto i = _hash & mask; index_[i] != npos; i = (i + 1) & mask)
+        {
+            Entry const& entry = entries_[index_[i]];
+            if (entry.hash == _hash && entry.tag == _tag && key(entry) == _key)
+                return index_[i];
+        }
+        return npos;
+    }
+
+    void insert_index(uint32_t _slot) noexcept
+    {
+        auto const mask = index_.size() - 1;
+        auto i = entries_[_slot].hash & mask;
+        while (index_[i] != npos)
+            i = (i + 1) & mask;
+        index_[i] = _slot;
+    }
+
+    /// Removes @p _slot from the hash index, moving back the entries probed past it.
+    void erase_index(uint32_t _slot) noexcept
+    {
+        auto const mask = index_.size() - 1;
+        auto i = entries_[_slot].hash & mask;
+        while (index_[i] != _slot)
+            i = (i + 1) & mask;
+
+        for (auto j = (i + 1) & mask; index_[j] != npos; j = (j + 1) & mask)
+        {
+            // Entries whose home position lies cyclically within (i, j] are still reachable.
+            auto const home = entries_[index_[j]].hash & mask;
+            if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+                continue;
+
+            index_[i] = index_[j];
+            i = j;
+        }
+        index_[i] = npos;
+    }
+
+    void unlink(uint32_t _slot) noexcept
+    {
+        Entry& entry = entries_[_slot];
+        if (entry.prev != npos)
+            entries_[entry.prev].next = entry.next;
+        else
+            head_ = entry.next;
+
+        if (entry.next != npos)
+            entries_[entry.next].prev = entry.prev;
+        else
+            tail_ = entry.prev;
+
+        entry.prev = npos;
+        entry.next = npos;
+    }
+
+    void link_front(uint32_t _slot) noexcept
+    {
+        Entry& entry = entries_[_slot];
+        entry.prev = npos;
+        entry.next = head_;
+        if (head_ != npos)
+            entries_[head_].prev = _slot;
+        head_ = _slot;
+        if (tail_ == npos)
+            tail_ = _slot;
+    }
+
+    /// Rebuilds the key buffer from the keys of the entries in use.
+    void compact()
+    {
+        auto keys = std::vector<Char>{};
+        keys.reserve(keys_.size() - garbage_);
+        for (auto slot = head_; slot != npos; slot = entries_[slot].next)
+        {
+            Entry& entry = entries_[slot];
+            auto const offset = keys.size();
+            keys.insert(keys.end(), keys_.begin() + entry.key_offset,
+                                    keys_.begin() + entry.key_offset + entry.key_size);
+            entry.key_offset = offset;
+        }
+        keys_ = std::move(keys);
+        garbage_ = 0;
+    }
+
+  private:
+    size_t capacity_ = 0;
+    std::vector<Entry> entries_;        // at most capacity_, never shrinking until cleared
+    std::vector<Char> keys_;            // keys of all entries, back to back
+    std::vector<uint32_t> index_;       // slots into entries_ by hash, npos if empty
+    uint32_t head_ = npos;              // most recently used entry
+    uint32_t tail_ = npos;              // least recently used entry
+    size_t garbage_ = 0;                // characters in keys_ of evicted entries
+
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
+
+} // end namespace crispy
@@ -0,0 +1,106 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/lru_string_cache.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+using crispy::lru_string_cache;
+
+namespace
+{
+    vector<u32string> keys(lru_string_cache<char32_t, int> const& _cache)
+    {
+        auto result = vector<u32string>{};
+        _cache.for_each([&](u32string_view _key, uint32_t, int) { result.emplace_back(_key); });
+        return result;
+    }
+}
+
+TEST_CASE("lru_string_cache.lookup", "[lru_string_cache]")
+{
+    auto cache = lru_string_cache<char32_t, int>{4};
+    CHECK(cache.try_get(U"abc", 0) == nullptr);
+
+    cache.emplace(U"abc", 0, 1);
+    cache.emplace(U"abc", 1, 2);
+    cache.emplace(U"", 0, 3);
+
+    REQUIRE(cache.try_get(U"abc", 0) != nullptr);
+    CHECK(*cache.try_get(U"abc", 0) == 1);
+    CHECK(*cache.try_get(U"abc", 1) == 2);
+    CHECK(*cache.try_get(U"", 0) == 3);
+    CHECK(cache.try_get(U"ab", 0) == nullptr);
+
+    CHECK(cache.size() == 3);
+    CHECK(cache.hits() == 4);
+    CHECK(cache.misses() == 2);
+    CHECK(cache.evictions() == 0);
+}
+
+TEST_CASE("lru_string_cache.eviction", "[lru_string_cache]")
+{
+    auto cache = lru_string_cache<char32_t, int>{3};
+    cache.emplace(U"a", 0, 1);
+    cache.emplace(U"b", 0, 2);
+    cache.emplace(U"c", 0, 3);
+    CHECK(keys(cache) == vector<u32string>{U"c", U"b", U"a"});
+
+    // Looking up makes an entry the most recently used one.
+    CHECK(cache.try_get(U"a", 0) != nullptr);
+    CHECK(keys(cache) == vector<u32string>{U"a", U"c", U"b"});
+
+    // Hence the least recently used one is evicted.
+    cache.emplace(U"d", 0, 4);
+    CHECK(keys(cache) == vector<u32string>{U"d", U"a", U"c"});
+    CHECK(cache.try_get(U"b", 0) == nullptr);
+    CHECK(cache.evictions() == 1);
+    CHECK(cache.size() == 3);
+
+    cache.set_capacity(2);
+    CHECK(cache.empty());
+    CHECK(cache.capacity() == 2);
+}
+
+TEST_CASE("lru_string_cache.bounded", "[lru_string_cache]")
+{
+    auto const makeKey = [](int i) {
+        return U"key-" + u32string(static_cast<size_t>(i % 37), U'x') + char32_t(0x10000 + i);
+    };
+
+    // Many more distinct keys than fit, as with log output full of hashes.
+    auto cache = lru_string_cache<char32_t, int>{100};
+    for (int i = 0; i < 100000; ++i)
+    {
+        REQUIRE(cache.try_get(makeKey(i), 0) == nullptr);
+        cache.emplace(makeKey(i), 0, i);
+    }
+
+    CHECK(cache.size() == 100);
+    CHECK(cache.evictions() == 100000 - 100);
+
+    // The most recently inserted keys survived the evictions and key storage compactions.
+    for (int i = 100000 - 100; i < 100000; ++i)
+    {
+        auto const value = cache.try_get(makeKey(i), 0);
+        REQUIRE(value != nullptr);
+        CHECK(*value == i);
+    }
+
+    // The key storage is reclaimed rather than growing with every key ever inserted.
+    CHECK(cache.key_storage_size() < 2 * (100 * 42 + 4096));
+}
@@ -13,6 +13,8 @@
  */
 #pragma once
 
+#include <iterator>
+
 namespace crispy {
 
 template <typename Iter>
@@ -25,6 +27,7 @@ struct range
 
     constexpr Iter begin() const { return begin_; }
     constexpr Iter end() const { return end_; }
+    constexpr auto size() const { return std::distance(begin_, end_); }
 };
 
 template <typename Iter>
@@ -0,0 +1,313 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace crispy {
+
+/// Random access iterator over the elements of a ring, in logical order.
+///
+/// Like vector iterators, ring iterators are invalidated by any operation that
+/// rotates the ring or changes its size.
+template <typename T>
+class ring_iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_const_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    constexpr ring_iterator() noexcept = default;
+
+    constexpr ring_iterator(T* _data, size_t _size, size_t _zero, difference_type _index) noexcept :
+        data_{_data}, size_{_size}, zero_{_zero}, index_{_index}
+    {}
+
+    /// Allows conversion from iterator to const_iterator.
+    template <typename U, typename = std::enable_if_t<std::is_same_v<T, U const>>>
+    constexpr ring_iterator(ring_iterator<U> const& _other) noexcept :
+        data_{_other.data_}, size_{_other.size_}, zero_{_other.zero_}, index_{_other.index_}
+    {}
+
+    constexpr reference operator*() const noexcept { return data_[offset(index_)]; }
+    constexpr pointer operator->() const noexcept { return &**this; }
+    constexpr reference operator[](difference_type _n) const noexcept { return data_[offset(index_ + _n)]; }
+
+    constexpr ring_iterator& operator++() noexcept { ++index_; return *this; }
+    constexpr ring_iterator& operator--() noexcept { --index_; return *this; }
+    constexpr ring_iterator operator++(int) noexcept { auto old = *this; ++index_; return old; }
+    constexpr ring_iterator operator--(int) noexcept { auto old = *this; --index_; return old; }
+
+    constexpr ring_iterator& operator+=(difference_type _n) noexcept { index_ += _n; return *this; }
+    constexpr ring_iterator& operator-=(difference_type _n) noexcept { index_ -= _n; return *this; }
+
+    constexpr ring_iterator operator+(difference_type _n) const noexcept { return ring_iterator{data_, size_, zero_, index_ + _n}; }
+    constexpr ring_iterator operator-(difference_type _n) const noexcept { return ring_iterator{data_, size_, zero_, index_ - _n}; }
+    constexpr difference_type operator-(ring_iterator const& _other) const noexcept { return index_ - _other.index_; }
+
+    friend constexpr ring_iterator operator+(difference_type _n, ring_iterator const& _i) noexcept { return _i + _n; }
+
+    constexpr bool operator==(ring_iterator const& _other) const noexcept { return data_ == _other.data_ && index_ == _other.index_; }
+    constexpr bool operator!=(ring_iterator const& _other) const noexcept { return !(*this == _other); }
+    constexpr bool operator<(ring_iterator const& _other) const noexcept { return index_ < _other.index_; }
+    constexpr bool operator>(ring_iterator const& _other) const noexcept { return index_ > _other.index_; }
+    constexpr bool operator<=(ring_iterator const& _other) const noexcept { return index_ <= _other.index_; }
+    constexpr bool operator>=(ring_iterator const& _other) const noexcept { return index_ >= _other.index_; }
+
+  private:
+    constexpr size_t offset(difference_type _index) const noexcept
+    {
+        auto const i = zero_ + static_cast<size_t>(_index);
+        return i < size_ ? i : i - size_;
+    }
+
+    template <typename> friend class ring_iterator;
+
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    size_t zero_ = 0;
+    difference_type index_ = 0;
+};
+
+/// Sequence container of contiguously stored elements that can be rotated in constant time.
+///
+/// Rotating moves the logical start of the ring rather than the elements themselves,
+/// which makes it suitable for scrolling through preallocated storage.
+/// Inserting or erasing elements first moves the elements back into logical order,
+/// which is linear in the number of elements.
+///
+/// Elements dropped from the front via pop_front() are left behind in their slots as spare
+/// capacity, which is reused by subsequent calls to emplace_back() or recycle_back().
+template <typename T>
+class ring {
+  public:
+    using value_type = T;
+    using iterator = ring_iterator<T>;
+    using const_iterator = ring_iterator<T const>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using difference_type = std::ptrdiff_t;
+
+    ring() = default;
+    ring(size_t _count, T const& _value) : storage_(_count, _value), size_{_count} {}
+
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    T& operator[](size_t _index) noexcept { return storage_[offset(_index)]; }
+    T const& operator[](size_t _index) const noexcept { return storage_[offset(_index)]; }
+
+    T& at(size_t _index)
+    {
+        if (_index >= size())
+            throw std::out_of_range("ring index out of range");
+        return (*this)[_index];
+    }
+
+    T const& at(size_t _index) const
+    {
+        if (_index >= size())
+            throw std::out_of_range("ring index out of range");
+        return (*this)[_index];
+    }
+
+    T& front() noexcept { return (*this)[0]; }
+    T const& front() const noexcept { return (*this)[0]; }
+    T& back() noexcept { return (*this)[size() - 1]; }
+    T const& back() const noexcept { return (*this)[size() - 1]; }
+
+    iterator begin() noexcept { return iterator{storage_.data(), storage_.size(), zero_, 0}; }
+    iterator end() noexcept { return iterator{storage_.data(), storage_.size(), zero_, static_cast<difference_type>(size())}; }
+    const_iterator begin() const noexcept { return const_iterator{storage_.data(), storage_.size(), zero_, 0}; }
+    const_iterator end() const noexcept { return const_iterator{storage_.data(), storage_.size(), zero_, static_cast<difference_type>(size())}; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator{end()}; }
+    reverse_iterator rend() noexcept { return reverse_iterator{begin()}; }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{end()}; }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator{begin()}; }
+
+    /// Moves the first @p _count elements to the back.
+    ///
+    /// This takes constant time, unless there are spare slots left behind by pop_front(),
+    /// in which case each of the @p _count elements is swapped with the spare slot behind the last one.
+    void rotate_left(size_t _count)
+    {
+        if (empty())
+            return;
+
+        _count %= size_;
+        if (size_ == storage_.size())
+        {
+            zero_ = (zero_ + _count) % size_;
+            return;
+        }
+
+        for (size_t i = 0; i < _count; ++i)
+        {
+            std::swap(storage_[zero_], storage_[offset(size_)]);
+            zero_ = (zero_ + 1) % storage_.size();
+        }
+    }
+
+    /// Moves the last @p _count elements to the front.
+    ///
+    /// This takes constant time, unless there are spare slots left behind by pop_front(),
+    /// in which case each of the @p _count elements is swapped with the spare slot before the first one.
+    void rotate_right(size_t _count)
+    {
+        if (empty())
+            return;
+
+        _count %= size_;
+        if (size_ == storage_.size())
+        {
+            zero_ = (zero_ + size_ - _count) % size_;
+            return;
+        }
+
+        for (size_t i = 0; i < _count; ++i)
+        {
+            zero_ = (zero_ + storage_.size() - 1) % storage_.size();
+            std::swap(storage_[zero_], storage_[offset(size_)]);
+        }
+    }
+
+    /// Appends an element constructed from @p _args.
+    ///
+    /// A spare slot is reused if available, replacing the element left behind in it.
+    template <typename... Args>
+    T& emplace_back(Args&&... _args)
+    {
+        if (size_ < storage_.size())
+        {
+            T& slot = storage_[offset(size_)];
+            slot = T(std::forward<Args>(_args)...);
+            ++size_;
+            return slot;
+        }
+
+        linearize();
+        T& element = storage_.emplace_back(std::forward<Args>(_args)...);
+        ++size_;
+        return element;
+    }
+
+    void push_back(T const& _value) { emplace_back(_value); }
+    void push_back(T&& _value) { emplace_back(std::move(_value)); }
+
+    /// Appends the element left behind in the next spare slot as is, so that the caller can
+    /// reuse its resources, or a default constructed element if there is no spare slot.
+    T& recycle_back()
+    {
+        if (size_ < storage_.size())
+        {
+            ++size_;
+            return back();
+        }
+
+        return emplace_back();
+    }
+
+    /// Drops the first @p _count elements, in constant time.
+    ///
+    /// The dropped elements are left intact in their slots, which are kept as spare capacity
+    /// for emplace_back() and recycle_back().
+    void pop_front(size_t _count) noexcept
+    {
+        _count = std::min(_count, size_);
+        zero_ = storage_.empty() ? 0 : (zero_ + _count) % storage_.size();
+        size_ -= _count;
+    }
+
+    /// Erases the elements in [@p _first, @p _last).
+    void erase(const_iterator _first, const_iterator _last)
+    {
+        auto const first = _first - cbegin();
+        auto const last = _last - cbegin();
+        if (first == 0)
+            return pop_front(static_cast<size_t>(last));
+
+        compact();
+        storage_.erase(storage_.begin() + first, storage_.begin() + last);
+        size_ = storage_.size();
+    }
+
+    /// Inserts the elements in [@p _first, @p _last) before @p _pos.
+    template <typename InputIt>
+    void insert(const_iterator _pos, InputIt _first, InputIt _last)
+    {
+        auto const pos = _pos - cbegin();
+        compact();
+        storage_.insert(storage_.begin() + pos, _first, _last);
+        size_ = storage_.size();
+    }
+
+    void resize(size_t _count)
+    {
+        compact();
+        storage_.resize(_count);
+        size_ = _count;
+    }
+
+    void clear() noexcept
+    {
+        storage_.clear();
+        size_ = 0;
+        zero_ = 0;
+    }
+
+  private:
+    size_t offset(size_t _index) const noexcept
+    {
+        auto const i = zero_ + _index;
+        return i < storage_.size() ? i : i - storage_.size();
+    }
+
+    /// Moves all elements into their logical order within the underlying storage.
+    void linearize()
+    {
+        if (zero_ == 0)
+            return;
+
+        std::rotate(storage_.begin(), storage_.begin() + static_cast<difference_type>(zero_), storage_.end());
+        zero_ = 0;
+    }
+
+    /// Linearizes the elements and releases any spare slots, so that storage_ holds exactly the elements.
+    void compact()
+    {
+        if (size_ == storage_.size())
+            return linearize();
+
+        linearize();
+        storage_.erase(storage_.begin() + static_cast<difference_type>(size_), storage_.end());
+    }
+
+  private:
+    std::vector<T> storage_;
+    size_t size_ = 0;  // number of elements, storage_.size() minus spare slots
+    size_t zero_ = 0;  // storage index of the logically first element
+};
+
+} // end namespace crispy
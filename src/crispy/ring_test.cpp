@@ -0,0 +1,180 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/ring.h>
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    template <typename T>
+    vector<T> elements(crispy::ring<T> const& _ring)
+    {
+        return vector<T>(_ring.begin(), _ring.end());
+    }
+}
+
+TEST_CASE("ring.rotate", "[ring]")
+{
+    auto r = crispy::ring<int>{};
+    for (int i = 1; i <= 5; ++i)
+        r.push_back(i);
+
+    r.rotate_left(2);
+    CHECK(elements(r) == vector{3, 4, 5, 1, 2});
+    CHECK(r.front() == 3);
+    CHECK(r.back() == 2);
+    CHECK(r[4] == 2);
+
+    r.rotate_right(3);
+    CHECK(elements(r) == vector{5, 1, 2, 3, 4});
+
+    r.rotate_left(5);
+    CHECK(elements(r) == vector{5, 1, 2, 3, 4});
+
+    CHECK(vector<int>(r.rbegin(), r.rend()) == vector{4, 3, 2, 1, 5});
+}
+
+TEST_CASE("ring.modify_rotated", "[ring]")
+{
+    auto r = crispy::ring<int>{};
+    for (int i = 1; i <= 5; ++i)
+        r.push_back(i);
+    r.rotate_left(3);
+
+    r.push_back(6);
+    CHECK(elements(r) == vector{4, 5, 1, 2, 3, 6});
+
+    r.rotate_left(1);
+    r.erase(r.begin(), next(r.begin(), 2));
+    CHECK(elements(r) == vector{2, 3, 6, 4});
+
+    r.rotate_right(1);
+    r.resize(2);
+    CHECK(elements(r) == vector{4, 2});
+
+    auto const inserted = vector{7, 8};
+    r.rotate_left(1);
+    r.insert(next(r.cbegin(), 1), inserted.begin(), inserted.end());
+    CHECK(elements(r) == vector{2, 7, 8, 4});
+}
+
+TEST_CASE("ring.algorithms", "[ring]")
+{
+    auto r = crispy::ring<int>(6, 0);
+    r.rotate_left(4);
+    iota(r.begin(), r.end(), 1);
+    CHECK(elements(r) == vector{1, 2, 3, 4, 5, 6});
+
+    rotate(next(r.begin(), 1), next(r.begin(), 3), prev(r.end(), 1));
+    CHECK(elements(r) == vector{1, 4, 5, 2, 3, 6});
+
+    auto const i = find(r.cbegin(), r.cend(), 2);
+    CHECK(i - r.cbegin() == 3);
+}
+
+TEST_CASE("ring.pop_front", "[ring]")
+{
+    auto r = crispy::ring<int>{};
+    for (int i = 1; i <= 5; ++i)
+        r.push_back(i);
+    r.rotate_left(3);
+
+    r.pop_front(2);
+    CHECK(elements(r) == vector{1, 2, 3});
+    CHECK(r.size() == 3);
+
+    // The spare slots are reused in place.
+    r.push_back(6);
+    r.push_back(7);
+    CHECK(elements(r) == vector{1, 2, 3, 6, 7});
+
+    r.erase(r.begin(), next(r.begin(), 1));
+    r.push_back(8);
+    r.push_back(9);
+    CHECK(elements(r) == vector{2, 3, 6, 7, 8, 9});
+
+    r.pop_front(1);
+    r.rotate_left(1);
+    CHECK(elements(r) == vector{6, 7, 8, 9, 3});
+
+    r.pop_front(10);
+    CHECK(r.empty());
+    r.push_back(10);
+    CHECK(elements(r) == vector{10});
+}
+
+TEST_CASE("ring.rotate_full", "[ring]")
+{
+    auto r = crispy::ring<int>{};
+    for (int i = 1; i <= 5; ++i)
+        r.push_back(i);
+
+    // Rotating a ring without spare slots does not move any element.
+    auto addresses = vector<int const*>{};
+    for (int const& i : r)
+        addresses.push_back(&i);
+
+    r.rotate_left(1);
+    CHECK(elements(r) == vector{2, 3, 4, 5, 1});
+    CHECK(&r.back() == addresses[0]);
+    CHECK(&r.front() == addresses[1]);
+
+    r.rotate_right(2);
+    CHECK(elements(r) == vector{5, 1, 2, 3, 4});
+    CHECK(&r.front() == addresses[4]);
+    CHECK(&r.back() == addresses[3]);
+}
+
+TEST_CASE("ring.rotate_spare", "[ring]")
+{
+    auto r = crispy::ring<int>{};
+    for (int i = 1; i <= 6; ++i)
+        r.push_back(i);
+    r.pop_front(2);
+    REQUIRE(elements(r) == vector{3, 4, 5, 6});
+
+    r.rotate_left(3);
+    CHECK(elements(r) == vector{6, 3, 4, 5});
+
+    r.rotate_right(6);
+    CHECK(elements(r) == vector{4, 5, 6, 3});
+
+    r.push_back(7);
+    r.push_back(8);
+    CHECK(elements(r) == vector{4, 5, 6, 3, 7, 8});
+}
+
+TEST_CASE("ring.recycle_back", "[ring]")
+{
+    auto r = crispy::ring<vector<int>>{};
+    r.push_back(vector{1, 2});
+    r.push_back(vector{3});
+
+    // The dropped element is handed out again as is.
+    r.pop_front(1);
+    vector<int>& recycled = r.recycle_back();
+    CHECK(recycled == vector{1, 2});
+    CHECK(r.size() == 2);
+
+    // Without spare slots, a new element is appended.
+    CHECK(r.recycle_back().empty());
+    CHECK(r.size() == 3);
+    CHECK(elements(r) == vector<vector<int>>{{3}, {1, 2}, {}});
+}
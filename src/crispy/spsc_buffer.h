@@ -0,0 +1,104 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <crispy/span.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace crispy {
+
+/// Lock-free, fixed capacity FIFO buffer for one producer thread and one consumer thread.
+///
+/// Rather than copying elements in and out, both sides access the buffer in place:
+/// the producer fills the free space returned by write_span() and publishes it with commit(),
+/// the consumer processes what read_span() returns and releases it with consume().
+/// As the storage wraps around, each side may need two spans to get to all of it.
+template <typename T>
+class spsc_buffer {
+  public:
+    explicit spsc_buffer(size_t _capacity) :
+        capacity_{ std::max(_capacity, size_t{1}) },
+        storage_{ std::make_unique<T[]>(capacity_) }
+    {}
+
+    spsc_buffer(spsc_buffer const&) = delete;
+    spsc_buffer& operator=(spsc_buffer const&) = delete;
+
+    size_t capacity() const noexcept { return capacity_; }
+
+    /// @returns the number of elements committed but not yet consumed.
+    ///
+    /// As the other side keeps going, this is a lower bound for the consumer
+    /// and an upper bound for the producer.
+    size_t size() const noexcept
+    {
+        auto const read = read_.load(std::memory_order_acquire);
+        return static_cast<size_t>(written_.load(std::memory_order_acquire) - read);
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+    bool full() const noexcept { return size() == capacity_; }
+
+    // {{{ producer side
+    /// @returns the contiguous free space elements can be written to, to be called by the producer.
+    span<T> write_span() noexcept
+    {
+        auto const written = written_.load(std::memory_order_relaxed);
+        auto const free = capacity_ - static_cast<size_t>(written - read_.load(std::memory_order_acquire));
+        auto const offset = static_cast<size_t>(written % capacity_);
+        auto const count = std::min(free, capacity_ - offset);
+        return span<T>{ storage_.get() + offset, storage_.get() + offset + count };
+    }
+
+    /// Makes the first @p _count elements of the write_span() available to the consumer.
+    void commit(size_t _count) noexcept
+    {
+        written_.store(written_.load(std::memory_order_relaxed) + _count, std::memory_order_release);
+    }
+    // }}}
+
+    // {{{ consumer side
+    /// @returns the contiguous elements available for reading, to be called by the consumer.
+    span<T const> read_span() const noexcept
+    {
+        auto const read = read_.load(std::memory_order_relaxed);
+        auto const available = static_cast<size_t>(written_.load(std::memory_order_acquire) - read);
+        auto const offset = static_cast<size_t>(read % capacity_);
+        auto const count = std::min(available, capacity_ - offset);
+        return span<T const>{ storage_.get() + offset, storage_.get() + offset + count };
+    }
+
+    /// Releases the first @p _count elements of the read_span() to the producer.
+    void consume(size_t _count) noexcept
+    {
+        read_.store(read_.load(std::memory_order_relaxed) + _count, std::memory_order_release);
+    }
+    // }}}
+
+  private:
+    size_t const capacity_;
+    std::unique_ptr<T[]> storage_;
+
+    // Total number of elements ever written and read, on separate cache lines
+    // so that producer and consumer do not contend for them.
+    alignas(64) std::atomic<uint64_t> written_{0};
+    alignas(64) std::atomic<uint64_t> read_{0};
+};
+
+} // end namespace crispy
@@ -0,0 +1,118 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/spsc_buffer.h>
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <thread>
+
+using namespace std;
+using crispy::spsc_buffer;
+
+namespace
+{
+    size_t write(spsc_buffer<char>& _buffer, string const& _text)
+    {
+        auto span = _buffer.write_span();
+        auto const count = min(span.size(), _text.size());
+        copy_n(_text.begin(), count, span.begin());
+        _buffer.commit(count);
+        return count;
+    }
+
+    string read(spsc_buffer<char>& _buffer)
+    {
+        auto const span = _buffer.read_span();
+        auto text = string(span.begin(), span.end());
+        _buffer.consume(span.size());
+        return text;
+    }
+}
+
+TEST_CASE("spsc_buffer.wrap_around", "[spsc_buffer]")
+{
+    auto buffer = spsc_buffer<char>{8};
+    CHECK(buffer.empty());
+
+    CHECK(write(buffer, "abcdef") == 6);
+    CHECK(buffer.size() == 6);
+    CHECK(read(buffer) == "abcdef");
+    CHECK(buffer.empty());
+
+    // The free space wraps around the end of the storage.
+    CHECK(buffer.write_span().size() == 2);
+    CHECK(write(buffer, "ghij") == 2);
+    CHECK(write(buffer, "ij") == 2);
+    CHECK(buffer.size() == 4);
+
+    // So does the readable data.
+    CHECK(read(buffer) == "gh");
+    CHECK(read(buffer) == "ij");
+    CHECK(buffer.empty());
+}
+
+TEST_CASE("spsc_buffer.full", "[spsc_buffer]")
+{
+    auto buffer = spsc_buffer<char>{4};
+    CHECK(write(buffer, "abcdef") == 4);
+    CHECK(buffer.full());
+    CHECK(buffer.write_span().empty());
+
+    // Consuming part of it makes room again.
+    auto const span = buffer.read_span();
+    CHECK(string(span.begin(), span.begin() + 1) == "a");
+    buffer.consume(1);
+    CHECK(buffer.write_span().size() == 1);
+    CHECK(write(buffer, "e") == 1);
+    CHECK(read(buffer) == "bcd");
+    CHECK(read(buffer) == "e");
+}
+
+TEST_CASE("spsc_buffer.threads", "[spsc_buffer]")
+{
+    auto buffer = spsc_buffer<char>{64};
+    auto expected = string{};
+    for (int i = 0; i < 10000; ++i)
+        expected += to_string(i) + ";";
+
+    auto producer = thread{[&]() {
+        auto rest = string_view{expected};
+        while (!rest.empty())
+        {
+            auto span = buffer.write_span();
+            auto const count = min(span.size(), rest.size());
+            copy_n(rest.begin(), count, span.begin());
+            buffer.commit(count);
+            rest.remove_prefix(count);
+            if (count == 0)
+                this_thread::yield();
+        }
+    }};
+
+    auto actual = string{};
+    while (actual.size() < expected.size())
+    {
+        auto const text = read(buffer);
+        actual += text;
+        if (text.empty())
+            this_thread::yield();
+    }
+    producer.join();
+
+    CHECK(actual == expected);
+    CHECK(buffer.empty());
+}
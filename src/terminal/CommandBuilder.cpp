@@ -25,6 +25,7 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <numeric>
@@ -530,9 +531,10 @@ namespace impl // {{{ some command generator helpers
     ApplyResult clipboard(Sequence const& _ctx, CommandList& _output)
     {
         // Only setting clipboard contents is supported, not reading.
+        // The base64 encoded data has already been decoded into the data string while being received.
         auto const& params = _ctx.intermediateCharacters();
-        if (auto const splits = crispy::split(params, ';'); splits.size() == 2 && splits[0] == "c")
-            return emitCommand<CopyToClipboard>(_output, crispy::base64::decode(splits[1]));
+        if (auto const splits = crispy::split(params, ';'); splits.size() == 2 && splits[0] == "c" && splits[1].empty())
+            return emitCommand<CopyToClipboard>(_output, _ctx.dataString());
         else
             return ApplyResult::Invalid;
     }
@@ -658,21 +660,21 @@ void CommandBuilder::handleAction(ActionClass _actionClass, Action _action, char
 #if 0
             sequence_.clear();
             sequence_.setCategory(FunctionCategory::Text);
-            sequence_.parameters().push_back({_currentChar});
+            sequence_.parameters().append(static_cast<Sequence::Parameter>(_currentChar));
             emitSequence(); // TODO: Not so sure I wanna stick with this! Rethink meh! :-) ^o^
 #else
-            emitCommand<AppendChar>(_currentChar);
+            textRun().push_back(_currentChar);
 #endif
             return;
         case Action::Param:
             if (sequence_.parameters().empty())
-                sequence_.parameters().push_back({0});
+                sequence_.parameters().append(0);
             if (_currentChar == ';')
-                sequence_.parameters().push_back({0});
+                sequence_.parameters().append(0);
             else if (_currentChar == ':')
-                sequence_.parameters().back().push_back({0});
+                sequence_.parameters().appendSubParameter(0);
             else
-                sequence_.parameters().back().back() = sequence_.parameters().back().back() * 10 + (_currentChar - U'0');
+                sequence_.parameters().appendDigit(_currentChar - U'0');
             return;
         case Action::CSI_Dispatch:
 			dispatchCSI(static_cast<char>(_currentChar));
@@ -685,38 +687,48 @@ void CommandBuilder::handleAction(ActionClass _actionClass, Action _action, char
             return;
         case Action::OSC_Start:
             sequence_.setCategory(FunctionCategory::OSC);
+            startPayload();
             break;
         case Action::OSC_Put:
         {
-            uint8_t u8[4];
-            size_t const count = unicode::to_utf8(_currentChar, u8);
-            for (size_t i = 0; i < count; ++i)
-                sequence_.intermediateCharacters().push_back(u8[i]);
+            char u8[4];
+            size_t const count = unicode::to_utf8(_currentChar, reinterpret_cast<uint8_t*>(u8));
+            putOSC(std::string_view(u8, count));
             break;
         }
         case Action::OSC_End:
         {
-            auto const [code, skipCount] = parseOSC(sequence_.intermediateCharacters());
-            sequence_.parameters().push_back({static_cast<Sequence::Parameter>(code)});
-            sequence_.intermediateCharacters().erase(0, skipCount);
-            emitSequence();
+            if (payloadDiscarded_)
+                log<InvalidOutputEvent>(sequence_.text(), fmt::format("OSC payload exceeds {} bytes.", maxPayloadSize_));
+            else
+            {
+                if (decodingClipboard_)
+                    clipboardDecoder_.finish(sequence_.dataString());
+                auto const [code, skipCount] = parseOSC(sequence_.intermediateCharacters());
+                sequence_.parameters().append(static_cast<Sequence::Parameter>(code));
+                sequence_.intermediateCharacters().erase(0, skipCount);
+                emitSequence();
+            }
             sequence_.clear();
             break;
         }
         case Action::Hook: // this is actually state DCS_PassThrough
             sequence_.setCategory(FunctionCategory::DCS);
             sequence_.setFinalChar(static_cast<char>(_currentChar));
+            startPayload();
             break;
         case Action::Put: // DCS_PassThrough: DCS data string
-            {
-                uint8_t u8[4];
-                size_t const count = unicode::to_utf8(_currentChar, u8);
-                for (size_t i = 0; i < count; ++i)
-                    sequence_.dataString().push_back(u8[i]);
-            }
+        {
+            char u8[4];
+            size_t const count = unicode::to_utf8(_currentChar, reinterpret_cast<uint8_t*>(u8));
+            putDCS(std::string_view(u8, count));
             break;
+        }
         case Action::Unhook: // DCS_PassThrough: DCS data string complete
-            emitSequence();
+            if (payloadDiscarded_)
+                log<InvalidOutputEvent>(sequence_.text(), fmt::format("DCS payload exceeds {} bytes.", maxPayloadSize_));
+            else
+                emitSequence();
             break;
         case Action::Ignore:
         case Action::Undefined:
@@ -724,6 +736,128 @@ void CommandBuilder::handleAction(ActionClass _actionClass, Action _action, char
     }
 }
 
+void CommandBuilder::print(std::string_view _text)
+{
+    std::u32string& run = textRun();
+    run.reserve(run.size() + _text.size());
+
+    auto decoderState = unicode::utf8_decoder_state{};
+    for (char const ch : _text)
+    {
+        auto const byte = static_cast<uint8_t>(ch);
+        if (byte < 0x80)
+            run.push_back(static_cast<char32_t>(byte));
+        else if (auto const result = unicode::from_utf8(decoderState, byte); std::holds_alternative<unicode::Success>(result))
+            run.push_back(std::get<unicode::Success>(result).value);
+    }
+}
+
+void CommandBuilder::put(Action _action, std::string_view _data)
+{
+    if (_action == Action::OSC_Put)
+        putOSC(_data);
+    else
+        putDCS(_data);
+}
+
+void CommandBuilder::startPayload()
+{
+    payloadSize_ = 0;
+    payloadDiscarded_ = false;
+    decodingClipboard_ = false;
+    clipboardDecoder_.reset();
+}
+
+bool CommandBuilder::acceptPayload(size_t _size)
+{
+    if (payloadDiscarded_)
+        return false;
+
+    payloadSize_ += _size;
+    if (payloadSize_ <= maxPayloadSize_)
+        return true;
+
+    // Release the memory already held by the oversized payload right away.
+    payloadDiscarded_ = true;
+    sequence_.intermediateCharacters() = {};
+    sequence_.dataString() = {};
+    return false;
+}
+
+void CommandBuilder::putOSC(std::string_view _data)
+{
+    if (!acceptPayload(_data.size()))
+        return;
+
+    if (decodingClipboard_)
+    {
+        clipboardDecoder_.decode(_data, sequence_.dataString());
+        return;
+    }
+
+    auto& buffer = sequence_.intermediateCharacters();
+    auto const oldSize = buffer.size();
+    buffer.append(_data);
+
+    // The data of OSC 52 (clipboard) is decoded as it arrives, once its header "52;Pc;" is complete,
+    // rather than buffering the base64 encoded form of potentially large clipboard contents.
+    if (buffer.size() > 3 && buffer.compare(0, 3, "52;") == 0)
+    {
+        if (auto const i = buffer.find(';', std::max(oldSize, size_t{3})); i != buffer.npos)
+        {
+            decodingClipboard_ = true;
+            clipboardDecoder_.decode(std::string_view(buffer).substr(i + 1), sequence_.dataString());
+            buffer.resize(i + 1);
+        }
+    }
+}
+
+void CommandBuilder::putDCS(std::string_view _data)
+{
+    if (acceptPayload(_data.size()))
+        sequence_.dataString().append(_data);
+}
+
+std::u32string& CommandBuilder::textRun()
+{
+    if (sink_)
+        return std::get<AppendText>(pendingText_).text;
+
+    if (commands_.empty() || !std::holds_alternative<AppendText>(commands_.back()))
+        commands_.emplace_back(AppendText{});
+
+    return std::get<AppendText>(commands_.back()).text;
+}
+
+void CommandBuilder::setSink(CommandSink _sink)
+{
+    flush();
+    sink_ = std::move(_sink);
+}
+
+void CommandBuilder::flush()
+{
+    if (!sink_)
+        return;
+
+    // Keeps the text buffer's capacity around for the next run.
+    if (auto& text = std::get<AppendText>(pendingText_).text; !text.empty())
+    {
+        sink_(pendingText_);
+        text.clear();
+    }
+}
+
+void CommandBuilder::dispatchCommands()
+{
+    flush();
+
+    for (Command const& command : commands_)
+        sink_(command);
+
+    commands_.clear();
+}
+
 void CommandBuilder::executeControlFunction(char _c0)
 {
 #if 0
@@ -785,22 +919,31 @@ void CommandBuilder::dispatchCSI(char _finalChar)
 
 void CommandBuilder::emitSequence()
 {
+    // The resulting commands are collected first and then passed to the sink exactly once,
+    // no matter whether the sequence was applied or turned out to be invalid.
+    auto const invalid = [this](InvalidCommand::Reason _reason) {
+        commands_.emplace_back(InvalidCommand{std::make_shared<Sequence const>(sequence_), _reason});
+    };
+
     if (FunctionDefinition const* funcSpec = select(sequence_.selector()); funcSpec != nullptr)
     {
         switch (apply(*funcSpec, sequence_, commands_))
         {
             case ApplyResult::Unsupported:
-                emitCommand<InvalidCommand>(sequence_, InvalidCommand::Reason::Unsupported);
+                invalid(InvalidCommand::Reason::Unsupported);
                 break;
             case ApplyResult::Invalid:
-                emitCommand<InvalidCommand>(sequence_, InvalidCommand::Reason::Invalid);
+                invalid(InvalidCommand::Reason::Invalid);
                 break;
             case ApplyResult::Ok:
                 break;
         }
     }
     else
-        emitCommand<InvalidCommand>(sequence_, InvalidCommand::Reason::Unknown);
+        invalid(InvalidCommand::Reason::Unknown);
+
+    if (sink_)
+        dispatchCommands();
 }
 
 std::optional<RGBColor> CommandBuilder::parseColor(std::string_view const& _value)
@@ -941,7 +1084,7 @@ ApplyResult apply(FunctionDefinition const& _function, Sequence const& _ctx, Com
         case DUMPSTATE: return emitCommand<DumpState>(_output);
 
         default:
-            return emitCommand<InvalidCommand>(_output, _ctx, InvalidCommand::Reason::Unsupported);
+            return emitCommand<InvalidCommand>(_output, std::make_shared<Sequence const>(_ctx), InvalidCommand::Reason::Unsupported);
     }
 }
 
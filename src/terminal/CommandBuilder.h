@@ -18,6 +18,9 @@
 #include <terminal/Functions.h>
 #include <terminal/Commands.h>
 
+#include <crispy/base64.h>
+
+#include <functional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -47,6 +50,12 @@ class CommandBuilder {
     using ActionClass = parser::ActionClass;
     using Action = parser::Action;
 
+    /// Receives each command as soon as it has been built.
+    using CommandSink = std::function<void(Command const&)>;
+
+    /// Default upper bound for the payload of a single OSC or DCS control string.
+    static constexpr size_t DefaultMaxPayloadSize = 8 * 1024 * 1024;
+
     /// Constructs the sequencer stage.
     ///
     /// @param _logger the logging object to be used when logging is needed.
@@ -58,11 +67,42 @@ class CommandBuilder {
 
     void clear() { commands_.clear(); }
 
+    /// Sets the sink to directly dispatch commands to, as they complete.
+    ///
+    /// With a sink installed, commands() is not populated anymore. Runs of text are
+    /// passed on once the next non-text command arrives or when flush() is invoked.
+    /// Passing an empty sink reverts back to collecting the commands into commands().
+    void setSink(CommandSink _sink);
+
+    bool hasSink() const noexcept { return static_cast<bool>(sink_); }
+
+    /// Dispatches any pending text run to the sink.
+    void flush();
+
+    /// Limits the number of payload bytes accepted for a single OSC or DCS control string.
+    ///
+    /// Control strings exceeding this limit are discarded as a whole once terminated.
+    void setMaxPayloadSize(size_t _value) noexcept { maxPayloadSize_ = _value; }
+    size_t maxPayloadSize() const noexcept { return maxPayloadSize_; }
+
     void operator()(ActionClass _actionClass, Action _action, char32_t _finalChar)
     {
         return handleAction(_actionClass, _action, _finalChar);
     }
 
+    /// Handles a run of printable UTF-8 text as passed by the parser's bulk text fast path.
+    ///
+    /// This is equivalent to receiving an Action::Print event for each codepoint in @p _text.
+    /// Consecutively printed text is merged into a single AppendText command.
+    void print(std::string_view _text);
+
+    /// Handles a run of raw payload bytes of an OSC or DCS control string as passed by the
+    /// parser's bulk payload fast path.
+    ///
+    /// This is equivalent to receiving an Action::OSC_Put (or Action::Put) event for each
+    /// codepoint in @p _data, without decoding and re-encoding it.
+    void put(Action _action, std::string_view _data);
+
     // helper methods
     //
     std::optional<RGBColor> static parseColor(std::string_view const& _value);
@@ -75,6 +115,22 @@ class CommandBuilder {
     void dispatchOSC();
     void emitSequence();
 
+    /// Starts receiving the payload of a new OSC or DCS control string.
+    void startPayload();
+    void putOSC(std::string_view _data);
+    void putDCS(std::string_view _data);
+
+    /// Accounts for @p _size more payload bytes.
+    ///
+    /// @returns false if the payload limit has been exceeded and the control string is to be discarded.
+    bool acceptPayload(size_t _size);
+
+    /// @returns the text run to append printed codepoints to.
+    std::u32string& textRun();
+
+    /// Passes all collected commands on to the sink, preceded by the pending text run.
+    void dispatchCommands();
+
     template <typename Event, typename... Args>
     void log(Args&&... args) const
     {
@@ -87,12 +143,22 @@ class CommandBuilder {
     {
         commands_.emplace_back(T{std::forward<Args>(args)...});
         // TODO: telemetry_.increment(...);
+        if (sink_)
+            dispatchCommands();
         return ApplyResult::Ok;
     }
 
   private:
     Sequence sequence_{};
     CommandList commands_{};
+    CommandSink sink_{};
+    Command pendingText_{AppendText{}}; // text run being built while a sink is installed
+
+    size_t maxPayloadSize_ = DefaultMaxPayloadSize;
+    size_t payloadSize_ = 0;                // payload bytes received for the current control string
+    bool payloadDiscarded_ = false;         // current control string exceeded maxPayloadSize_
+    bool decodingClipboard_ = false;        // OSC 52 data is being decoded into the data string
+    crispy::base64::Decoder clipboardDecoder_{};
     Logger const logger_;
 };
 
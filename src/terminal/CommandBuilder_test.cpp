@@ -38,33 +38,69 @@ TEST_CASE("CommandBuilder.parseColor", "[CommandBuilder]")
 TEST_CASE("CommandBuilder.utf8_single", "[CommandBuilder]")  // TODO: move to Parser_test
 {
     auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
-    auto parser = parser::Parser{ref(output)};
+    auto parser = parser::Parser{output};
 
     parser.parseFragment("\xC3\xB6");  // ö
 
     REQUIRE(1 == output.commands().size());
 
     Command const cmd = output.commands()[0];
-    REQUIRE(holds_alternative<AppendChar>(cmd));
-    AppendChar const& ch = get<AppendChar>(cmd);
+    REQUIRE(holds_alternative<AppendText>(cmd));
+    AppendText const& text = get<AppendText>(cmd);
 
-    REQUIRE(0xF6 == static_cast<unsigned>(ch.ch));
+    REQUIRE(text.text == U"\u00F6");
 }
 
 TEST_CASE("CommandBuilder.OSC_2", "[CommandBuilder]")
 {
     auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
-    auto parser = parser::Parser{ref(output)};
+    auto parser = parser::Parser{output};
     parser.parseFragment("\033]2;abcd\033\\");
     REQUIRE(1 == output.commands().size());
     REQUIRE(holds_alternative<terminal::ChangeWindowTitle>(output.commands()[0]));
     REQUIRE(get<ChangeWindowTitle>(output.commands()[0]).title == "abcd");
 }
 
+TEST_CASE("CommandBuilder.OSC_52", "[CommandBuilder]")
+{
+    auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
+    auto parser = parser::Parser{output};
+    auto const input = std::string("\033]52;c;Zm9v\r\nOmJhcg==\033\\");
+
+    SECTION("whole") {
+        parser.parseFragment(input);
+    }
+
+    SECTION("fragmented") {
+        for (char const ch : input)
+            parser.parseFragment(&ch, 1);
+    }
+
+    REQUIRE(1 == output.commands().size());
+    REQUIRE(holds_alternative<CopyToClipboard>(output.commands()[0]));
+    CHECK(get<CopyToClipboard>(output.commands()[0]).data == "foo:bar");
+}
+
+TEST_CASE("CommandBuilder.payload_limit", "[CommandBuilder]")
+{
+    auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
+    auto parser = parser::Parser{output};
+    output.setMaxPayloadSize(8);
+
+    parser.parseFragment("\033]2;0123456789\033\\");
+    parser.parseFragment("\033P$q01234567\"p\033\\");
+    CHECK(output.commands().empty());
+
+    parser.parseFragment("\033]2;abcd\033\\");
+    REQUIRE(1 == output.commands().size());
+    REQUIRE(holds_alternative<ChangeWindowTitle>(output.commands()[0]));
+    CHECK(get<ChangeWindowTitle>(output.commands()[0]).title == "abcd");
+}
+
 TEST_CASE("CommandBuilder.OSC_8", "[CommandBuilder]")
 {
     auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
-    auto parser = parser::Parser{ref(output)};
+    auto parser = parser::Parser{output};
     SECTION("no attribs") {
         parser.parseFragment("\033]8;;file://local/path/to\033\\");
         REQUIRE(1 == output.commands().size());
@@ -96,7 +132,7 @@ TEST_CASE("CommandBuilder.OSC_8", "[CommandBuilder]")
 TEST_CASE("CommandBuilder.sub_parameters", "[CommandBuilder]")
 {
     auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
-    auto parser = parser::Parser{ref(output)};
+    auto parser = parser::Parser{output};
 
     SECTION("curly underline") {
         parser.parseFragment("\033[4:3m");
@@ -119,21 +155,50 @@ TEST_CASE("CommandBuilder.utf8_middle", "[CommandBuilder]")  // TODO: move to Pa
     auto output = CommandBuilder{
             [&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
     auto parser = parser::Parser{
-            ref(output),
+            output,
             [&](auto const& msg) { UNSCOPED_INFO(fmt::format("parser: {}", msg)); }};
 
     parser.parseFragment("A\xC3\xB6Z");  // AöZ
 
+    REQUIRE(1 == output.commands().size());
+    REQUIRE(holds_alternative<AppendText>(output.commands()[0]));
+    REQUIRE(get<AppendText>(output.commands()[0]).text == U"A\u00F6Z");
+}
+
+TEST_CASE("CommandBuilder.text_runs", "[CommandBuilder]")
+{
+    auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
+    auto parser = parser::Parser{output};
+
+    // A UTF-8 sequence split across fragments still extends the same text run.
+    parser.parseFragment("AB\xC3");
+    parser.parseFragment("\xB6" "C\033[mDE");
+
     REQUIRE(3 == output.commands().size());
+    REQUIRE(get<AppendText>(output.commands()[0]).text == U"AB\u00F6C");
+    REQUIRE(holds_alternative<SetGraphicsRendition>(output.commands()[1]));
+    REQUIRE(get<AppendText>(output.commands()[2]).text == U"DE");
+}
 
-    REQUIRE(holds_alternative<AppendChar>(output.commands()[0]));
-    REQUIRE('A' == static_cast<unsigned>(get<AppendChar>(output.commands()[0]).ch));
+TEST_CASE("CommandBuilder.sink", "[CommandBuilder]")
+{
+    // Also contains an unknown sequence, which must be dispatched exactly once as well.
+    auto const input = std::string{"AB\033[1;31mC\r\nD\033]2;title\033\\E\033[>9Q\033[mF"};
+
+    auto recorded = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
+    parser::Parser{recorded}.parseFragment(input);
+
+    auto dispatched = CommandList{};
+    auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
+    output.setSink([&](Command const& _command) { dispatched.push_back(_command); });
+    parser::Parser{output}.parseFragment(input);
 
-    REQUIRE(holds_alternative<AppendChar>(output.commands()[1]));
-    REQUIRE(0xF6 == static_cast<unsigned>(get<AppendChar>(output.commands()[1]).ch));
+    // Trailing text is held back until flushed.
+    CHECK(output.commands().empty());
+    REQUIRE(dispatched.size() + 1 == recorded.commands().size());
+    output.flush();
 
-    REQUIRE(holds_alternative<AppendChar>(output.commands()[2]));
-    REQUIRE('Z' == static_cast<unsigned>(get<AppendChar>(output.commands()[2]).ch));
+    REQUIRE(to_mnemonic(dispatched, true, false) == to_mnemonic(recorded.commands(), true, false));
 }
 
 TEST_CASE("CommandBuilder.set_g1_special", "[CommandBuilder]")
@@ -141,7 +206,7 @@ TEST_CASE("CommandBuilder.set_g1_special", "[CommandBuilder]")
     auto output = CommandBuilder{
             [&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
     auto parser = parser::Parser{
-            ref(output),
+            output,
             [&](auto const& msg) { UNSCOPED_INFO(fmt::format("{}", msg)); }};
 
     parser.parseFragment("\033)0");
@@ -157,7 +222,7 @@ TEST_CASE("CommandBuilder.color_fg_indexed", "[CommandBuilder]")
     auto output = CommandBuilder{
             [&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
     auto parser = parser::Parser{
-            ref(output),
+            output,
             [&](auto const& msg) { UNSCOPED_INFO(fmt::format("{}", msg)); }};
 
     parser.parseFragment("\033[38;5;235m");
@@ -175,7 +240,7 @@ TEST_CASE("CommandBuilder.color_bg_indexed", "[CommandBuilder]")
     auto output = CommandBuilder{
             [&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
     auto parser = parser::Parser{
-            ref(output),
+            output,
             [&](auto const& msg) { UNSCOPED_INFO(fmt::format("{}", msg)); }};
 
     parser.parseFragment("\033[48;5;235m");
@@ -193,7 +258,7 @@ TEST_CASE("CommandBuilder.SETMARK", "[CommandBuilder]")
     auto output = CommandBuilder{
             [&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
     auto parser = parser::Parser{
-            ref(output),
+            output,
             [&](auto const& msg) { UNSCOPED_INFO(fmt::format("{}", msg)); }};
 
     parser.parseFragment("\033[>M");
@@ -205,7 +270,7 @@ TEST_CASE("CommandBuilder.SETMARK", "[CommandBuilder]")
 TEST_CASE("CommandBuilder.DCS_DECRQSS", "[CommandBuilder]")
 {
     auto output = CommandBuilder{[&](auto const& msg) { UNSCOPED_INFO(fmt::format("[CommandBuilder]: {}", msg)); }};
-    auto parser = parser::Parser{ref(output)};
+    auto parser = parser::Parser{output};
     parser.parseFragment("\033P$q\"p\033\\");
     REQUIRE(1 == output.commands().size());
     REQUIRE(holds_alternative<terminal::RequestStatusString>(output.commands()[0]));
@@ -391,6 +391,9 @@ class MnemonicBuilder {
     void operator()(AppendChar const& v) {
         pendingText_ += unicode::to_utf8(v.ch);
     }
+    void operator()(AppendText const& v) {
+        pendingText_ += unicode::to_utf8(v.text.data(), v.text.size());
+    }
 
     void operator()(SetDynamicColor const& v) {
         build("SETDYNCOLOR", fmt::format("{} {}", v.name, to_string(v.color)));
@@ -411,7 +414,7 @@ class MnemonicBuilder {
         build("DECTABSR");
     }
     void operator()(InvalidCommand  const& v) {
-        build("INVALID", fmt::format("{} ({})", v.sequence, v.reason));
+        build("INVALID", fmt::format("{} ({})", *v.sequence, v.reason));
     }
 
   private:
@@ -20,6 +20,7 @@
 
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -244,7 +245,8 @@ struct InvalidCommand {
         Unsupported,
         Invalid
     };
-    Sequence sequence;
+    /// Held by pointer to not inflate the size of every Command by the sequence's inline parameter storage.
+    std::shared_ptr<Sequence const> sequence;
     Reason reason;
 };
 
@@ -573,6 +575,9 @@ struct SetGraphicsRendition { GraphicsRendition rendition; };
 
 struct AppendChar { char32_t ch; };
 
+/// Appends a run of codepoints to the screen, equivalent to one AppendChar per codepoint.
+struct AppendText { std::u32string text; };
+
 struct SetMode { Mode mode; bool enable; };
 
 /// DECRQM - Request Mode
@@ -946,6 +951,7 @@ struct SetLogFilePathConfig {
 
 using Command = std::variant<
     AppendChar,
+    AppendText,
     ApplicationKeypadMode,
     BackIndex,
     Backspace,
@@ -1040,6 +1046,7 @@ class CommandVisitor {
     virtual ~CommandVisitor() = default;
 
     virtual void visit(AppendChar const& v) = 0;
+    virtual void visit(AppendText const& v) = 0;
     virtual void visit(ApplicationKeypadMode const& v) = 0;
     virtual void visit(BackIndex const& v) = 0;
     virtual void visit(Backspace const& v) = 0;
@@ -1123,6 +1130,7 @@ class CommandVisitor {
 
     // {{{ Secret std::visit() workaround
     void operator()(AppendChar const& v) { visit(v); }
+    void operator()(AppendText const& v) { visit(v); }
     void operator()(ApplicationKeypadMode const& v) { visit(v); }
     void operator()(BackIndex const& v) { visit(v); }
     void operator()(Backspace const& v) { visit(v); }
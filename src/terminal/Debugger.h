@@ -51,6 +51,7 @@ class Debugger : public CommandVisitor {
 
     // {{{ CommandExecutor overrides
     void visit(AppendChar const& v) override { enqueue(v); };
+    void visit(AppendText const& v) override { enqueue(v); };
     void visit(ApplicationKeypadMode const& v) override { enqueue(v); };
     void visit(BackIndex const& v) override { enqueue(v); };
     void visit(Backspace const& v) override { enqueue(v); };
@@ -32,7 +32,6 @@
 using crispy::times;
 using crispy::for_each;
 
-using std::accumulate;
 using std::array;
 using std::for_each;
 using std::pair;
@@ -45,27 +44,73 @@ namespace terminal {
 
 using Parameter = Sequence::Parameter;
 
-FunctionDefinition const* select(FunctionSelector const& _selector)
+namespace
 {
-    auto static const& funcs = functions();
+    /// Lookup structure for select(), built at compile time.
+    ///
+    /// Function definitions are grouped into buckets by category and final character, so
+    /// that a lookup only needs to compare against the very few definitions sharing both.
+    /// OSC functions are additionally indexed directly by their numeric code.
+    template <size_t N>
+    struct FunctionIndex
+    {
+        static constexpr size_t BucketCount = 5 * 0x80; // FunctionCategory x final character
+        static constexpr size_t MaxDirectOSC = 1024;
 
-    //std::cout << fmt::format("select: {}\n", _selector);
+        static constexpr size_t bucket(FunctionCategory _category, char _finalSymbol) noexcept
+        {
+            return static_cast<size_t>(_category) * 0x80 + (static_cast<size_t>(_finalSymbol) & 0x7F);
+        }
 
-    int a = 0;
-    int b = static_cast<int>(funcs.size()) - 1;
-    while (a <= b)
+        std::array<uint16_t, BucketCount + 1> offsets{};   // bucket i spans [offsets[i], offsets[i + 1])
+        std::array<FunctionDefinition, N> definitions{}; // ordered by bucket
+        std::array<uint16_t, MaxDirectOSC> osc{};         // OSC code -> index into definitions + 1, or 0
+    };
+
+    template <size_t N>
+    constexpr auto makeFunctionIndex(std::array<FunctionDefinition, N> const& _functions)
     {
-        auto const i = (a + b) / 2;
-        auto const& I = funcs[i];
-        auto const rel = compare(_selector, I);
-        //std::cout << fmt::format(" - a:{:>2} b:{:>2} i:{} rel:{} I: {}\n", a, b, i, rel < 0 ? '<' : rel > 0 ? '>' : '=', I);
-        if (rel > 0)
-            a = i + 1;
-        else if (rel < 0)
-            b = i - 1;
-        else
-            return &I;
+        using Index = FunctionIndex<N>;
+        auto index = Index{};
+
+        for (auto const& f : _functions)
+            ++index.offsets[Index::bucket(f.category, f.finalSymbol) + 1];
+
+        for (size_t i = 1; i < index.offsets.size(); ++i)
+            index.offsets[i] += index.offsets[i - 1];
+
+        auto next = index.offsets;
+        for (auto const& f : _functions)
+            index.definitions[next[Index::bucket(f.category, f.finalSymbol)]++] = f;
+
+        for (size_t i = 0; i < N; ++i)
+            if (auto const& f = index.definitions[i];
+                    f.category == FunctionCategory::OSC
+                    && 0 <= f.maximumParameters && static_cast<size_t>(f.maximumParameters) < Index::MaxDirectOSC)
+                index.osc[static_cast<size_t>(f.maximumParameters)] = static_cast<uint16_t>(i + 1);
+
+        return index;
     }
+
+    constexpr auto functionIndex = makeFunctionIndex(allFunctions);
+}
+
+FunctionDefinition const* select(FunctionSelector const& _selector)
+{
+    using Index = decltype(functionIndex);
+
+    if (_selector.category == FunctionCategory::OSC
+            && 0 <= _selector.argc && static_cast<size_t>(_selector.argc) < Index::MaxDirectOSC)
+    {
+        auto const i = functionIndex.osc[static_cast<size_t>(_selector.argc)];
+        return i ? &functionIndex.definitions[i - 1u] : nullptr;
+    }
+
+    auto const b = Index::bucket(_selector.category, _selector.finalSymbol);
+    for (auto i = functionIndex.offsets[b]; i < functionIndex.offsets[b + 1]; ++i)
+        if (compare(_selector, functionIndex.definitions[i]) == 0)
+            return &functionIndex.definitions[i];
+
     return nullptr;
 }
 
@@ -82,7 +127,7 @@ std::string Sequence::raw() const
         case FunctionCategory::OSC: sstr << "\033]"; break;
     }
 
-    if (parameterCount() > 1 || (parameterCount() == 1 && parameters_[0][0] != 0))
+    if (parameterCount() > 1 || (parameterCount() == 1 && parameters_.value(0) != 0))
     {
         for (auto i = 0u; i < parameterCount(); ++i)
         {
@@ -90,7 +135,7 @@ std::string Sequence::raw() const
                 sstr << ';';
 
             sstr << param(i);
-            for (auto k = 1u; k < subParameterCount(i); ++k)
+            for (auto k = 0u; k < subParameterCount(i); ++k)
                 sstr << ':' << subparam(i, k);
         }
     }
@@ -115,35 +160,18 @@ string Sequence::text() const
     if (leaderSymbol_)
         sstr << ' ' << leaderSymbol_;
 
-    if (parameterCount() > 1 || (parameterCount() == 1 && parameters_[0][0] != 0))
+    if (parameterCount() > 1 || (parameterCount() == 1 && parameters_.value(0) != 0))
     {
-        sstr << ' ' << accumulate(
-            begin(parameters_), end(parameters_), string{},
-            [](string const& a, auto const& p) -> string {
-                return !a.empty()
-                    ? fmt::format("{};{}",
-                            a,
-                            accumulate(
-                                begin(p), end(p),
-                                string{},
-                                [](string const& x, Sequence::Parameter y) -> string {
-                                    return !x.empty()
-                                        ? fmt::format("{}:{}", x, y)
-                                        : std::to_string(y);
-                                }
-                            )
-                        )
-                    : accumulate(
-                            begin(p), end(p),
-                            string{},
-                            [](string const& x, Sequence::Parameter y) -> string {
-                                return !x.empty()
-                                    ? fmt::format("{}:{}", x, y)
-                                    : std::to_string(y);
-                            }
-                        );
-            }
-        );
+        sstr << ' ';
+        for (size_t i = 0; i < parameterCount(); ++i)
+        {
+            if (i)
+                sstr << ';';
+
+            sstr << param(i);
+            for (size_t k = 0; k < subParameterCount(i); ++k)
+                sstr << ':' << subparam(i, k);
+        }
     }
 
     if (!intermediateCharacters().empty())
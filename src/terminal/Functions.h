@@ -20,6 +20,8 @@
 #include <fmt/format.h>
 
 #include <array>
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <string>
 #include <vector>
@@ -137,10 +139,78 @@ constexpr int compare(FunctionSelector const& a, FunctionDefinition const& b) no
 class Sequence {
   public:
     using Parameter = int;
-    using ParameterList = std::vector<std::vector<Parameter>>;
     using Intermediaries = std::string;
     using DataString = std::string;
 
+    size_t constexpr static MaxParameters = 16;
+    size_t constexpr static MaxSubParameters = 8;
+
+    /// Fixed-capacity storage for up to MaxParameters parameters, each carrying its value
+    /// plus up to MaxSubParameters - 1 sub-parameters.
+    ///
+    /// Parameters and sub-parameters exceeding the capacity are silently dropped, and
+    /// parameter values saturate rather than overflow, so that building a parameter list
+    /// never allocates.
+    class ParameterList {
+      public:
+        void clear() noexcept
+        {
+            count_ = 0;
+            discarding_ = false;
+        }
+
+        bool empty() const noexcept { return count_ == 0; }
+        size_t size() const noexcept { return count_; }
+
+        /// @returns the number of sub-parameters of parameter @p _index.
+        size_t subParameterCount(size_t _index) const noexcept { return counts_[_index] - 1; }
+
+        /// @returns parameter @p _index, or its sub-parameter @p _subIndex - 1 if @p _subIndex is non-zero.
+        Parameter value(size_t _index, size_t _subIndex = 0) const noexcept { return values_[_index][_subIndex]; }
+
+        /// Starts a new parameter with the given initial value.
+        void append(Parameter _value) noexcept
+        {
+            discarding_ = count_ == MaxParameters;
+            if (discarding_)
+                return;
+
+            values_[count_][0] = _value;
+            counts_[count_] = 1;
+            ++count_;
+        }
+
+        /// Starts a new sub-parameter of the most recently started parameter.
+        void appendSubParameter(Parameter _value) noexcept
+        {
+            if (discarding_ || counts_[count_ - 1] == MaxSubParameters)
+            {
+                discarding_ = true;
+                return;
+            }
+
+            values_[count_ - 1][counts_[count_ - 1]++] = _value;
+        }
+
+        /// Appends a decimal digit to the most recently started (sub-)parameter.
+        void appendDigit(unsigned _digit) noexcept
+        {
+            if (discarding_)
+                return;
+
+            auto& value = values_[count_ - 1][counts_[count_ - 1] - 1];
+            value = value <= (std::numeric_limits<Parameter>::max() - 9) / 10
+                  ? value * 10 + static_cast<Parameter>(_digit)
+                  : std::numeric_limits<Parameter>::max();
+        }
+
+      private:
+        std::array<std::array<Parameter, MaxSubParameters>, MaxParameters> values_{};
+        std::array<uint8_t, MaxParameters> counts_{};
+        size_t count_ = 0;
+        bool discarding_ = false; // whether the (sub-)parameter currently being parsed got dropped
+    };
+
   private:
     FunctionCategory category_;
     char leaderSymbol_ = 0;
@@ -150,17 +220,6 @@ class Sequence {
     DataString dataString_;
 
   public:
-    size_t constexpr static MaxParameters = 16;
-    size_t constexpr static MaxSubParameters = 8;
-
-    Sequence()
-    {
-        parameters_.resize(MaxParameters);
-        for (auto& param : parameters_)
-            param.reserve(MaxSubParameters);
-        parameters_.clear();
-    }
-
     // mutators
     //
     void clear()
@@ -194,7 +253,7 @@ class Sequence {
         switch (category_)
         {
             case FunctionCategory::OSC:
-                return FunctionSelector{category_, 0, parameters_[0][0], 0, 0};
+                return FunctionSelector{category_, 0, parameters_.value(0), 0, 0};
             default:
             {
                 // Only support CSI sequences with 0 or 1 intermediate characters.
@@ -215,12 +274,12 @@ class Sequence {
 
     ParameterList const& parameters() const noexcept { return parameters_; }
     size_t parameterCount() const noexcept { return parameters_.size(); }
-    size_t subParameterCount(size_t _index) const noexcept { return parameters_[_index].size() - 1; }
+    size_t subParameterCount(size_t _index) const noexcept { return parameters_.subParameterCount(_index); }
 
     std::optional<Parameter> param_opt(size_t _index) const noexcept
     {
-        if (_index < parameters_.size() && parameters_[_index][0])
-            return {parameters_[_index][0]};
+        if (_index < parameters_.size() && parameters_.value(_index))
+            return {parameters_.value(_index)};
         else
             return std::nullopt;
     }
@@ -233,15 +292,14 @@ class Sequence {
     int param(size_t _index) const noexcept
     {
         assert(_index < parameters_.size());
-        assert(0 < parameters_[_index].size());
-        return parameters_[_index][0];
+        return parameters_.value(_index);
     }
 
     int subparam(size_t _index, size_t _subIndex) const noexcept
     {
         assert(_index < parameters_.size());
-        assert(_subIndex + 1 < parameters_[_index].size());
-        return parameters_[_index][_subIndex + 1];
+        assert(_subIndex < parameters_.subParameterCount(_index));
+        return parameters_.value(_index, _subIndex + 1);
     }
 };
 
@@ -432,118 +490,122 @@ constexpr inline auto RCOLORMOUSEBG = detail::OSC(114, "RCOLORMOUSEBG", "Reset m
 constexpr inline auto NOTIFY        = detail::OSC(777, "NOTIFY", "Send Notification.");
 constexpr inline auto DUMPSTATE     = detail::OSC(888, "DUMPSTATE", "Dumps internal state to debug stream.");
 
+/// All known function definitions, in no particular order.
+constexpr inline auto allFunctions = std::array{ // {{{
+    // C0
+    EOT,
+    BEL,
+    BS,
+    TAB,
+    LF,
+    VT,
+    FF,
+    CR,
+    SO,
+    SI,
+
+    // ESC
+    DECALN,
+    DECBI,
+    DECFI,
+    DECKPAM,
+    DECKPNM,
+    DECRS,
+    DECSC,
+    HTS,
+    IND,
+    NEL,
+    RI,
+    RIS,
+    SCS_G0_SPECIAL,
+    SCS_G0_USASCII,
+    SCS_G1_SPECIAL,
+    SCS_G1_USASCII,
+    SS2,
+    SS3,
+
+    // CSI
+    ANSISYSSC,
+    CBT,
+    CHA,
+    CNL,
+    CPL,
+    CPR,
+    CUB,
+    CUD,
+    CUF,
+    CUP,
+    CUU,
+    DA1,
+    DA2,
+    DA3,
+    DCH,
+    DECDC,
+    DECIC,
+    DECRM,
+    DECRQM,
+    DECRQM_ANSI,
+    DECRQPSR,
+    DECSCL,
+    DECSCUSR,
+    DECSLRM,
+    DECSM,
+    DECSTBM,
+    DECSTR,
+    DECXCPR,
+    DL,
+    ECH,
+    ED,
+    EL,
+    HPA,
+    HPR,
+    HVP,
+    ICH,
+    IL,
+    RM,
+    SCOSC,
+    SD,
+    SETMARK,
+    SGR,
+    SM,
+    SU,
+    TBC,
+    VPA,
+    WINMANIP,
+
+    // DCS
+    DECRQSS,
+
+    // OSC
+    SETICON,
+    SETTITLE,
+    SETWINTITLE,
+    SETXPROP,
+    HYPERLINK,
+    COLORFG,
+    COLORBG,
+    COLORCURSOR,
+    COLORMOUSEFG,
+    COLORMOUSEBG,
+    CLIPBOARD,
+    COLORSPECIAL,
+    RCOLORFG,
+    RCOLORBG,
+    RCOLORCURSOR,
+    RCOLORMOUSEFG,
+    RCOLORMOUSEBG,
+    NOTIFY,
+    DUMPSTATE,
+}; // }}}
+
+/// @returns all known function definitions, ordered by compare().
 inline auto const& functions()
 {
-    static auto const funcs = []() constexpr { // {{{
-        auto f = std::array{
-            // C0
-            EOT,
-            BEL,
-            BS,
-            TAB,
-            LF,
-            VT,
-            FF,
-            CR,
-            SO,
-            SI,
-
-            // ESC
-            DECALN,
-            DECBI,
-            DECFI,
-            DECKPAM,
-            DECKPNM,
-            DECRS,
-            DECSC,
-            HTS,
-            IND,
-            NEL,
-            RI,
-            RIS,
-            SCS_G0_SPECIAL,
-            SCS_G0_USASCII,
-            SCS_G1_SPECIAL,
-            SCS_G1_USASCII,
-            SS2,
-            SS3,
-
-            // CSI
-            ANSISYSSC,
-            CBT,
-            CHA,
-            CNL,
-            CPL,
-            CPR,
-            CUB,
-            CUD,
-            CUF,
-            CUP,
-            CUU,
-            DA1,
-            DA2,
-            DA3,
-            DCH,
-            DECDC,
-            DECIC,
-            DECRM,
-            DECRQM,
-            DECRQM_ANSI,
-            DECRQPSR,
-            DECSCL,
-            DECSCUSR,
-            DECSLRM,
-            DECSM,
-            DECSTBM,
-            DECSTR,
-            DECXCPR,
-            DL,
-            ECH,
-            ED,
-            EL,
-            HPA,
-            HPR,
-            HVP,
-            ICH,
-            IL,
-            RM,
-            SCOSC,
-            SD,
-            SETMARK,
-            SGR,
-            SM,
-            SU,
-            TBC,
-            VPA,
-            WINMANIP,
-
-            // DCS
-            DECRQSS,
-
-            // OSC
-            SETICON,
-            SETTITLE,
-            SETWINTITLE,
-            SETXPROP,
-            HYPERLINK,
-            COLORFG,
-            COLORBG,
-            COLORCURSOR,
-            COLORMOUSEFG,
-            COLORMOUSEBG,
-            CLIPBOARD,
-            COLORSPECIAL,
-            RCOLORFG,
-            RCOLORBG,
-            RCOLORCURSOR,
-            RCOLORMOUSEFG,
-            RCOLORMOUSEBG,
-            NOTIFY,
-            DUMPSTATE,
-        };
+    static auto const funcs = []() constexpr {
+        auto f = allFunctions;
         crispy::sort(f, [](FunctionDefinition const& a, FunctionDefinition const& b) constexpr { return compare(a, b); });
         return f;
-    }();  // }}}
+    }();
 
 #if 0
     for (auto [a, b] : crispy::indexed(funcs))
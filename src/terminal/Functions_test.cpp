@@ -70,3 +70,93 @@ TEST_CASE("Functions.OSC777", "[Functions]")
     REQUIRE(osc);
     CHECK(*osc == NOTIFY);
 }
+
+TEST_CASE("Sequence.parameters", "[Functions]")
+{
+    auto seq = Sequence{};
+    auto& params = seq.parameters();
+
+    // "1;38:2:10:20:30;4"
+    params.append(1);
+    params.append(3);
+    params.appendDigit(8);
+    for (auto const value : {2, 10, 20, 30})
+        params.appendSubParameter(value);
+    params.append(4);
+
+    REQUIRE(seq.parameterCount() == 3);
+    CHECK(seq.param(0) == 1);
+    CHECK(seq.param(1) == 38);
+    REQUIRE(seq.subParameterCount(1) == 4);
+    CHECK(seq.subparam(1, 0) == 2);
+    CHECK(seq.subparam(1, 3) == 30);
+    CHECK(seq.subParameterCount(2) == 0);
+    CHECK(seq.param(2) == 4);
+}
+
+TEST_CASE("Sequence.parameters_overflow", "[Functions]")
+{
+    auto seq = Sequence{};
+    auto& params = seq.parameters();
+
+    for (size_t i = 0; i < Sequence::MaxParameters + 4; ++i)
+    {
+        params.append(0);
+        params.appendDigit(static_cast<unsigned>(i % 10));
+    }
+    REQUIRE(seq.parameterCount() == Sequence::MaxParameters);
+    CHECK(seq.param(Sequence::MaxParameters - 1) == (Sequence::MaxParameters - 1) % 10);
+
+    params.clear();
+    params.append(1);
+    for (size_t i = 0; i < Sequence::MaxSubParameters + 2; ++i)
+        params.appendSubParameter(7);
+    params.appendDigit(9); // belongs to a dropped sub-parameter
+    params.append(2);
+    REQUIRE(seq.parameterCount() == 2);
+    CHECK(seq.subParameterCount(0) == Sequence::MaxSubParameters - 1);
+    CHECK(seq.subparam(0, Sequence::MaxSubParameters - 2) == 7);
+    CHECK(seq.param(1) == 2);
+
+    // Values saturate instead of overflowing.
+    params.clear();
+    params.append(0);
+    for (int i = 0; i < 20; ++i)
+        params.appendDigit(9);
+    CHECK(seq.param(0) == std::numeric_limits<Sequence::Parameter>::max());
+}
+
+TEST_CASE("Functions.select_matches_table", "[Functions]")
+{
+    // Reference lookup: a linear scan over all known functions.
+    auto const reference = [](FunctionSelector const& _selector) -> FunctionDefinition const* {
+        for (auto const& f : functions())
+            if (compare(_selector, f) == 0)
+                return &f;
+        return nullptr;
+    };
+
+    for (auto const category : {FunctionCategory::ESC, FunctionCategory::CSI, FunctionCategory::DCS})
+        for (auto const leader : {'\0', '<', '=', '>', '?'})
+            for (auto const intermediate : {'\0', ' ', '!', '"', '$', '\'', '*'})
+                for (char finalSymbol = 0x30; finalSymbol < 0x7F; ++finalSymbol)
+                    for (int argc = 0; argc <= 4; ++argc)
+                    {
+                        auto const selector = FunctionSelector{category, leader, argc, intermediate, finalSymbol};
+                        auto const expected = reference(selector);
+                        auto const actual = select(selector);
+                        INFO(fmt::format("{}", selector));
+                        REQUIRE(!!actual == !!expected);
+                        if (actual)
+                            CHECK(*actual == *expected);
+                    }
+
+    for (int code = 0; code < 2000; ++code)
+    {
+        auto const expected = reference(FunctionSelector{FunctionCategory::OSC, 0, code, 0, 0});
+        auto const actual = selectOSCommand(code);
+        REQUIRE(!!actual == !!expected);
+        if (actual)
+            CHECK(*actual == *expected);
+    }
+}
@@ -0,0 +1,138 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Hyperlink.h>
+
+#include <algorithm>
+
+using std::min;
+using std::string;
+
+namespace terminal {
+
+HyperlinkStorage::HyperlinkStorage(size_t _capacity) :
+    capacity_{min(_capacity, MaxCapacity)}
+{
+}
+
+HyperlinkId HyperlinkStorage::add(string const& _id, string const& _uri)
+{
+    if (!_id.empty())
+    {
+        if (auto const i = named_.find(_id); i != named_.end())
+        {
+            Entry& e = entries_[i->second - 1];
+            if (e.info.uri == _uri)
+            {
+                lru_.splice(lru_.begin(), lru_, e.lru);
+                return i->second;
+            }
+        }
+    }
+
+    if (full())
+        return 0;
+
+    HyperlinkId id{};
+    if (!freeIds_.empty())
+    {
+        id = freeIds_.back();
+        freeIds_.pop_back();
+    }
+    else
+    {
+        entries_.emplace_back();
+        id = static_cast<HyperlinkId>(entries_.size());
+    }
+
+    Entry& e = entries_[id - 1];
+    e.info = HyperlinkInfo{_id, _uri};
+    e.lru = lru_.insert(lru_.begin(), id);
+    e.used = true;
+    e.marked = false;
+
+    // A named hyperlink being redefined with another URI replaces the former for new text.
+    if (!_id.empty())
+        named_[_id] = id;
+
+    return id;
+}
+
+HyperlinkStorage::Entry* HyperlinkStorage::entry(HyperlinkId _id) noexcept
+{
+    if (_id == 0 || _id > entries_.size() || !entries_[_id - 1].used)
+        return nullptr;
+
+    return &entries_[_id - 1];
+}
+
+HyperlinkInfo* HyperlinkStorage::hyperlinkById(HyperlinkId _id) noexcept
+{
+    if (Entry* e = entry(_id); e != nullptr)
+        return &e->info;
+
+    return nullptr;
+}
+
+HyperlinkInfo const* HyperlinkStorage::hyperlinkById(HyperlinkId _id) const noexcept
+{
+    return const_cast<HyperlinkStorage*>(this)->hyperlinkById(_id);
+}
+
+void HyperlinkStorage::mark(HyperlinkId _id) noexcept
+{
+    if (Entry* e = entry(_id); e != nullptr)
+        e->marked = true;
+}
+
+size_t HyperlinkStorage::sweep(size_t _count)
+{
+    size_t evicted = 0;
+    auto i = lru_.end();
+    while (i != lru_.begin())
+    {
+        --i;
+        Entry& e = entries_[*i - 1];
+        if (e.marked || evicted == _count)
+            e.marked = false;
+        else
+        {
+            release(*i);
+            i = lru_.erase(i);
+            ++evicted;
+        }
+    }
+    return evicted;
+}
+
+void HyperlinkStorage::release(HyperlinkId _id)
+{
+    Entry& e = entries_[_id - 1];
+
+    if (auto const i = named_.find(e.info.id); i != named_.end() && i->second == _id)
+        named_.erase(i);
+
+    e.info = HyperlinkInfo{};
+    e.used = false;
+    freeIds_.push_back(_id);
+}
+
+void HyperlinkStorage::clear()
+{
+    entries_.clear();
+    freeIds_.clear();
+    lru_.clear();
+    named_.clear();
+}
+
+} // end namespace
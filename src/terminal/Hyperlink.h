@@ -13,10 +13,14 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <list>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <list>
-#include <memory>
+#include <vector>
 
 namespace terminal {
 
@@ -70,8 +74,69 @@ struct HyperlinkInfo { // TODO: rename to Hyperlink
     }
 };
 
-using HyperlinkRef = std::shared_ptr<HyperlinkInfo>;
-
 bool is_local(HyperlinkInfo const& _hyperlink);
 
+/// Identifies a hyperlink within its HyperlinkStorage, with 0 meaning no hyperlink at all.
+using HyperlinkId = uint16_t;
+
+/// Registry of all hyperlinks of a screen buffer, handing out small ids for cells to refer to them.
+///
+/// Hyperlinks are kept in least recently used order. Once the storage is full,
+/// hyperlinks no cell refers to anymore have to be evicted, least recently used first,
+/// using mark() and sweep(), or the capacity has to be raised via reserve().
+class HyperlinkStorage {
+  public:
+    static constexpr size_t DefaultCapacity = 1024;
+    static constexpr size_t MaxCapacity = std::numeric_limits<HyperlinkId>::max();
+
+    explicit HyperlinkStorage(size_t _capacity = DefaultCapacity);
+
+    size_t size() const noexcept { return lru_.size(); }
+    size_t capacity() const noexcept { return capacity_; }
+    bool full() const noexcept { return size() >= capacity_; }
+
+    /// Raises the capacity to @p _capacity, bounded by MaxCapacity. Never lowers it.
+    void reserve(size_t _capacity) noexcept { capacity_ = std::min(std::max(capacity_, _capacity), MaxCapacity); }
+
+    /// Registers a hyperlink, or looks up an already registered one with the same @p _id and @p _uri.
+    ///
+    /// Hyperlinks with an empty @p _id are anonymous and thus always registered anew.
+    ///
+    /// @returns the hyperlink's id, or 0 if it is not registered yet and the storage is full.
+    HyperlinkId add(std::string const& _id, std::string const& _uri);
+
+    /// @returns the hyperlink with the given id or nullptr if there is none.
+    HyperlinkInfo* hyperlinkById(HyperlinkId _id) noexcept;
+    HyperlinkInfo const* hyperlinkById(HyperlinkId _id) const noexcept;
+
+    /// Marks the given hyperlink as being in use, protecting it from the next sweep().
+    void mark(HyperlinkId _id) noexcept;
+
+    /// Evicts up to @p _count hyperlinks that have not been marked, least recently used first,
+    /// and clears the marks of all others.
+    ///
+    /// @returns the number of evicted hyperlinks.
+    size_t sweep(size_t _count);
+
+    void clear();
+
+  private:
+    struct Entry {
+        HyperlinkInfo info;
+        std::list<HyperlinkId>::iterator lru;
+        bool used = false;
+        bool marked = false;
+    };
+
+    Entry* entry(HyperlinkId _id) noexcept;
+    /// Frees the entry of the given hyperlink, except for its position in lru_.
+    void release(HyperlinkId _id);
+
+    size_t capacity_;
+    std::vector<Entry> entries_;                    // indexed by HyperlinkId - 1
+    std::vector<HyperlinkId> freeIds_;              // ids of unused entries
+    std::list<HyperlinkId> lru_;                    // ids in use, most recently used first
+    std::unordered_map<std::string, HyperlinkId> named_;  // ids of non-anonymous hyperlinks
+};
+
 } // end namespace
@@ -0,0 +1,93 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Hyperlink.h>
+#include <catch2/catch.hpp>
+
+using terminal::HyperlinkId;
+using terminal::HyperlinkStorage;
+
+TEST_CASE("HyperlinkStorage.add", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage{};
+
+    auto const a = storage.add("a", "file:///a");
+    auto const b = storage.add("b", "file:///b");
+    CHECK(a != 0);
+    CHECK(b != 0);
+    CHECK(a != b);
+
+    // Same id and URI refer to the same hyperlink.
+    CHECK(storage.add("a", "file:///a") == a);
+
+    // Anonymous hyperlinks are always distinct.
+    auto const c = storage.add("", "file:///c");
+    CHECK(storage.add("", "file:///c") != c);
+
+    // Reusing an id for another URI defines a new hyperlink.
+    auto const a2 = storage.add("a", "file:///other");
+    CHECK(a2 != a);
+    CHECK(storage.hyperlinkById(a)->uri == "file:///a");
+    CHECK(storage.hyperlinkById(a2)->uri == "file:///other");
+
+    CHECK(storage.hyperlinkById(0) == nullptr);
+    CHECK(storage.size() == 5);
+}
+
+TEST_CASE("HyperlinkStorage.sweep", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage{3};
+
+    auto const a = storage.add("a", "file:///a");
+    auto const b = storage.add("b", "file:///b");
+    auto const c = storage.add("c", "file:///c");
+    CHECK(storage.full());
+    CHECK(storage.add("d", "file:///d") == 0);
+
+    // Using "a" again makes "b" the least recently used hyperlink.
+    CHECK(storage.add("a", "file:///a") == a);
+
+    CHECK(storage.sweep(1) == 1);
+    CHECK(storage.hyperlinkById(b) == nullptr);
+    CHECK(storage.hyperlinkById(a) != nullptr);
+    CHECK(storage.hyperlinkById(c) != nullptr);
+
+    // Marked hyperlinks are never evicted.
+    storage.mark(c);
+    CHECK(storage.sweep(2) == 1);
+    CHECK(storage.hyperlinkById(a) == nullptr);
+    CHECK(storage.hyperlinkById(c)->uri == "file:///c");
+
+    // Freed ids are reused, and evicted names are forgotten.
+    auto const d = storage.add("d", "file:///d");
+    CHECK((d == a || d == b));
+    CHECK(storage.add("a", "file:///a") != 0);
+    CHECK(storage.full());
+}
+
+TEST_CASE("HyperlinkStorage.reserve", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage{1};
+    CHECK(storage.add("a", "file:///a") != 0);
+    CHECK(storage.add("b", "file:///b") == 0);
+
+    storage.reserve(2);
+    CHECK(storage.add("b", "file:///b") != 0);
+    CHECK(storage.full());
+
+    // The capacity is never lowered and bounded by what a HyperlinkId can address.
+    storage.reserve(1);
+    CHECK(storage.capacity() == 2);
+    storage.reserve(HyperlinkStorage::MaxCapacity + 1);
+    CHECK(storage.capacity() == HyperlinkStorage::MaxCapacity);
+}
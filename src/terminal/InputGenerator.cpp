@@ -390,17 +390,6 @@ bool InputGenerator::generate(Key _key, Modifier _modifier)
     return false;
 }
 
-void InputGenerator::generatePaste(std::string_view const& _text)
-{
-    if (bracketedPaste_)
-        append("\033[200~"sv);
-
-    append(_text);
-
-    if (bracketedPaste_)
-        append("\033[201~"sv);
-}
-
 void InputGenerator::swap(Sequence& _other)
 {
     std::swap(pendingSequence_, _other);
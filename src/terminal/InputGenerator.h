@@ -367,9 +367,6 @@ class InputGenerator {
     /// Generates input sequence for a pressed special key.
     bool generate(Key _key, Modifier _modifier);
 
-    /// Generates input sequence for bracketed paste text.
-    void generatePaste(std::string_view const& _text);
-
     /// Generates input sequence for a mouse button press event.
     bool generate(MousePressEvent const& _mousePress);
 
@@ -419,6 +419,7 @@ void OutputGenerator::operator()(Command const& command)
             {
                 currentForegroundColor_ = DefaultColor{};
                 currentBackgroundColor_ = DefaultColor{};
+                currentUnderlineColor_ = DefaultColor{};
             }
         },
         [&](DesignateCharset v) {
@@ -440,6 +441,7 @@ void OutputGenerator::operator()(Command const& command)
             }
         },
         [&](AppendChar const& v) { write(v.ch); },
+        [&](AppendText const& v) { write(unicode::to_utf8(v.text.data(), v.text.size())); },
         [&](ChangeIconTitle const& v) { write("\033]1;{}\033\\", v.title); },
         [&](ChangeWindowTitle const& v) { write("\033]2;{}\033\\", v.title); },
         [&](SoftTerminalReset) { write("\033[!p"); },
@@ -452,7 +454,7 @@ void OutputGenerator::operator()(Command const& command)
         },
         [&](SaveWindowTitle const&) { write("\033[22;0;0t"); },
         [&](RestoreWindowTitle const&) { write("\033[23;0;0t"); },
-        [&](InvalidCommand const& v) { write(v.sequence.raw()); }
+        [&](InvalidCommand const& v) { write(v.sequence->raw()); }
     }, command);
 }
 
@@ -0,0 +1,227 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PageFile.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using std::max;
+using std::string;
+using std::string_view;
+
+namespace terminal {
+
+namespace {
+    constexpr size_t MinCapacity = 1024 * 1024;
+
+#if defined(__unix__) || defined(__APPLE__)
+    /// @returns the directories to create the file in, in order of preference.
+    ///
+    /// Disk-backed locations are preferred, as /tmp is usually a tmpfs, which would keep
+    /// the spilled history in memory (or swap) after all.
+    std::vector<string> temporaryDirectories()
+    {
+        auto directories = std::vector<string>{};
+
+        if (char const* cacheHome = getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome)
+            directories.emplace_back(cacheHome);
+        else if (char const* home = getenv("HOME"); home && *home)
+            directories.emplace_back(string(home) + "/.cache");
+
+        directories.emplace_back("/var/tmp");
+
+        if (char const* tmpdir = getenv("TMPDIR"); tmpdir && *tmpdir)
+            directories.emplace_back(tmpdir);
+
+        directories.emplace_back("/tmp");
+        return directories;
+    }
+
+    int createTemporaryFile()
+    {
+        for (string const& directory : temporaryDirectories())
+        {
+            auto path = directory + "/contour-history-XXXXXX";
+            if (int const fd = mkstemp(path.data()); fd != -1)
+            {
+                unlink(path.c_str());
+                return fd;
+            }
+        }
+
+        return -1;
+    }
+
+    /// Grows the file from @p _size to @p _capacity bytes, allocating its blocks up front.
+    ///
+    /// A sparse file would have its blocks allocated only when writing to the mapping,
+    /// which raises SIGBUS rather than reporting an error if the disk is full.
+    bool growFile(int _fd, size_t _size, size_t _capacity)
+    {
+#if defined(__APPLE__)
+        // There is no posix_fallocate() on macOS, so the blocks are reserved via fcntl().
+        auto store = fstore_t{F_ALLOCATEALL, F_PEOFPOSMODE, 0, static_cast<off_t>(_capacity - _size), 0};
+        if (fcntl(_fd, F_PREALLOCATE, &store) == -1)
+            return false;
+        return ftruncate(_fd, static_cast<off_t>(_capacity)) == 0;
+#else
+        return posix_fallocate(_fd, static_cast<off_t>(_size), static_cast<off_t>(_capacity - _size)) == 0;
+#endif
+    }
+#endif
+}
+
+PageFile::PageFile(PageFile&& _other) noexcept :
+    pages_{std::move(_other.pages_)},
+    fd_{std::exchange(_other.fd_, -1)},
+    failed_{_other.failed_},
+    data_{std::exchange(_other.data_, nullptr)},
+    capacity_{std::exchange(_other.capacity_, 0)},
+    end_{std::exchange(_other.end_, 0)},
+    heap_{std::move(_other.heap_)}
+{
+    _other.pages_.clear();
+}
+
+PageFile& PageFile::operator=(PageFile&& _other) noexcept
+{
+    if (this != &_other)
+    {
+        release();
+        pages_ = std::move(_other.pages_);
+        fd_ = std::exchange(_other.fd_, -1);
+        failed_ = _other.failed_;
+        data_ = std::exchange(_other.data_, nullptr);
+        capacity_ = std::exchange(_other.capacity_, 0);
+        end_ = std::exchange(_other.end_, 0);
+        heap_ = std::move(_other.heap_);
+        _other.pages_.clear();
+    }
+    return *this;
+}
+
+PageFile::~PageFile()
+{
+    release();
+}
+
+void PageFile::release() noexcept
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if (fd_ != -1)
+    {
+        munmap(data_, capacity_);
+        close(fd_);
+    }
+#endif
+    fd_ = -1;
+    data_ = nullptr;
+    capacity_ = 0;
+    end_ = 0;
+    pages_.clear();
+    heap_.clear();
+}
+
+void PageFile::push_back(string_view _bytes)
+{
+    if (end_ + _bytes.size() > capacity_)
+    {
+        compact();
+        if (end_ + _bytes.size() > capacity_)
+            reserve(max({2 * capacity_, end_ + _bytes.size(), MinCapacity}));
+    }
+
+    std::memcpy(data_ + end_, _bytes.data(), _bytes.size());
+    pages_.push_back(Extent{end_, _bytes.size()});
+    end_ += _bytes.size();
+}
+
+void PageFile::pop_front()
+{
+    pages_.pop_front();
+    if (pages_.empty())
+        end_ = 0;
+}
+
+void PageFile::clear()
+{
+    pages_.clear();
+    end_ = 0;
+}
+
+void PageFile::compact()
+{
+    if (pages_.empty())
+    {
+        end_ = 0;
+        return;
+    }
+
+    // Only worth moving the pages in use if that frees up more than it moves.
+    auto const begin = pages_.front().offset;
+    if (begin < end_ - begin)
+        return;
+
+    std::memmove(data_, data_ + begin, end_ - begin);
+    for (Extent& page : pages_)
+        page.offset -= begin;
+    end_ -= begin;
+}
+
+void PageFile::reserve(size_t _capacity)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if (fd_ == -1 && !failed_ && capacity_ == 0)
+        fd_ = createTemporaryFile();
+
+    if (fd_ != -1)
+    {
+        // Map the grown file before unmapping the old mapping, so that nothing is lost on failure.
+        if (growFile(fd_, capacity_, _capacity))
+        {
+            if (void* data = mmap(nullptr, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0); data != MAP_FAILED)
+            {
+                if (data_)
+                    munmap(data_, capacity_);
+                data_ = static_cast<char*>(data);
+                capacity_ = _capacity;
+                return;
+            }
+        }
+
+        // Continue in memory with what has been stored so far.
+        heap_.assign(data_, data_ + end_);
+        if (data_)
+            munmap(data_, capacity_);
+        close(fd_);
+        fd_ = -1;
+    }
+    failed_ = true;
+#endif
+
+    heap_.resize(_capacity);
+    data_ = heap_.data();
+    capacity_ = _capacity;
+}
+
+} // end namespace
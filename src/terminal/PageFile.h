@@ -0,0 +1,78 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string_view>
+#include <vector>
+
+namespace terminal {
+
+/// Queue of pages of bytes, stored in a memory-mapped temporary file.
+///
+/// The file is created on first use, preferably in $XDG_CACHE_HOME or /var/tmp, and unlinked
+/// right away, so it is private to the process and vanishes with it. Pages are appended at the
+/// back and dropped from the front, with the space of dropped pages being reclaimed once it
+/// outweighs the pages still in use.
+///
+/// If no such file can be created or grown, e.g. because the disk is full (or the platform
+/// lacks mmap), pages are kept in memory instead.
+class PageFile {
+  public:
+    PageFile() = default;
+    PageFile(PageFile const&) = delete;
+    PageFile& operator=(PageFile const&) = delete;
+    PageFile(PageFile&& _other) noexcept;
+    PageFile& operator=(PageFile&& _other) noexcept;
+    ~PageFile();
+
+    /// Number of pages.
+    size_t size() const noexcept { return pages_.size(); }
+    bool empty() const noexcept { return pages_.empty(); }
+
+    /// Whether pages are actually stored in a file rather than in memory.
+    bool fileBacked() const noexcept { return fd_ != -1; }
+
+    /// @returns the bytes of the given page, valid until the next modification.
+    std::string_view operator[](size_t _index) const noexcept
+    {
+        auto const& page = pages_[_index];
+        return std::string_view{data_ + page.offset, page.size};
+    }
+
+    void push_back(std::string_view _bytes);
+    void pop_front();
+    void clear();
+
+  private:
+    struct Extent {
+        size_t offset;
+        size_t size;
+    };
+
+    void reserve(size_t _capacity);
+    void compact();
+    void release() noexcept;
+
+    std::deque<Extent> pages_;
+    int fd_ = -1;                   // the backing file, or -1 if none
+    bool failed_ = false;           // whether creating or growing the file has failed before
+    char* data_ = nullptr;          // the mapped file, or heap_.data() if there is no file
+    size_t capacity_ = 0;           // number of bytes available at data_
+    size_t end_ = 0;                // end of the last page
+    std::vector<char> heap_;        // storage if there is no file
+};
+
+} // end namespace
@@ -0,0 +1,98 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PageFile.h>
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using std::string;
+using terminal::PageFile;
+
+TEST_CASE("PageFile.push_back", "[pagefile]")
+{
+    auto pages = PageFile{};
+    CHECK(pages.empty());
+
+    pages.push_back("hello");
+    pages.push_back("");
+    pages.push_back("world");
+
+    REQUIRE(pages.size() == 3);
+    CHECK(pages[0] == "hello");
+    CHECK(pages[1] == "");
+    CHECK(pages[2] == "world");
+}
+
+TEST_CASE("PageFile.pop_front", "[pagefile]")
+{
+    auto pages = PageFile{};
+    pages.push_back("a");
+    pages.push_back("b");
+
+    pages.pop_front();
+    REQUIRE(pages.size() == 1);
+    CHECK(pages[0] == "b");
+
+    pages.pop_front();
+    CHECK(pages.empty());
+
+    pages.push_back("c");
+    REQUIRE(pages.size() == 1);
+    CHECK(pages[0] == "c");
+}
+
+TEST_CASE("PageFile.growth_and_compaction", "[pagefile]")
+{
+    // Pages of 64 KiB each, exceeding the initial capacity many times over
+    // while dropped pages keep being reclaimed.
+    auto pages = PageFile{};
+    auto const page = [](size_t _n) { return string(64 * 1024, static_cast<char>('A' + _n % 26)); };
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+        pages.push_back(page(i));
+        if (pages.size() > 8)
+            pages.pop_front();
+    }
+
+    REQUIRE(pages.size() == 8);
+    for (size_t i = 0; i < 8; ++i)
+        CHECK(pages[i] == page(192 + i));
+}
+
+TEST_CASE("PageFile.move", "[pagefile]")
+{
+    auto pages = PageFile{};
+    pages.push_back("moved");
+
+    auto other = std::move(pages);
+    REQUIRE(other.size() == 1);
+    CHECK(other[0] == "moved");
+
+    pages = std::move(other);
+    REQUIRE(pages.size() == 1);
+    CHECK(pages[0] == "moved");
+}
+
+TEST_CASE("PageFile.clear", "[pagefile]")
+{
+    auto pages = PageFile{};
+    pages.push_back("x");
+    pages.clear();
+    CHECK(pages.empty());
+
+    pages.push_back("y");
+    REQUIRE(pages.size() == 1);
+    CHECK(pages[0] == "y");
+}
@@ -23,11 +23,26 @@
 #include <array>
 #include <cctype>
 #include <cstdio>
+#include <cstring>
 #include <map>
 #include <ostream>
 
 #include <fmt/format.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIBTERMINAL_PARSER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define LIBTERMINAL_PARSER_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace terminal::parser {
 
 using namespace std;
@@ -36,6 +51,140 @@ using Transition = pair<State, State>;
 using Range = ParserTable::Range;
 using RangeSet = std::vector<Range>;
 
+namespace // {{{ text scanning helpers
+{
+    inline unsigned countTrailingZeros(uint32_t _value) noexcept
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, _value);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(_value));
+#endif
+    }
+
+    /// @returns iterator to the first byte that is not within 0x20..0x7F.
+    inline uint8_t const* scanPrintableASCII(uint8_t const* _begin, uint8_t const* _end) noexcept
+    {
+        auto input = _begin;
+
+        // Comparing the bytes as *signed* values against 0x1F yields true exactly for 0x20..0x7F,
+        // as all C0 codes are below and all bytes with the high bit set are negative.
+#if defined(LIBTERMINAL_PARSER_AVX2)
+        auto const controlMax32 = _mm256_set1_epi8(0x1F);
+        while (_end - input >= 32)
+        {
+            auto const bytes = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input));
+            auto const mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(bytes, controlMax32)));
+            if (mask != 0xFFFFFFFFu)
+                return input + countTrailingZeros(~mask);
+            input += 32;
+        }
+#endif
+
+#if defined(LIBTERMINAL_PARSER_SSE2)
+        auto const controlMax16 = _mm_set1_epi8(0x1F);
+        while (_end - input >= 16)
+        {
+            auto const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input));
+            auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(bytes, controlMax16)));
+            if (mask != 0xFFFFu)
+                return input + countTrailingZeros(~mask & 0xFFFFu);
+            input += 16;
+        }
+#endif
+
+        while (input != _end && 0x20 <= *input && *input <= 0x7F)
+            ++input;
+
+        return input;
+    }
+
+    /// @returns the length of the UTF-8 sequence at @p _begin if it is complete, well-formed
+    ///          and decodes to a printable codepoint (U+00A0 or above), 0 otherwise.
+    ///
+    /// Overlong encodings, surrogates and codepoints beyond U+10FFFF are rejected here,
+    /// so that they are handled (and replaced) by the UTF-8 decoder of the state machine.
+    inline size_t printableSequenceLength(uint8_t const* _begin, uint8_t const* _end) noexcept
+    {
+        auto const lead = *_begin;
+
+        size_t length = 0;
+        char32_t codepoint = 0;
+        char32_t minimum = 0;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2;
+            codepoint = lead & 0x1F;
+            minimum = 0xA0; // also excludes C1 control codes (U+0080..U+009F)
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3;
+            codepoint = lead & 0x0F;
+            minimum = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4;
+            codepoint = lead & 0x07;
+            minimum = 0x10000;
+        }
+        else
+            return 0;
+
+        if (static_cast<size_t>(_end - _begin) < length)
+            return 0; // Incomplete sequences are left to the UTF-8 decoder of the state machine.
+
+        for (size_t i = 1; i < length; ++i)
+        {
+            if ((_begin[i] & 0xC0) != 0x80)
+                return 0;
+            codepoint = (codepoint << 6) | (_begin[i] & 0x3F);
+        }
+
+        if (codepoint < minimum || codepoint > 0x10FFFF)
+            return 0;
+
+        if (0xD800 <= codepoint && codepoint <= 0xDFFF)
+            return 0;
+
+        return length;
+    }
+} // }}}
+
+uint8_t const* scanText(uint8_t const* _begin, uint8_t const* _end) noexcept
+{
+    auto input = _begin;
+
+    while (input != _end)
+    {
+        input = scanPrintableASCII(input, _end);
+        if (input == _end || *input < 0x80)
+            break;
+
+        auto const sequenceLength = printableSequenceLength(input, _end);
+        if (!sequenceLength)
+            break;
+
+        input += sequenceLength;
+    }
+
+    return input;
+}
+
+uint8_t const* scanDataString(uint8_t const* _begin, uint8_t const* _end) noexcept
+{
+    auto const end = scanPrintableASCII(_begin, _end);
+
+    // DEL is ignored in DCS data strings, unlike in printable text.
+    if (auto const del = static_cast<uint8_t const*>(memchr(_begin, 0x7F, static_cast<size_t>(end - _begin))); del)
+        return del;
+
+    return end;
+}
+
 void dot(std::ostream& _os, ParserTable const& _table)
 {
     // (State, Byte) -> State
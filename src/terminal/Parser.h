@@ -27,11 +27,16 @@
 #include <limits>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
 #include <fmt/format.h>
 
+namespace terminal {
+class CommandBuilder;
+}
+
 namespace terminal::parser { // {{{ enum class types
 
 enum class State : uint8_t {
@@ -703,6 +708,34 @@ constexpr ParserTable ParserTable::get() // {{{
     return t;
 } // }}}
 
+/// Scans for printable text starting at @p _begin.
+///
+/// Printable text is any run of bytes in the range 0x20..0x7F as well as complete UTF-8
+/// sequences decoding to codepoints at or above U+00A0, that is, anything that the parser
+/// would turn into an Action::Print event while in ground state.
+///
+/// @returns an iterator right after the last byte of the printable run.
+uint8_t const* scanText(uint8_t const* _begin, uint8_t const* _end) noexcept;
+
+/// Scans for a run of DCS data string bytes in the range 0x20..0x7E starting at @p _begin.
+///
+/// @returns an iterator right after the last byte of the run.
+uint8_t const* scanDataString(uint8_t const* _begin, uint8_t const* _end) noexcept;
+
+namespace detail {
+    template <typename T, typename = void>
+    struct has_print : std::false_type {};
+
+    template <typename T>
+    struct has_print<T, std::void_t<decltype(std::declval<T&>().print(std::string_view{}))>> : std::true_type {};
+
+    template <typename T, typename = void>
+    struct has_put : std::false_type {};
+
+    template <typename T>
+    struct has_put<T, std::void_t<decltype(std::declval<T&>().put(Action{}, std::string_view{}))>> : std::true_type {};
+}
+
 /**
  * Terminal Parser.
  *
@@ -711,15 +744,23 @@ constexpr ParserTable ParserTable::get() // {{{
  *
  * The code comments for enum values have been mostly copied into this source for better
  * understanding when working with this parser.
+ *
+ * The parser is parametrized over its event listener, so that the listener can be inlined
+ * into the state machine. The listener must be invocable as
+ * `listener(ActionClass, Action, char32_t)` and is never passed Action::Undefined nor
+ * Action::Ignore. If it also provides `print(std::string_view)`, whole runs of printable
+ * text (UTF-8 encoded) are passed there instead of one Action::Print event per codepoint.
+ * Likewise, if it provides `put(Action, std::string_view)`, runs of OSC and DCS payload bytes
+ * are passed there as-is instead of one Action::OSC_Put (or Action::Put) event per codepoint.
  */
+template <typename EventListener = CommandBuilder>
 class Parser {
   public:
-    using ActionHandler = std::function<void(ActionClass, Action, char32_t)>;
     using ParseError = std::function<void(std::string const&)>;
     using iterator = uint8_t const*;
 
-    Parser(ActionHandler _actionHandler, ParseError _parseError = {}) :
-        actionHandler_{std::move(_actionHandler)},
+    explicit Parser(EventListener& _listener, ParseError _parseError = {}) :
+        listener_{_listener},
         parseError_{ std::move(_parseError) }
     {
     }
@@ -738,21 +779,57 @@ class Parser {
 
   private:
     void processInput(char32_t _ch);
+    void printText(iterator _begin, iterator _end);
+    void putData(Action _action, iterator _begin, iterator _end);
+    void handle(ActionClass _actionClass, Action _action, char32_t _ch);
 
   private:
     State state_ = State::Ground;
     unicode::utf8_decoder_state utf8DecoderState_{};
 
-    ActionHandler actionHandler_;
+    EventListener& listener_;
     ParseError const parseError_;
 };
 
-inline void Parser::parseFragment(iterator _begin, iterator _end)
+template <typename EventListener>
+inline void Parser<EventListener>::parseFragment(iterator _begin, iterator _end)
 {
     static constexpr char32_t ReplacementCharacter {0xFFFD};
 
-    for (auto const current : crispy::range(_begin, _end))
+    auto input = _begin;
+    while (input != _end)
     {
+        // Bulk fast path: Hand over whole runs of printable text while in ground state
+        // and not in the middle of a UTF-8 sequence.
+        if (state_ == State::Ground && !utf8DecoderState_.expectedLength)
+        {
+            if (auto const textEnd = scanText(input, _end); textEnd != input)
+            {
+                printText(input, textEnd);
+                input = textEnd;
+                continue;
+            }
+        }
+        else if (state_ == State::OSC_String && !utf8DecoderState_.expectedLength)
+        {
+            // OSC payload characters are exactly what would be printed while in ground state.
+            if (auto const dataEnd = scanText(input, _end); dataEnd != input)
+            {
+                putData(Action::OSC_Put, input, dataEnd);
+                input = dataEnd;
+                continue;
+            }
+        }
+        else if (state_ == State::DCS_PassThrough && !utf8DecoderState_.expectedLength)
+        {
+            if (auto const dataEnd = scanDataString(input, _end); dataEnd != input)
+            {
+                putData(Action::Put, input, dataEnd);
+                input = dataEnd;
+                continue;
+            }
+        }
+
         std::visit(
             overloaded{
                 [&](unicode::Incomplete) {},
@@ -766,12 +843,49 @@ inline void Parser::parseFragment(iterator _begin, iterator _end)
                     processInput(success.value);
                 },
             },
-            unicode::from_utf8(utf8DecoderState_, current)
+            unicode::from_utf8(utf8DecoderState_, *input++)
         );
     }
 }
 
-inline void Parser::processInput(char32_t _ch)
+template <typename EventListener>
+inline void Parser<EventListener>::printText(iterator _begin, iterator _end)
+{
+    if constexpr (detail::has_print<EventListener>::value)
+        listener_.print(std::string_view{reinterpret_cast<char const*>(_begin), static_cast<size_t>(_end - _begin)});
+    else
+    {
+        // No bulk text sink available, so emit the equivalent per-codepoint Print events instead.
+        auto decoderState = unicode::utf8_decoder_state{};
+        for (auto const current : crispy::range(_begin, _end))
+            if (auto const result = unicode::from_utf8(decoderState, current); std::holds_alternative<unicode::Success>(result))
+                listener_(ActionClass::Event, Action::Print, std::get<unicode::Success>(result).value);
+    }
+}
+
+template <typename EventListener>
+inline void Parser<EventListener>::putData(Action _action, iterator _begin, iterator _end)
+{
+    if constexpr (detail::has_put<EventListener>::value)
+        listener_.put(_action, std::string_view{reinterpret_cast<char const*>(_begin), static_cast<size_t>(_end - _begin)});
+    else
+    {
+        auto decoderState = unicode::utf8_decoder_state{};
+        for (auto const current : crispy::range(_begin, _end))
+            if (auto const result = unicode::from_utf8(decoderState, current); std::holds_alternative<unicode::Success>(result))
+                listener_(ActionClass::Event, _action, std::get<unicode::Success>(result).value);
+    }
+}
+
+template <typename EventListener>
+inline void Parser<EventListener>::handle(ActionClass _actionClass, Action _action, char32_t _ch)
+{
+    if (_action != Action::Undefined && _action != Action::Ignore)
+        listener_(_actionClass, _action, _ch);
+}
+
+template <typename EventListener>
+inline void Parser<EventListener>::processInput(char32_t _ch)
 {
     auto const s = static_cast<size_t>(state_);
 
@@ -781,14 +895,13 @@ inline void Parser::processInput(char32_t _ch)
 
     if (auto const t = table.transitions[s][ch]; t != State::Undefined)
     {
-        // actionHandler_(_actionClass, _action, currentChar());
-        actionHandler_(ActionClass::Leave, table.exitEvents[s], _ch);
-        actionHandler_(ActionClass::Transition, table.events[s][ch], _ch);
+        handle(ActionClass::Leave, table.exitEvents[s], _ch);
+        handle(ActionClass::Transition, table.events[s][ch], _ch);
         state_ = t;
-        actionHandler_(ActionClass::Enter, table.entryEvents[static_cast<size_t>(t)], _ch);
+        handle(ActionClass::Enter, table.entryEvents[static_cast<size_t>(t)], _ch);
     }
     else if (Action const a = table.events[s][ch]; a != Action::Undefined)
-        actionHandler_(ActionClass::Event, a, _ch);
+        handle(ActionClass::Event, a, _ch);
     else if (parseError_)
         parseError_(fmt::format("Parser Error: Unknown action for state/input pair ({}, 0x{:02X})", state_, static_cast<uint32_t>(ch)));
 }
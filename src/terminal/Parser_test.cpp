@@ -14,9 +14,119 @@
 #include <terminal/Parser.h>
 #include <catch2/catch.hpp>
 
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
 using namespace std;
 using namespace terminal;
+using namespace terminal::parser;
+
+namespace
+{
+    using Event = tuple<ActionClass, Action, char32_t>;
+
+    struct EventRecorder {
+        vector<Event> events;
+
+        void operator()(ActionClass _class, Action _action, char32_t _ch)
+        {
+            events.emplace_back(_class, _action, _ch);
+        }
+    };
+
+    struct TextRecorder : EventRecorder {
+        string text;
+
+        void print(string_view _text) { text += _text; }
+    };
+
+    vector<Event> parseEvents(string const& _input, size_t _fragmentSize)
+    {
+        auto recorder = EventRecorder{};
+        auto parser = Parser{recorder};
+        for (size_t i = 0; i < _input.size(); i += _fragmentSize)
+            parser.parseFragment(_input.data() + i, min(_fragmentSize, _input.size() - i));
+        return move(recorder.events);
+    }
+}
 
 TEST_CASE("Parser_subparams", "[parser]")
 {
 }
+
+TEST_CASE("Parser.scanText", "[parser]")
+{
+    auto const scan = [](string const& _text) -> size_t {
+        auto const begin = reinterpret_cast<uint8_t const*>(_text.data());
+        return static_cast<size_t>(scanText(begin, begin + _text.size()) - begin);
+    };
+
+    CHECK(scan("") == 0);
+    CHECK(scan("Hello, World!") == 13);
+    CHECK(scan("Hello\nWorld") == 5);
+    CHECK(scan("0123456789abcdef0123456789abcdef0123456789\033[m") == 42);
+    CHECK(scan("\xC3\xB6\xE2\x82\xAC\xF0\x9F\x98\x80.") == 10); // "ö€😀."
+    CHECK(scan("ab\xC3") == 2);        // incomplete UTF-8 sequence
+    CHECK(scan("ab\xC3Z") == 2);       // invalid UTF-8 sequence
+    CHECK(scan("ab\xC2\x9B") == 2);    // C1 control code (CSI) encoded as UTF-8
+    CHECK(scan("ab\xC1\xBF") == 2);    // overlong 2-byte encoding
+    CHECK(scan("ab\xE0\x9F\xBF") == 2); // overlong 3-byte encoding
+    CHECK(scan("ab\xF0\x8F\xBF\xBF") == 2); // overlong 4-byte encoding
+    CHECK(scan("ab\xED\xA0\x80") == 2); // UTF-16 surrogate (U+D800)
+    CHECK(scan("ab\xF4\x90\x80\x80") == 2); // beyond U+10FFFF
+}
+
+TEST_CASE("Parser.text_fast_path_equivalence", "[parser]")
+{
+    auto const input = string(
+        "Hello \033[1;31mWorld\033[m\r\n"
+        "\xC3\xB6\xE2\x82\xAC\xF0\x9F\x98\x80 text\x07"
+        "\033]2;title\033\\"
+        "0123456789abcdef0123456789abcdef0123456789abcdef\x7F\t"
+        "\xC2\x85ZZ"
+    );
+
+    auto const expected = parseEvents(input, input.size());
+
+    // Undefined and Ignore actions are never dispatched.
+    for (auto const& event : expected)
+    {
+        CHECK(get<1>(event) != Action::Undefined);
+        CHECK(get<1>(event) != Action::Ignore);
+    }
+
+    // Feeding the input byte by byte splits all UTF-8 sequences across fragments
+    // and must therefore yield the very same events as when parsed as a whole.
+    CHECK(parseEvents(input, 1) == expected);
+    CHECK(parseEvents(input, 3) == expected);
+    CHECK(parseEvents(input, 17) == expected);
+
+    auto const printed = [&]() {
+        auto count = 0;
+        for (auto const& event : expected)
+            if (get<1>(event) == Action::Print)
+                ++count;
+        return count;
+    }();
+    CHECK(printed == 6 + 5 + 8 + 49 + 2);
+}
+
+TEST_CASE("Parser.print_handler", "[parser]")
+{
+    auto recorder = TextRecorder{};
+    auto parser = Parser{recorder};
+
+    parser.parseFragment("AB\xC3");
+    parser.parseFragment("\xB6" "CD\r\nEF");
+
+    CHECK(recorder.text == "ABCDEF");
+    auto const& events = recorder.events;
+
+    // Only the UTF-8 sequence split across fragments went through the state machine.
+    REQUIRE(events.size() == 3);
+    CHECK(events[0] == Event{ActionClass::Event, Action::Print, U'\u00F6'});
+    CHECK(events[1] == Event{ActionClass::Event, Action::Execute, U'\r'});
+    CHECK(events[2] == Event{ActionClass::Event, Action::Execute, U'\n'});
+}
@@ -36,7 +36,7 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/ioctl.h>
-#include <sys/select.h>
+#include <poll.h>
 #include <unistd.h>
 #endif
 
@@ -118,6 +118,11 @@ PseudoTerminal::PseudoTerminal(Size const& _windowSize) :
     // TODO: termios term{};
     if (openpty(&master_, &slave_, nullptr, /*&term*/ nullptr, wsa) < 0)
         throw runtime_error{ "Failed to open PTY. " + GetLastErrorAsString() };
+
+    // The master is non-blocking for good, so that output can be drained without
+    // toggling its flags on every read.
+    if (fcntl(master_, F_SETFL, fcntl(master_, F_GETFL) | O_NONBLOCK) < 0)
+        throw runtime_error{ "Failed to configure PTY. " + GetLastErrorAsString() };
 #else
     master_ = INVALID_HANDLE_VALUE;
     input_ = INVALID_HANDLE_VALUE;
@@ -191,46 +196,31 @@ void PseudoTerminal::close()
 auto PseudoTerminal::read(char* buf, size_t size) -> ssize_t
 {
 #if defined(__unix__) || defined(__APPLE__)
-    ssize_t rv = ::read(master_, buf, size);
-    if (rv < 0 || rv >= static_cast<decltype(rv)>(size))
-        return rv;
-#if 1
-    //size_t const cap = size;
-    ssize_t nread = rv;
-    int i = 1;
-    size -= rv;
-    buf += rv;
-
-    auto const oldFlags = fcntl(master_, F_GETFL);
-    fcntl(master_, F_SETFL, oldFlags | O_NONBLOCK);
-
-    fd_set in, out, err;
-    FD_ZERO(&in);
-    FD_ZERO(&out);
-    FD_ZERO(&err);
-    FD_SET(master_, &in);
-
-    while (size > 0)
+    // Waits for output, and then reads all there is, up to the given size.
+    if (master_ < 0)
+        return -1;
+
+    ssize_t nread = 0;
+    while (nread == 0)
     {
-        ++i;
-        timeval tv{0, 0};
-        int const selected = select(master_ + 1, &in, &out, &err, &tv);
-        if (selected <= 0)
-            break;
-        rv = ::read(master_, buf, size);
-        if (rv < 0)
-            break;
-        nread += rv;
-        size -= rv;
-        buf += rv;
+        auto pfd = pollfd{ master_, POLLIN, 0 };
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+            return -1;
+
+        while (nread < static_cast<ssize_t>(size))
+        {
+            auto const rv = ::read(master_, buf + nread, size - static_cast<size_t>(nread));
+            if (rv > 0)
+                nread += rv;
+            else if (rv < 0 && errno == EINTR)
+                continue;
+            else if (rv < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            else
+                return nread != 0 ? nread : -1;
+        }
     }
-
-    fcntl(master_, F_SETFL, oldFlags);
-    //printf("pty.read: %zu/%zu bytes (%ld%%, #%d)\n", nread, cap, nread * 100 / cap, i);
     return nread;
-#else
-    return rv;
-#endif
 #else
     DWORD nread{};
     if (ReadFile(input_, buf, static_cast<DWORD>(size), &nread, nullptr))
@@ -243,7 +233,22 @@ auto PseudoTerminal::read(char* buf, size_t size) -> ssize_t
 auto PseudoTerminal::write(char const* buf, size_t size) -> ssize_t
 {
 #if defined(__unix__) || defined(__APPLE__)
-    return ::write(master_, buf, size);
+    // Waits for the non-blocking master to accept more whenever the slave side is not reading.
+    size_t nwritten = 0;
+    while (nwritten < size)
+    {
+        auto const rv = ::write(master_, buf + nwritten, size - nwritten);
+        if (rv >= 0)
+            nwritten += static_cast<size_t>(rv);
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            auto pfd = pollfd{ master_, POLLOUT, 0 };
+            poll(&pfd, 1, -1);
+        }
+        else if (errno != EINTR)
+            return nwritten != 0 ? static_cast<ssize_t>(nwritten) : -1;
+    }
+    return static_cast<ssize_t>(nwritten);
 #else
     DWORD nwritten{};
     if (WriteFile(output_, buf, static_cast<DWORD>(size), &nwritten, nullptr))
@@ -253,6 +258,24 @@ auto PseudoTerminal::write(char const* buf, size_t size) -> ssize_t
 #endif
 }
 
+auto PseudoTerminal::tryWrite(char const* buf, size_t size) -> ssize_t
+{
+#if defined(__unix__) || defined(__APPLE__)
+    for (;;)
+    {
+        auto const rv = ::write(master_, buf, size);
+        if (rv >= 0)
+            return rv;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        else if (errno != EINTR)
+            return -1;
+    }
+#else
+    return write(buf, size);
+#endif
+}
+
 Size PseudoTerminal::screenSize() const noexcept
 {
     return size_;
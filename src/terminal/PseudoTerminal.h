@@ -60,6 +60,9 @@ public:
 
 	/// Reads from the terminal whatever has been written to from the other side of the terminal.
 	///
+	/// Waits until there is something to read. The master handle itself is non-blocking,
+	/// for being read from without waiting, such as by the PtyReactor.
+	///
 	/// @param buf    Target buffer to store the received data to.
 	/// @param size	  Capacity of parameter @p buf. At most @p size bytes will be stored into it.
 	///
@@ -74,6 +77,11 @@ public:
 	/// @returns Number of bytes written or -1 on error.
 	auto write(char const* buf, size_t size) -> ssize_t;
 
+	/// Writes to the PTY device as much as it accepts without waiting.
+	///
+	/// @returns Number of bytes written, which is 0 if the PTY is not accepting any, or -1 on error.
+	auto tryWrite(char const* buf, size_t size) -> ssize_t;
+
     /// @returns current underlying window size in characters width and height.
     Size screenSize() const noexcept;
 
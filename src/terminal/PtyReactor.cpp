@@ -0,0 +1,390 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyReactor.h>
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace terminal {
+
+namespace {
+    constexpr PtyReactor::Id WakeupId = 0;
+
+    /// Marks the events of a source's file descriptor duplicate watched for writability.
+    constexpr PtyReactor::Id WritableFlag = PtyReactor::Id{1} << 63;
+}
+
+PtyReactor::Source::~Source()
+{
+    if (writeFd >= 0)
+        ::close(writeFd);
+}
+
+PtyReactor::PtyReactor(size_t _workerCount) :
+    epollFd_{ epoll_create1(EPOLL_CLOEXEC) },
+    wakeupFd_{ eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) }
+{
+    if (epollFd_ < 0 || wakeupFd_ < 0)
+        throw runtime_error{ string("Failed to set up PTY reactor. ") + strerror(errno) };
+
+    auto event = epoll_event{};
+    event.events = EPOLLIN;
+    event.data.u64 = WakeupId;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeupFd_, &event) < 0)
+        throw runtime_error{ string("Failed to set up PTY reactor. ") + strerror(errno) };
+
+    ioThread_ = thread{ [this]() { ioThread(); } };
+    for (size_t i = 0; i < max(_workerCount, size_t{1}); ++i)
+        workers_.emplace_back([this]() { workerThread(); });
+}
+
+PtyReactor::~PtyReactor()
+{
+    {
+        auto _l = lock_guard{ mutex_ };
+        stopping_ = true;
+    }
+    uint64_t const one = 1;
+    (void) ::write(wakeupFd_, &one, sizeof(one));
+    workAvailable_.notify_all();
+
+    ioThread_.join();
+    for (thread& worker : workers_)
+        worker.join();
+
+    ::close(wakeupFd_);
+    ::close(epollFd_);
+}
+
+PtyReactor& PtyReactor::shared()
+{
+    static PtyReactor reactor;
+    return reactor;
+}
+
+size_t PtyReactor::defaultWorkerCount() noexcept
+{
+    return clamp(thread::hardware_concurrency() / 2, 1u, 4u);
+}
+
+PtyReactor::Id PtyReactor::add(int _fd, OutputHandler _onOutput, CloseHandler _onClose, WritableHandler _onWritable)
+{
+    auto _l = lock_guard{ mutex_ };
+    auto const id = nextId_++;
+    auto const& source = *sources_.emplace(id, make_unique<Source>(_fd,
+                                                                   move(_onOutput),
+                                                                   move(_onClose),
+                                                                   move(_onWritable))).first->second;
+
+    auto event = epoll_event{};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = id;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, source.fd, &event) < 0)
+    {
+        sources_.erase(id);
+        throw runtime_error{ string("Failed to watch PTY. ") + strerror(errno) };
+    }
+
+    return id;
+}
+
+void PtyReactor::remove(Id _id)
+{
+    auto _l = unique_lock{ mutex_ };
+    auto i = sources_.find(_id);
+    if (i == sources_.end())
+        return;
+
+    auto& source = *i->second;
+    unwatch(source);
+
+    source.removed = true;
+
+    if (source.scheduled && source.handlerThread == this_thread::get_id())
+    {
+        // Called by a handler of this very source, which is erased once it returns.
+        source.orphaned = true;
+        return;
+    }
+
+    sourceIdle_.wait(_l, [&]() { return !source.reading && !source.writing && !source.scheduled; });
+    sources_.erase(i);
+}
+
+void PtyReactor::rearm(Id _id, Source const& _source)
+{
+    auto event = epoll_event{};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = _id;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, _source.fd, &event);
+}
+
+void PtyReactor::watchWritable(Id _id)
+{
+    auto _l = lock_guard{ mutex_ };
+    auto i = sources_.find(_id);
+    if (i == sources_.end() || i->second->removed || i->second->closed || !i->second->onWritable)
+        return;
+
+    // Watched even while the handler is running, as it may have missed the input just queued.
+    rearmWritable(_id, *i->second);
+}
+
+void PtyReactor::rearmWritable(Id _id, Source& _source)
+{
+    auto event = epoll_event{};
+    event.events = EPOLLOUT | EPOLLONESHOT;
+    event.data.u64 = _id | WritableFlag;
+
+    if (_source.writeFd >= 0)
+    {
+        epoll_ctl(epollFd_, EPOLL_CTL_MOD, _source.writeFd, &event);
+        return;
+    }
+
+    // Epoll watches a file descriptor with a single set of events, the reading one being
+    // rearmed independently. Hence a duplicate is watched for writability instead.
+    _source.writeFd = fcntl(_source.fd, F_DUPFD_CLOEXEC, 0);
+    if (_source.writeFd >= 0 && epoll_ctl(epollFd_, EPOLL_CTL_ADD, _source.writeFd, &event) < 0)
+    {
+        ::close(_source.writeFd);
+        _source.writeFd = -1;
+    }
+}
+
+void PtyReactor::eraseIfOrphaned(Id _id, Source const& _source)
+{
+    if (_source.orphaned && !_source.reading && !_source.writing && !_source.scheduled)
+        sources_.erase(_id);
+}
+
+void PtyReactor::unwatch(Source const& _source)
+{
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, _source.fd, nullptr);
+    if (_source.writeFd >= 0)
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, _source.writeFd, nullptr);
+}
+
+void PtyReactor::ioThread()
+{
+    auto events = array<epoll_event, 64>{};
+
+    for (;;)
+    {
+        auto const count = epoll_wait(epollFd_, events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0 && errno == EINTR)
+            continue;
+        else if (count < 0)
+            break;
+
+        for (int i = 0; i < count; ++i)
+        {
+            if (events[i].data.u64 & WritableFlag)
+                write(events[i].data.u64 & ~WritableFlag);
+            else if (events[i].data.u64 != WakeupId)
+                read(events[i].data.u64);
+            else if (auto _l = lock_guard{ mutex_ }; stopping_)
+                return;
+        }
+    }
+}
+
+void PtyReactor::read(Id _id)
+{
+    Source* source = nullptr;
+    {
+        auto _l = lock_guard{ mutex_ };
+        auto i = sources_.find(_id);
+        if (i == sources_.end() || i->second->removed)
+            return;
+
+        // Sources being read are not erased, so that they can be read without the lock.
+        source = i->second.get();
+        source->reading = true;
+    }
+
+    // Reads until the output is drained or the input buffer is full.
+    bool closed = false;
+    for (auto space = source->input.write_span(); !space.empty(); space = source->input.write_span())
+    {
+        auto const rv = ::read(source->fd, space.begin(), space.size());
+        if (rv > 0)
+            source->input.commit(static_cast<size_t>(rv));
+        else if (rv < 0 && errno == EINTR)
+            continue;
+        else if (rv < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        else
+        {
+            // End of file, or EIO on a PTY master whose slave side has been closed.
+            closed = true;
+            break;
+        }
+    }
+
+    bool notifyWorker = false;
+    {
+        auto _l = lock_guard{ mutex_ };
+        source->reading = false;
+
+        if (closed)
+        {
+            unwatch(*source);
+            source->closed = true;
+        }
+        else if (source->removed)
+            ; // Not to be watched anymore.
+        else if (!source->input.full())
+            rearm(_id, *source);
+        else
+        {
+            // Watched again by the worker making room. Unless it already did so in the meantime,
+            // without having seen the stall.
+            source->stalled = true;
+            if (!source->input.full() && source->stalled.exchange(false))
+                rearm(_id, *source);
+        }
+
+        if ((closed || !source->input.empty()) && !source->scheduled && !source->removed)
+        {
+            source->scheduled = true;
+            scheduled_.push_back(_id);
+            notifyWorker = true;
+        }
+
+        eraseIfOrphaned(_id, *source);
+    }
+
+    sourceIdle_.notify_all();
+    if (notifyWorker)
+        workAvailable_.notify_one();
+}
+
+void PtyReactor::write(Id _id)
+{
+    Source* source = nullptr;
+    {
+        auto _l = lock_guard{ mutex_ };
+        auto i = sources_.find(_id);
+        if (i == sources_.end() || i->second->removed || i->second->closed)
+            return;
+
+        // Sources being written are not erased, so that the handler can be invoked without the lock.
+        source = i->second.get();
+        source->writing = true;
+    }
+
+    auto const more = source->onWritable();
+
+    {
+        auto _l = lock_guard{ mutex_ };
+        source->writing = false;
+        if (more && !source->removed && !source->closed)
+            rearmWritable(_id, *source);
+        eraseIfOrphaned(_id, *source);
+    }
+
+    sourceIdle_.notify_all();
+}
+
+void PtyReactor::workerThread()
+{
+    for (;;)
+    {
+        Id id = 0;
+        Source* source = nullptr;
+        {
+            auto _l = unique_lock{ mutex_ };
+            workAvailable_.wait(_l, [this]() { return stopping_ || !scheduled_.empty(); });
+            if (stopping_)
+                return;
+
+            id = scheduled_.front();
+            scheduled_.pop_front();
+
+            // Sources being scheduled are not erased, so that the handlers can be invoked without the lock.
+            source = sources_.at(id).get();
+            source->handlerThread = this_thread::get_id();
+        }
+
+        process(id, *source);
+        sourceIdle_.notify_all();
+    }
+}
+
+void PtyReactor::process(Id _id, Source& _source)
+{
+    for (;;)
+    {
+        // The I/O thread keeps filling the input meanwhile.
+        for (auto chunk = _source.input.read_span(); !chunk.empty(); chunk = _source.input.read_span())
+        {
+            auto const size = min(chunk.size(), ChunkSize);
+            if (!_source.removed)
+                _source.onOutput(chunk.begin(), size);
+            _source.input.consume(size);
+
+            if (_source.stalled.exchange(false) && !_source.removed)
+                rearm(_id, _source);
+        }
+
+        bool closed = false;
+        {
+            auto _l = lock_guard{ mutex_ };
+            if (!_source.input.empty())
+                continue;
+
+            closed = _source.closed && !_source.removed;
+            if (!closed)
+            {
+                _source.scheduled = false;
+                _source.handlerThread = {};
+                eraseIfOrphaned(_id, _source);
+                return;
+            }
+        }
+
+        // No more input is going to arrive.
+        _source.onClose();
+
+        auto _l = lock_guard{ mutex_ };
+        _source.scheduled = false;
+        _source.handlerThread = {};
+
+        // Sources closed by the other end are erased right away, as are sources removed by
+        // their own handlers. Those removed by another thread are erased by remove().
+        if (!_source.removed)
+            sources_.erase(_id);
+        else
+            eraseIfOrphaned(_id, _source);
+        return;
+    }
+}
+
+} // end namespace terminal
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#if defined(__linux__)
+
+#include <crispy/spsc_buffer.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace terminal {
+
+/// Reads the output of any number of PTYs with a single I/O thread, using epoll.
+///
+/// The I/O thread waits for any of the watched file descriptors to become readable and
+/// reads what is available into the source's single-producer/single-consumer buffer,
+/// from which a small pool of worker threads processes it.
+///
+/// Reading and processing are decoupled that way: a file descriptor is watched again right
+/// after reading it, so that the kernel's buffer keeps being drained while a worker may be
+/// waiting for a lock in order to process the previous output. Only once the source's buffer
+/// is full, reading is suspended until a worker has made room again.
+///
+/// The output of a file descriptor is processed by one worker at a time and in order.
+///
+/// Sources with input to be written may ask for being notified once their file descriptor
+/// accepts more, in which case the I/O thread invokes their writable handler. That handler
+/// must not block, as it delays reading and writing all other sources.
+class PtyReactor {
+  public:
+    using Id = uint64_t;
+    using OutputHandler = std::function<void(char const* /*_data*/, size_t /*_size*/)>;
+    using CloseHandler = std::function<void()>;
+
+    /// Writes what the file descriptor accepts without blocking.
+    /// @returns whether input is left to be written once the file descriptor accepts more.
+    using WritableHandler = std::function<bool()>;
+
+    /// Size of each source's buffer of output not yet processed.
+    static constexpr size_t BufferSize = 256 * 1024;
+
+    /// Maximum size of the chunks handed to the output handler at once.
+    static constexpr size_t ChunkSize = 32 * 1024;
+
+    explicit PtyReactor(size_t _workerCount = defaultWorkerCount());
+    ~PtyReactor();
+
+    PtyReactor(PtyReactor const&) = delete;
+    PtyReactor& operator=(PtyReactor const&) = delete;
+
+    /// @returns the reactor shared by all terminals of this process.
+    static PtyReactor& shared();
+
+    /// @returns a few worker threads, depending on the number of CPU cores.
+    static size_t defaultWorkerCount() noexcept;
+
+    /// Starts watching the non-blocking file descriptor @p _fd, which must stay open until removed.
+    ///
+    /// @p _onOutput is invoked on a worker thread for each chunk of output, and @p _onClose once
+    /// the other end has been closed, after which @p _fd is not watched anymore.
+    ///
+    /// @p _onWritable is invoked on the I/O thread whenever the file descriptor has become
+    /// writable after watchWritable() has been called.
+    ///
+    /// @returns the id to remove the file descriptor with.
+    Id add(int _fd, OutputHandler _onOutput, CloseHandler _onClose, WritableHandler _onWritable = {});
+
+    /// Has the writable handler of the file descriptor added as @p _id invoked once it accepts
+    /// more data, and again for as long as the handler asks for it.
+    ///
+    /// Unknown, removed or closed sources are ignored.
+    void watchWritable(Id _id);
+
+    /// Stops watching the file descriptor added as @p _id, waiting for its handlers to return
+    /// unless called from within them.
+    void remove(Id _id);
+
+  private:
+    struct Source {
+        Source(int _fd, OutputHandler _onOutput, CloseHandler _onClose, WritableHandler _onWritable) :
+            fd{ _fd },
+            onOutput{ std::move(_onOutput) },
+            onClose{ std::move(_onClose) },
+            onWritable{ std::move(_onWritable) },
+            input{ BufferSize }
+        {}
+
+        ~Source();
+
+        int const fd;
+        OutputHandler const onOutput;
+        CloseHandler const onClose;
+        WritableHandler const onWritable;
+
+        /// Output read by the I/O thread, to be processed by whichever worker is scheduled.
+        crispy::spsc_buffer<char> input;
+
+        // Guarded by mutex_.
+        bool reading = false;               // the I/O thread is reading into input
+        bool writing = false;               // the I/O thread is invoking onWritable
+        int writeFd = -1;                   // duplicate of fd, watched for writability independently
+        bool scheduled = false;             // a worker has been asked to process input
+        bool closed = false;                // the other end has been closed, after the last input
+        bool orphaned = false;              // removed by its own handler, to be erased once idle
+        std::thread::id handlerThread{};    // worker thread processing the input
+
+        std::atomic<bool> removed = false;  // remove() has been called, input is discarded
+        std::atomic<bool> stalled = false;  // not watched until a worker makes room in input
+    };
+
+    void ioThread();
+    void workerThread();
+
+    /// Reads the available output of the given source into its input buffer.
+    void read(Id _id);
+
+    /// Invokes the writable handler of the given source.
+    void write(Id _id);
+
+    /// Hands the source's input to its handlers until there is none left.
+    void process(Id _id, Source& _source);
+
+    /// Watches the source's file descriptor for the next output.
+    void rearm(Id _id, Source const& _source);
+
+    /// Watches the source's file descriptor for becoming writable, to be called with mutex_ locked.
+    void rearmWritable(Id _id, Source& _source);
+
+    /// Erases a source removed by its own handler once nothing refers to it anymore,
+    /// to be called with mutex_ locked.
+    void eraseIfOrphaned(Id _id, Source const& _source);
+
+    /// Stops watching the source's file descriptor, to be called with mutex_ locked.
+    void unwatch(Source const& _source);
+
+    int epollFd_ = -1;
+    int wakeupFd_ = -1;     // eventfd waking up the I/O thread for shutting down
+
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable sourceIdle_;
+    std::unordered_map<Id, std::unique_ptr<Source>> sources_;
+    std::deque<Id> scheduled_;              // sources to be processed by the next idle worker
+    Id nextId_ = 1;
+    bool stopping_ = false;
+
+    std::thread ioThread_;
+    std::vector<std::thread> workers_;
+};
+
+} // end namespace terminal
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyReactor.h>
+
+#if defined(__linux__)
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+using terminal::PtyReactor;
+
+namespace
+{
+    /// A pipe whose reading end is watched by a reactor, recording what the handlers got.
+    struct WatchedPipe {
+        int fds[2] = {-1, -1};
+        mutex lock;
+        condition_variable changed;
+        string output;
+        int chunksInFlight = 0;
+        bool overlapped = false;
+        bool closed = false;
+
+        WatchedPipe()
+        {
+            REQUIRE(pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0);
+        }
+
+        ~WatchedPipe()
+        {
+            for (int fd : fds)
+                if (fd >= 0)
+                    ::close(fd);
+        }
+
+        PtyReactor::Id watch(PtyReactor& _reactor)
+        {
+            return _reactor.add(
+                fds[0],
+                [this](char const* _data, size_t _size) {
+                    {
+                        auto _l = lock_guard{ lock };
+                        overlapped = overlapped || chunksInFlight != 0;
+                        ++chunksInFlight;
+                    }
+                    this_thread::sleep_for(chrono::microseconds(50));
+                    auto _l = lock_guard{ lock };
+                    --chunksInFlight;
+                    output.append(_data, _size);
+                    changed.notify_all();
+                },
+                [this]() {
+                    auto _l = lock_guard{ lock };
+                    closed = true;
+                    changed.notify_all();
+                }
+            );
+        }
+
+        void write(string const& _text)
+        {
+            REQUIRE(::write(fds[1], _text.data(), _text.size()) == static_cast<ssize_t>(_text.size()));
+        }
+
+        void closeWriter()
+        {
+            ::close(fds[1]);
+            fds[1] = -1;
+        }
+
+        template <typename Predicate>
+        bool waitFor(Predicate _predicate)
+        {
+            auto _l = unique_lock{ lock };
+            return changed.wait_for(_l, chrono::seconds(5), [&]() { return _predicate(*this); });
+        }
+    };
+}
+
+TEST_CASE("PtyReactor.output", "[reactor]")
+{
+    auto reactor = PtyReactor{2};
+    auto a = WatchedPipe{};
+    auto b = WatchedPipe{};
+    auto const idA = a.watch(reactor);
+    auto const idB = b.watch(reactor);
+
+    // Chunks of each file descriptor arrive in order and one at a time.
+    auto expected = string{};
+    for (int i = 0; i < 200; ++i)
+    {
+        auto const text = to_string(i) + ";";
+        a.write(text);
+        b.write(text);
+        expected += text;
+    }
+
+    CHECK(a.waitFor([&](WatchedPipe& _pipe) { return _pipe.output == expected; }));
+    CHECK(b.waitFor([&](WatchedPipe& _pipe) { return _pipe.output == expected; }));
+    CHECK_FALSE(a.overlapped);
+    CHECK_FALSE(b.overlapped);
+
+    reactor.remove(idA);
+    reactor.remove(idB);
+
+    // Removed file descriptors are not read anymore.
+    a.write("more");
+    this_thread::sleep_for(chrono::milliseconds(20));
+    auto _l = lock_guard{ a.lock };
+    CHECK(a.output == expected);
+}
+
+TEST_CASE("PtyReactor.drains_while_processing", "[reactor]")
+{
+    auto reactor = PtyReactor{1};
+    int fds[2] = {-1, -1};
+    REQUIRE(pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0);
+
+    mutex lock;
+    condition_variable changed;
+    bool blocked = false;
+    bool released = false;
+    size_t received = 0;
+
+    auto const id = reactor.add(
+        fds[0],
+        [&](char const*, size_t _size) {
+            auto _l = unique_lock{ lock };
+            blocked = true;
+            changed.notify_all();
+            changed.wait(_l, [&]() { return released; });
+            received += _size;
+            changed.notify_all();
+        },
+        []() {}
+    );
+
+    // While the handler is stuck, the pipe keeps being drained into the reactor's buffer,
+    // beyond what the pipe itself could hold.
+    auto const chunk = string(4096, 'x');
+    size_t written = 0;
+    auto const deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (written < PtyReactor::BufferSize / 2 && chrono::steady_clock::now() < deadline)
+    {
+        if (auto const rv = ::write(fds[1], chunk.data(), chunk.size()); rv > 0)
+            written += static_cast<size_t>(rv);
+        else
+            this_thread::sleep_for(chrono::microseconds(100));
+    }
+    CHECK(written >= PtyReactor::BufferSize / 2);
+
+    {
+        auto _l = unique_lock{ lock };
+        CHECK(changed.wait_for(_l, chrono::seconds(5), [&]() { return blocked; }));
+        released = true;
+        changed.notify_all();
+        CHECK(changed.wait_for(_l, chrono::seconds(5), [&]() { return received == written; }));
+    }
+
+    reactor.remove(id);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST_CASE("PtyReactor.close", "[reactor]")
+{
+    auto reactor = PtyReactor{1};
+    auto pipe = WatchedPipe{};
+    auto const id = pipe.watch(reactor);
+
+    pipe.write("bye");
+    pipe.closeWriter();
+
+    CHECK(pipe.waitFor([](WatchedPipe& _pipe) { return _pipe.closed; }));
+    CHECK(pipe.output == "bye");
+
+    // Removing a closed file descriptor is fine.
+    reactor.remove(id);
+}
+
+#endif
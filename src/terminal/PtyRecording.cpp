@@ -0,0 +1,158 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyRecording.h>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+using namespace std;
+
+namespace terminal {
+
+namespace {
+    constexpr auto Magic = "VTREC"sv;
+    constexpr char Version = 1;
+
+    /// Number of bytes of recorded output read at once, bounding what a corrupt size allocates.
+    constexpr size_t ReadChunkSize = 64 * 1024;
+}
+
+// {{{ PtyRecorder
+PtyRecorder::PtyRecorder(string const& _path, Size _screenSize, chrono::steady_clock::time_point _now) :
+    file_{ _path, ios::binary | ios::trunc },
+    last_{ _now }
+{
+    if (!file_.good())
+        throw runtime_error{ "Failed to create PTY recording " + _path + "." };
+
+    file_.write(Magic.data(), static_cast<streamsize>(Magic.size()));
+    file_.put(Version);
+    writeNumber(static_cast<uint64_t>(_screenSize.width));
+    writeNumber(static_cast<uint64_t>(_screenSize.height));
+}
+
+void PtyRecorder::output(char const* _data, size_t _size, chrono::steady_clock::time_point _now)
+{
+    writeHeader(PtyRecord::Type::Output, _now);
+    writeNumber(_size);
+    file_.write(_data, static_cast<streamsize>(_size));
+}
+
+void PtyRecorder::resize(Size _screenSize, chrono::steady_clock::time_point _now)
+{
+    writeHeader(PtyRecord::Type::Resize, _now);
+    writeNumber(static_cast<uint64_t>(_screenSize.width));
+    writeNumber(static_cast<uint64_t>(_screenSize.height));
+}
+
+void PtyRecorder::writeHeader(PtyRecord::Type _type, chrono::steady_clock::time_point _now)
+{
+    auto const delta = max(chrono::duration_cast<chrono::microseconds>(_now - last_), chrono::microseconds{0});
+    last_ = max(last_, _now);
+
+    file_.put(static_cast<char>(_type));
+    writeNumber(static_cast<uint64_t>(delta.count()));
+}
+
+void PtyRecorder::writeNumber(uint64_t _value)
+{
+    auto bytes = array<char, 10>{};
+    size_t count = 0;
+    do
+    {
+        auto const byte = static_cast<uint8_t>(_value & 0x7F);
+        _value >>= 7;
+        bytes[count++] = static_cast<char>(_value != 0 ? byte | 0x80 : byte);
+    }
+    while (_value != 0);
+
+    file_.write(bytes.data(), static_cast<streamsize>(count));
+}
+// }}}
+
+// {{{ PtyRecording
+PtyRecording::PtyRecording(istream& _input) :
+    input_{ _input }
+{
+    auto magic = string(Magic.size(), '\0');
+    input_.read(magic.data(), static_cast<streamsize>(magic.size()));
+    auto const version = input_.get();
+    auto const width = readNumber();
+    auto const height = readNumber();
+
+    if (!input_.good() || magic != Magic || version != Version || !width || !height)
+        throw runtime_error{ "Not a PTY recording." };
+
+    initialScreenSize_ = Size{ static_cast<int>(*width), static_cast<int>(*height) };
+}
+
+optional<PtyRecord> PtyRecording::next()
+{
+    auto const type = input_.get();
+    auto const delta = readNumber();
+    if (type == char_traits<char>::eof() || !delta)
+        return nullopt;
+
+    time_ += chrono::microseconds{ *delta };
+
+    switch (static_cast<PtyRecord::Type>(type))
+    {
+        case PtyRecord::Type::Output:
+            if (auto const size = readNumber(); size)
+            {
+                // Grown as the data arrives, as the size of a truncated record may be garbage.
+                auto output = string{};
+                while (output.size() < *size && input_.good())
+                {
+                    auto const offset = output.size();
+                    auto const count = min(static_cast<size_t>(*size - offset), ReadChunkSize);
+                    output.resize(offset + count);
+                    input_.read(output.data() + offset, static_cast<streamsize>(count));
+                    output.resize(offset + static_cast<size_t>(input_.gcount()));
+                }
+                if (output.size() == *size)
+                    return PtyRecord{ PtyRecord::Type::Output, time_, move(output), Size{} };
+            }
+            break;
+        case PtyRecord::Type::Resize:
+            if (auto const width = readNumber(), height = readNumber(); width && height)
+                return PtyRecord{ PtyRecord::Type::Resize, time_, {},
+                                  Size{ static_cast<int>(*width), static_cast<int>(*height) } };
+            break;
+    }
+
+    // Unknown or truncated record, as when the recording was not stopped cleanly.
+    return nullopt;
+}
+
+optional<uint64_t> PtyRecording::readNumber()
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        auto const byte = input_.get();
+        if (byte == char_traits<char>::eof())
+            return nullopt;
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+    return nullopt;
+}
+// }}}
+
+} // end namespace terminal
@@ -0,0 +1,88 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Size.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <string>
+
+namespace terminal {
+
+/// A recorded PTY event, that is, a chunk of output or a change of the screen size.
+struct PtyRecord {
+    enum class Type : uint8_t { Output = 0, Resize = 1 };
+
+    Type type;
+    std::chrono::microseconds time;     // since the start of the recording
+    std::string output;                 // for Type::Output
+    Size size;                          // for Type::Resize
+};
+
+/// Records the output of a PTY to a file, along with the screen size changes
+/// needed to reproduce the same screen contents when replaying it.
+///
+/// The file starts with the magic "VTREC", a version byte, and the initial screen size,
+/// followed by the records: a type byte, the time since the previous record in microseconds,
+/// then either the size and bytes of the output or the new screen size.
+/// All numbers are stored as LEB128 variable length integers.
+class PtyRecorder {
+  public:
+    /// Creates the file at @p _path, throwing std::runtime_error on failure.
+    PtyRecorder(std::string const& _path,
+                Size _screenSize,
+                std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now());
+
+    void output(char const* _data, size_t _size,
+                std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now());
+
+    void resize(Size _screenSize,
+                std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now());
+
+    /// Writes out what has been recorded so far.
+    void flush() { file_.flush(); }
+
+  private:
+    void writeHeader(PtyRecord::Type _type, std::chrono::steady_clock::time_point _now);
+    void writeNumber(uint64_t _value);
+
+    std::ofstream file_;
+    std::chrono::steady_clock::time_point last_;
+};
+
+/// Reads the records of a file written by PtyRecorder.
+class PtyRecording {
+  public:
+    /// Starts reading from @p _input, throwing std::runtime_error if it is not a recording.
+    explicit PtyRecording(std::istream& _input);
+
+    /// @returns the screen size at the start of the recording.
+    Size initialScreenSize() const noexcept { return initialScreenSize_; }
+
+    /// @returns the next record, or nothing at the end of the recording.
+    std::optional<PtyRecord> next();
+
+  private:
+    std::optional<uint64_t> readNumber();
+
+    std::istream& input_;
+    Size initialScreenSize_{};
+    std::chrono::microseconds time_{0};
+};
+
+} // end namespace terminal
@@ -0,0 +1,130 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyRecording.h>
+#include <terminal/Screen.h>
+#include <terminal/Terminal.h>
+
+#include <crispy/stdfs.h>
+
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+using namespace terminal;
+
+TEST_CASE("PtyRecording.roundtrip", "[recording]")
+{
+    auto const path = (FileSystem::temp_directory_path() / "libterminal-PtyRecording_test.vtrec").string();
+    auto const start = steady_clock::time_point{} + hours(1);
+    auto const payload = string(300, 'x') + string("\0\033[m", 4);
+
+    {
+        auto recorder = PtyRecorder{path, Size{80, 25}, start};
+        recorder.output("Hello", 5, start + microseconds(10));
+        recorder.resize(Size{132, 50}, start + seconds(2));
+        recorder.output(payload.data(), payload.size(), start + seconds(2) + microseconds(1));
+    }
+
+    auto file = ifstream{path, ios::binary};
+    auto recording = PtyRecording{file};
+    CHECK(recording.initialScreenSize() == Size{80, 25});
+
+    auto record = recording.next();
+    REQUIRE(record.has_value());
+    CHECK(record->type == PtyRecord::Type::Output);
+    CHECK(record->time == microseconds(10));
+    CHECK(record->output == "Hello");
+
+    record = recording.next();
+    REQUIRE(record.has_value());
+    CHECK(record->type == PtyRecord::Type::Resize);
+    CHECK(record->time == seconds(2));
+    CHECK(record->size == Size{132, 50});
+
+    record = recording.next();
+    REQUIRE(record.has_value());
+    CHECK(record->type == PtyRecord::Type::Output);
+    CHECK(record->time == seconds(2) + microseconds(1));
+    CHECK(record->output == payload);
+
+    CHECK_FALSE(recording.next().has_value());
+
+    file.close();
+    FileSystem::remove(path);
+}
+
+TEST_CASE("PtyRecording.invalid", "[recording]")
+{
+    auto input = istringstream{"VTREX\x01\x50\x19"};
+    CHECK_THROWS_AS(PtyRecording{input}, runtime_error);
+
+    // A truncated last record is ignored.
+    auto truncated = istringstream{string("VTREC\x01\x50\x19\x00\x05\x0A" "abc", 14)};
+    auto recording = PtyRecording{truncated};
+    CHECK(recording.initialScreenSize() == Size{80, 25});
+    CHECK_FALSE(recording.next().has_value());
+
+    // So is one claiming far more output than there is.
+    auto corrupt = istringstream{string("VTREC\x01\x50\x19\x00\x05\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x7F" "abc", 22)};
+    auto corruptRecording = PtyRecording{corrupt};
+    CHECK_FALSE(corruptRecording.next().has_value());
+}
+
+TEST_CASE("PtyRecording.mid_session", "[recording]")
+{
+    auto const path = (FileSystem::temp_directory_path() / "libterminal-PtyRecording_mid_session.vtrec").string();
+
+    auto terminalEvents = Terminal::Events{};
+    auto terminal = Terminal{Size{10, 4}, terminalEvents, 100};
+    terminal.writeToScreen(string("history\r\n\033[1;3;31mred\033[m \033[4;58;5;2mcurly\033[m\r\n"
+                           "\xE2\x9A\xA1wide\r\nthree\r\nfour"));
+    terminal.writeToScreen(string("\033[2;3r\033[?6h\033[2;4H\033[7;32m")); // DECSTBM, DECOM, CUP, SGR
+
+    terminal.startRecording(path);
+    terminal.stopRecording();
+
+    auto file = ifstream{path, ios::binary};
+    auto recording = PtyRecording{file};
+    CHECK(recording.initialScreenSize() == Size{10, 4});
+
+    auto events = ScreenEvents{};
+    auto replay = Screen{recording.initialScreenSize(), events};
+    while (auto const record = recording.next())
+        if (record->type == PtyRecord::Type::Output)
+            replay.write(record->output.data(), record->output.size());
+
+    Screen const& screen = terminal.screen();
+    CHECK(replay.renderText() == screen.renderText());
+    CHECK(replay.cursorPosition() == screen.cursorPosition());
+    CHECK(replay.realCursorPosition() == screen.realCursorPosition());
+    CHECK(replay.isModeEnabled(Mode::Origin));
+    CHECK(replay.at({1, 1}).attributes() == screen.at({1, 1}).attributes());
+    CHECK(replay.at({1, 5}).attributes() == screen.at({1, 5}).attributes());
+    CHECK(replay.at({2, 1}).codepoint(0) == screen.at({2, 1}).codepoint(0));
+
+    // Output following the start of the recording lands alike, within the margins and rendition.
+    auto const output = string("X\n\nY");
+    terminal.writeToScreen(output);
+    replay.write(output);
+    CHECK(replay.renderText() == screen.renderText());
+    CHECK(replay.cursorPosition() == screen.cursorPosition());
+    CHECK(replay.at({3, 4}).attributes() == screen.at({3, 4}).attributes());
+
+    file.close();
+    FileSystem::remove(path);
+}
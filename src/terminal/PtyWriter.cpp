@@ -0,0 +1,259 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyWriter.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace terminal {
+
+namespace {
+    constexpr auto PasteBegin = "\033[200~"sv;
+    constexpr auto PasteEnd = "\033[201~"sv;
+
+    bool isContinuationByte(char _byte) noexcept
+    {
+        return (static_cast<uint8_t>(_byte) & 0xC0) == 0x80;
+    }
+}
+
+PtyWriter::PtyWriter(PseudoTerminal& _pty) :
+    pty_{ _pty }
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if (pipe(wakeupPipe_) < 0)
+        throw runtime_error{ string("Failed to set up PTY writer. ") + strerror(errno) };
+    for (int fd : wakeupPipe_)
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+
+    thread_ = thread{ [this]() { writerThread(); } };
+}
+
+PtyWriter::PtyWriter(PseudoTerminal& _pty, WritableRequest _watchWritable) :
+    pty_{ _pty },
+    watchWritable_{ move(_watchWritable) }
+{
+}
+
+PtyWriter::~PtyWriter()
+{
+    stop();
+
+#if defined(__unix__) || defined(__APPLE__)
+    for (int fd : wakeupPipe_)
+        if (fd >= 0)
+            ::close(fd);
+#endif
+}
+
+void PtyWriter::write(string_view _data)
+{
+    if (_data.empty())
+        return;
+
+    bool wasIdle = false;
+    {
+        auto _l = lock_guard{ mutex_ };
+        if (stopping_)
+            return;
+        wasIdle = input_.empty() && pastes_.empty();
+        input_.append(_data);
+    }
+    notify(wasIdle);
+}
+
+void PtyWriter::writePaste(string _text, bool _bracketed)
+{
+    bool wasIdle = false;
+    {
+        auto _l = lock_guard{ mutex_ };
+        if (stopping_)
+            return;
+        wasIdle = input_.empty() && pastes_.empty();
+        pastes_.push_back(Paste{ move(_text), 0, _bracketed });
+    }
+    notify(wasIdle);
+}
+
+void PtyWriter::notify(bool _wasIdle)
+{
+    if (watchWritable_)
+    {
+        // Otherwise flush() is either running or about to be invoked already.
+        if (_wasIdle)
+            watchWritable_();
+    }
+    else
+        pending_.notify_one();
+}
+
+size_t PtyWriter::pendingSize() const
+{
+    auto _l = lock_guard{ mutex_ };
+    auto size = input_.size();
+    for (Paste const& paste : pastes_)
+        size += paste.text.size() - paste.offset;
+    return size;
+}
+
+void PtyWriter::stop()
+{
+    {
+        auto _l = lock_guard{ mutex_ };
+        stopping_ = true;
+        input_.clear();
+        pastes_.clear();
+    }
+
+    if (!thread_.joinable())
+        return;
+
+    pending_.notify_one();
+#if defined(__unix__) || defined(__APPLE__)
+    auto const byte = char{0};
+    (void) ::write(wakeupPipe_[1], &byte, 1);
+#endif
+    thread_.join();
+}
+
+void PtyWriter::takeChunk(string& _chunk)
+{
+    if (!input_.empty())
+    {
+        if (pasteOpen_)
+        {
+            _chunk.append(PasteEnd);
+            pasteOpen_ = false;
+        }
+        _chunk.append(input_);
+        input_.clear();
+        return;
+    }
+
+    if (pastes_.empty())
+        return;
+
+    Paste& paste = pastes_.front();
+    if (paste.bracketed && !pasteOpen_)
+    {
+        _chunk.append(PasteBegin);
+        pasteOpen_ = true;
+    }
+
+    // Chunks end on UTF-8 character boundaries, as regular input may get in between them.
+    auto const remaining = paste.text.size() - paste.offset;
+    auto count = min(remaining, ChunkSize);
+    while (count != 0 && count != remaining && isContinuationByte(paste.text[paste.offset + count]))
+        --count;
+    if (count == 0)
+        count = min(remaining, ChunkSize);
+
+    _chunk.append(paste.text, paste.offset, count);
+    paste.offset += count;
+
+    if (paste.offset == paste.text.size())
+    {
+        if (pasteOpen_)
+        {
+            _chunk.append(PasteEnd);
+            pasteOpen_ = false;
+        }
+        pastes_.pop_front();
+    }
+}
+
+bool PtyWriter::flush()
+{
+    for (;;)
+    {
+        if (chunkOffset_ == chunk_.size())
+        {
+            chunk_.clear();
+            chunkOffset_ = 0;
+
+            auto _l = lock_guard{ mutex_ };
+            if (stopping_)
+                return false;
+            takeChunk(chunk_);
+            if (chunk_.empty())
+                return false;
+        }
+
+        // The PTY stays open while flushing, so that the lock is not held while writing.
+        auto const rv = pty_.tryWrite(chunk_.data() + chunkOffset_, chunk_.size() - chunkOffset_);
+        if (rv == 0)
+        {
+            auto _l = lock_guard{ mutex_ };
+            return !stopping_;
+        }
+        else if (rv > 0)
+            chunkOffset_ += static_cast<size_t>(rv);
+        else
+        {
+            // Whatever is queued cannot be written either.
+            chunk_.clear();
+            chunkOffset_ = 0;
+
+            auto _l = lock_guard{ mutex_ };
+            input_.clear();
+            pastes_.clear();
+            pasteOpen_ = false;
+            return false;
+        }
+    }
+}
+
+void PtyWriter::waitWritable()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    auto fds = array<pollfd, 2>{
+        pollfd{ pty_.master(), POLLOUT, 0 },
+        pollfd{ wakeupPipe_[0], POLLIN, 0 }
+    };
+    while (poll(fds.data(), fds.size(), -1) < 0 && errno == EINTR)
+        ;
+#endif
+    // Elsewhere tryWrite() blocks instead.
+}
+
+void PtyWriter::writerThread()
+{
+    for (;;)
+    {
+        {
+            auto _l = unique_lock{ mutex_ };
+            pending_.wait(_l, [this]() { return stopping_ || !input_.empty() || !pastes_.empty(); });
+            if (stopping_)
+                return;
+        }
+
+        while (flush())
+            waitWritable();
+    }
+}
+
+} // end namespace terminal
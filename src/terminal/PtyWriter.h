@@ -0,0 +1,114 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/PseudoTerminal.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace terminal {
+
+/// Queue of input to be written to a PTY, written in chunks whenever the PTY accepts more,
+/// so that writing never blocks the caller.
+///
+/// The queue is either written by whoever watches the PTY for becoming writable, such as the
+/// PtyReactor, by invoking flush(). Or, lacking such, by a thread of its own.
+///
+/// Regular input, such as key presses or replies to the application, is written
+/// ahead of pastes still pending, in the order given. A bracketed paste interrupted
+/// that way is closed before and reopened after the bypassing input, so that only
+/// pasted text ends up within the paste brackets.
+class PtyWriter {
+  public:
+    /// Maximum number of pasted bytes written at once, bounding the delay of regular input.
+    static constexpr size_t ChunkSize = 4096;
+
+    /// Asks for flush() to be invoked once the PTY accepts more data.
+    using WritableRequest = std::function<void()>;
+
+    /// Constructs a writer that writes the queue with a thread of its own.
+    explicit PtyWriter(PseudoTerminal& _pty);
+
+    /// Constructs a writer that has flush() invoked by @p _watchWritable whenever input
+    /// has been queued while none was pending.
+    PtyWriter(PseudoTerminal& _pty, WritableRequest _watchWritable);
+
+    ~PtyWriter();
+
+    PtyWriter(PtyWriter const&) = delete;
+    PtyWriter& operator=(PtyWriter const&) = delete;
+
+    /// Queues regular input.
+    void write(std::string_view _data);
+
+    /// Queues pasted text, enclosed in paste brackets if @p _bracketed.
+    void writePaste(std::string _text, bool _bracketed);
+
+    /// @returns the number of bytes queued but not yet written.
+    size_t pendingSize() const;
+
+    /// Writes queued input for as long as the PTY accepts it without waiting.
+    ///
+    /// @returns whether input is left to be written once the PTY accepts more.
+    bool flush();
+
+    /// Discards any input not yet written and stops writing, which must happen before closing the PTY.
+    ///
+    /// Without a thread of its own, flush() must not be invoked anymore once the PTY is closed.
+    void stop();
+
+  private:
+    struct Paste {
+        std::string text;
+        size_t offset;      // number of bytes already taken from text
+        bool bracketed;
+    };
+
+    void writerThread();
+
+    /// Waits for the PTY to accept more data, or for the writer to be stopped.
+    void waitWritable();
+
+    /// Has the queued input written, unless input was pending already.
+    void notify(bool _wasIdle);
+
+    /// Moves the next bytes to write into @p _chunk, to be called with mutex_ locked.
+    void takeChunk(std::string& _chunk);
+
+    PseudoTerminal& pty_;
+    WritableRequest const watchWritable_;
+
+    // Only accessed by flush(), which is never invoked concurrently.
+    std::string chunk_;                 // bytes taken from the queue, being written
+    size_t chunkOffset_ = 0;            // number of bytes of chunk_ written
+
+    mutable std::mutex mutex_;
+    std::condition_variable pending_;
+    std::string input_;                 // regular input, written first
+    std::deque<Paste> pastes_;
+    bool pasteOpen_ = false;            // whether the front paste's opening bracket has been written
+    bool stopping_ = false;
+
+    std::thread thread_;
+    int wakeupPipe_[2] = {-1, -1};      // wakes up thread_ waiting for the PTY, for stopping
+};
+
+} // end namespace terminal
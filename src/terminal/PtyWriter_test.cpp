@@ -0,0 +1,189 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PtyWriter.h>
+#include <terminal/PtyReactor.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <string>
+#include <string_view>
+
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace terminal;
+
+namespace
+{
+    /// Makes the slave side pass through whatever is written to the master.
+    void makeRaw(PseudoTerminal& _pty)
+    {
+        auto tio = termios{};
+        REQUIRE(tcgetattr(_pty.slave(), &tio) == 0);
+        cfmakeraw(&tio);
+        REQUIRE(tcsetattr(_pty.slave(), TCSANOW, &tio) == 0);
+    }
+
+    /// Reads from the slave side until @p _done returns true for what has been read.
+    template <typename Predicate>
+    string readSlave(PseudoTerminal& _pty, Predicate _done)
+    {
+        auto text = string{};
+        char buf[4096];
+        while (!_done(text))
+        {
+            auto pfd = pollfd{ _pty.slave(), POLLIN, 0 };
+            if (poll(&pfd, 1, 5000) <= 0)
+                break;
+            auto const n = ::read(_pty.slave(), buf, sizeof(buf));
+            if (n <= 0)
+                break;
+            text.append(buf, static_cast<size_t>(n));
+        }
+        return text;
+    }
+
+    /// Splits @p _text into what is inside and outside of paste brackets.
+    pair<string, string> splitPasted(string_view _text)
+    {
+        auto pasted = string{};
+        auto typed = string{};
+        bool inside = false;
+        while (!_text.empty())
+        {
+            auto const marker = inside ? "\033[201~"sv : "\033[200~"sv;
+            auto const i = _text.find(marker);
+            (inside ? pasted : typed).append(_text.substr(0, i));
+            if (i == string_view::npos)
+                break;
+            _text.remove_prefix(i + marker.size());
+            inside = !inside;
+        }
+        return {pasted, typed};
+    }
+}
+
+TEST_CASE("PtyWriter.input", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    makeRaw(pty);
+    auto writer = PtyWriter{pty};
+
+    writer.write("abc");
+    writer.write("");
+    writer.write("def");
+
+    CHECK(readSlave(pty, [](string const& _text) { return _text.size() >= 6; }) == "abcdef");
+}
+
+TEST_CASE("PtyWriter.paste", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    makeRaw(pty);
+    auto writer = PtyWriter{pty};
+
+    // Far more than the PTY takes while nobody is reading the other end.
+    auto text = string{};
+    while (text.size() < 1024 * 1024)
+        text += "Hello, \xC3\xA4\xC3\xB6\xC3\xBC! ";
+
+    SECTION("bracketed") {
+        writer.writePaste(text, true);
+        writer.write("X");
+        CHECK(writer.pendingSize() != 0);
+
+        auto const output = readSlave(pty, [&](string const& _text) {
+            return _text.size() >= text.size() + 1 && _text.size() >= 6 && _text.substr(_text.size() - 6) == "\033[201~";
+        });
+
+        // Typed input overtook the paste but did not end up within its brackets.
+        auto const [pasted, typed] = splitPasted(output);
+        CHECK(typed == "X");
+        CHECK(pasted == text);
+        CHECK(output.find('X') < output.size() / 2);
+    }
+
+    SECTION("unbracketed") {
+        writer.writePaste(text, false);
+        writer.write("X");
+
+        auto const output = readSlave(pty, [&](string const& _text) { return _text.size() >= text.size() + 1; });
+        auto const i = output.find('X');
+        REQUIRE(i < output.size() / 2);
+        CHECK(output.substr(0, i) + output.substr(i + 1) == text);
+    }
+
+    CHECK(writer.pendingSize() == 0);
+}
+
+TEST_CASE("PtyWriter.stop", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    auto writer = PtyWriter{pty};
+
+    // Stopping does not wait for the pending paste to be written.
+    writer.writePaste(string(1024 * 1024, 'x'), true);
+    writer.stop();
+    CHECK(writer.pendingSize() == 0);
+
+    writer.write("ignored");
+    CHECK(writer.pendingSize() == 0);
+}
+
+#if defined(__linux__)
+TEST_CASE("PtyWriter.reactor", "[pty]")
+{
+    auto pty = PseudoTerminal{Size{80, 25}};
+    makeRaw(pty);
+
+    // Written by the reactor's I/O thread, whenever the PTY accepts more.
+    auto reactor = PtyReactor{1};
+    auto id = atomic<PtyReactor::Id>{0};
+    auto writer = PtyWriter{pty, [&]() { reactor.watchWritable(id); }};
+    id = reactor.add(pty.master(),
+                     [](char const*, size_t) {},
+                     []() {},
+                     [&]() { return writer.flush(); });
+
+    auto text = string{};
+    while (text.size() < 1024 * 1024)
+        text += "Hello, \xC3\xA4\xC3\xB6\xC3\xBC! ";
+
+    writer.writePaste(text, true);
+    writer.write("X");
+
+    auto const output = readSlave(pty, [&](string const& _text) {
+        return _text.size() >= text.size() + 1 && _text.size() >= 6 && _text.substr(_text.size() - 6) == "\033[201~";
+    });
+
+    auto const [pasted, typed] = splitPasted(output);
+    CHECK(typed == "X");
+    CHECK(pasted == text);
+    CHECK(writer.pendingSize() == 0);
+
+    // Input queued after the queue ran empty is written as well.
+    writer.write("more");
+    CHECK(readSlave(pty, [](string const& _text) { return _text.size() >= 4; }) == "more");
+
+    reactor.remove(id);
+    writer.stop();
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/RenderSnapshot.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+using std::find;
+using std::make_shared;
+using std::min;
+using std::move;
+using std::shared_ptr;
+using std::unordered_map;
+
+namespace terminal {
+
+namespace
+{
+    shared_ptr<RenderRow const> copyRow(uint64_t _id, crispy::span<Cell const> _cells)
+    {
+        auto row = make_shared<RenderRow>();
+        row->id = _id;
+        row->cells.assign(_cells.begin(), _cells.end());
+
+        // Neighbouring cells mostly share their style, and rows use only few distinct styles.
+        CellStyle const* source = nullptr;
+        CellStyle const* copy = nullptr;
+        for (Cell& cell : row->cells)
+        {
+            if (&cell.style() != source)
+            {
+                source = &cell.style();
+                if (source == &DefaultCellStyle)
+                    copy = source;
+                else if (auto i = find(row->styles.begin(), row->styles.end(), *source); i != row->styles.end())
+                    copy = &*i;
+                else
+                    copy = &row->styles.emplace_back(*source);
+            }
+            cell.setStyle(*copy);
+        }
+
+        return row;
+    }
+}
+
+shared_ptr<RenderSnapshot> takeSnapshot(Screen const& _screen, shared_ptr<RenderSnapshot const> const& _previous)
+{
+    auto snapshot = make_shared<RenderSnapshot>();
+    snapshot->size = _screen.size();
+    snapshot->generation = _screen.generation();
+    snapshot->bufferType = _screen.bufferType();
+    snapshot->historyLineCount = _screen.historyLineCount();
+    snapshot->scrollOffset = min(_screen.scrollOffset(), snapshot->historyLineCount);
+    snapshot->reverseVideo = _screen.isModeEnabled(Mode::ReverseVideo);
+    snapshot->focused = _screen.focused();
+    snapshot->cursor = _screen.cursor();
+    if (_screen.isSelectionAvailable())
+        snapshot->selection = _screen.selection();
+    snapshot->rows.reserve(static_cast<size_t>(snapshot->size.height));
+
+    auto const comparable = _previous && _previous->size == snapshot->size;
+    auto const& buffer = _screen.currentBuffer();
+
+    // Rows of the previous snapshot by the identity of their lines, as lines keep it while being
+    // scrolled, for sharing the rows of lines that merely moved.
+    auto previousRows = unordered_map<uint64_t, shared_ptr<RenderRow const>>{};
+    if (comparable && _previous->bufferType == snapshot->bufferType)
+        for (auto const& row : _previous->rows)
+            if (row->id != 0)
+                previousRows.emplace(row->id, row);
+
+    auto const unmodified = [&](cursor_pos_t _line) -> shared_ptr<RenderRow const> {
+        if (!comparable)
+            return nullptr;
+
+        if (auto const i = previousRows.find(buffer.lineId(_line)); i != previousRows.end())
+            return i->second;
+
+        if (!_previous->isLineVisible(_line))
+            return nullptr;
+
+        // Lines without identity are shared as long as they stay in place. Lines of the main page know
+        // when they have been modified the last time, whereas history lines only shift as a whole
+        // when the main page scrolls.
+        auto const unchanged = _line >= 1
+            ? buffer.lineAt(_line)->generation <= _previous->generation
+            : _previous->generation == snapshot->generation && _previous->historyLineCount == snapshot->historyLineCount;
+        if (!unchanged)
+            return nullptr;
+
+        return _previous->rows[static_cast<size_t>(_line + _previous->scrollOffset - 1)];
+    };
+
+    _screen.renderRows(
+        [&](cursor_pos_t /*_row*/, cursor_pos_t _line, crispy::span<Cell const> _cells) {
+            if (auto row = unmodified(_line))
+                snapshot->rows.emplace_back(move(row));
+            else
+                snapshot->rows.emplace_back(copyRow(buffer.lineId(_line), _cells));
+        },
+        snapshot->scrollOffset
+    );
+
+    return snapshot;
+}
+
+} // end namespace
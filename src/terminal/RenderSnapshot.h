@@ -0,0 +1,94 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Screen.h>
+#include <terminal/ScreenBuffer.h>
+#include <terminal/Selector.h>
+#include <terminal/Size.h>
+
+#include <crispy/span.h>
+#include <crispy/utils.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace terminal {
+
+/// Immutable copy of a single row of a screen.
+///
+/// The row owns copies of the styles of its cells, so that it stays valid regardless of any
+/// later modification of the screen, and can be shared by subsequent snapshots.
+struct RenderRow {
+    /// Identity of the line copied (see ScreenBuffer::Line::id), by which the row is shared
+    /// by subsequent snapshots even after the line has been moved, 0 if none.
+    uint64_t id = 0;
+
+    /// Styles referred to by cells, except for the DefaultCellStyle.
+    std::deque<CellStyle> styles;
+
+    /// Exactly as many cells as the screen is wide.
+    std::vector<Cell> cells;
+
+    crispy::span<Cell const> span() const noexcept { return {cells.data(), cells.data() + cells.size()}; }
+};
+
+/// Immutable copy of everything about a screen that is needed to render it.
+///
+/// Snapshots are taken with the screen locked but rendered without holding any lock,
+/// so that the screen can be updated meanwhile.
+struct RenderSnapshot {
+    Size size{};
+    uint64_t generation = 0;    // Screen::generation() at the time of taking the snapshot
+    ScreenBuffer::Type bufferType = ScreenBuffer::Type::Main;
+    int scrollOffset = 0;
+    int historyLineCount = 0;
+    bool reverseVideo = false;
+    bool focused = true;
+    Cursor cursor{};
+    CursorShape cursorShape = CursorShape::Block;   // as configured for the terminal, see Terminal::cursorShape()
+    bool cursorBlinkVisible = true;                 // see Terminal::cursorBlinkVisible()
+    std::vector<Selector::Range> selection{};
+
+    /// The visible rows, top to bottom.
+    std::vector<std::shared_ptr<RenderRow const>> rows{};
+
+    /// @returns whether the given line (as in RenderRow::line) is visible.
+    bool isLineVisible(cursor_pos_t _line) const noexcept
+    {
+        return crispy::ascending(1 - scrollOffset, _line, size.height - scrollOffset);
+    }
+
+    bool contains(Coordinate const& _pos) const noexcept
+    {
+        return crispy::ascending(1, _pos.row, size.height) && crispy::ascending(1, _pos.column, size.width);
+    }
+
+    /// @returns the cell at the given position of the viewport, (1, 1) being the top left.
+    Cell const& at(Coordinate const& _pos) const noexcept
+    {
+        return rows[static_cast<size_t>(_pos.row - 1)]->cells[static_cast<size_t>(_pos.column - 1)];
+    }
+};
+
+/// Takes a snapshot of the visible rows of @p _screen, sharing with @p _previous
+/// all rows that have not been modified since, including those that merely moved.
+///
+/// The cursor's shape and blink state are not known to the screen and left to the caller to fill in.
+std::shared_ptr<RenderSnapshot> takeSnapshot(Screen const& _screen,
+                                                   std::shared_ptr<RenderSnapshot const> const& _previous);
+
+} // end namespace
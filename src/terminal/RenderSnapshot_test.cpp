@@ -0,0 +1,135 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/RenderSnapshot.h>
+#include <terminal/ScreenEvents.h>
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using namespace terminal;
+using std::string;
+
+namespace
+{
+    string textOf(RenderRow const& _row)
+    {
+        string text;
+        for (Cell const& cell : _row.cells)
+            text += cell.empty() ? string(" ") : cell.toUtf8();
+        return text;
+    }
+}
+
+TEST_CASE("RenderSnapshot.rows", "[snapshot]")
+{
+    auto events = MockScreenEvents{};
+    auto screen = Screen{{4, 3}, events};
+    screen.write("ab\r\n\033[31mcd\033[m");
+
+    auto const snapshot = takeSnapshot(screen, nullptr);
+    REQUIRE(snapshot->rows.size() == 3);
+    CHECK(snapshot->size == Size{4, 3});
+    CHECK(snapshot->cursor.position == Coordinate{2, 3});
+    CHECK(textOf(*snapshot->rows[0]) == "ab  ");
+    CHECK(textOf(*snapshot->rows[1]) == "cd  ");
+    CHECK(textOf(*snapshot->rows[2]) == "    ");
+    CHECK(snapshot->rows[1]->id == screen.currentBuffer().lineId(2));
+    CHECK(snapshot->at({2, 1}).attributes().foregroundColor == Color{IndexedColor::Red});
+
+    // The snapshot does not refer to the screen's cells or styles.
+    screen.write("\033[H\033[32mxy\r\nzw\033[m");
+    CHECK(textOf(*snapshot->rows[0]) == "ab  ");
+    CHECK(textOf(*snapshot->rows[1]) == "cd  ");
+    CHECK(snapshot->at({2, 1}).attributes().foregroundColor == Color{IndexedColor::Red});
+    CHECK(&snapshot->at({2, 1}).style() != &screen.at({2, 1}).style());
+}
+
+TEST_CASE("RenderSnapshot.shares_unmodified_rows", "[snapshot]")
+{
+    auto events = MockScreenEvents{};
+    auto screen = Screen{{4, 3}, events};
+    screen.write("ab\r\ncd\r\nef");
+
+    auto const first = takeSnapshot(screen, nullptr);
+    screen.write("\033[2;1HXY");
+    auto const second = takeSnapshot(screen, first);
+
+    CHECK(second->rows[0] == first->rows[0]);
+    CHECK(second->rows[1] != first->rows[1]);
+    CHECK(second->rows[2] == first->rows[2]);
+    CHECK(textOf(*second->rows[1]) == "XY  ");
+
+    // Scrolling shares the rows of the lines that moved.
+    screen.write("\033[3;1H\n");
+    auto const third = takeSnapshot(screen, second);
+    CHECK(third->rows[0] == second->rows[1]);
+    CHECK(third->rows[1] == second->rows[2]);
+    CHECK(third->rows[2] != second->rows[0]);
+    CHECK(textOf(*third->rows[0]) == "XY  ");
+    CHECK(textOf(*third->rows[2]) == "    ");
+
+    // Viewing the history.
+    screen.scrollUp(1);
+    auto const fourth = takeSnapshot(screen, third);
+    CHECK(fourth->scrollOffset == 1);
+    CHECK(fourth->rows[0]->id == screen.currentBuffer().lineId(0));
+    CHECK(textOf(*fourth->rows[0]) == "ab  ");
+    CHECK(fourth->rows[1] == third->rows[0]);
+    CHECK(fourth->rows[2] == third->rows[1]);
+
+    auto const fifth = takeSnapshot(screen, fourth);
+    CHECK(fifth->rows == fourth->rows);
+
+    // Switching buffers modifies all rows.
+    screen.scrollDown(1);
+    screen.write("\033[?1049h");
+    auto const sixth = takeSnapshot(screen, fifth);
+    CHECK(sixth->bufferType == ScreenBuffer::Type::Alternate);
+    for (size_t i = 0; i < 3; ++i)
+        CHECK(textOf(*sixth->rows[i]) == "    ");
+}
+
+TEST_CASE("RenderSnapshot.shares_rows_scrolled_within_margins", "[snapshot]")
+{
+    auto events = MockScreenEvents{};
+    auto screen = Screen{{4, 5}, events};
+    screen.write("aa\r\nbb\r\ncc\r\ndd\r\nee");
+    screen.write("\033[2;4r"); // DECSTBM
+
+    auto const first = takeSnapshot(screen, nullptr);
+    screen.write("\033[4;1H\n");
+    auto const second = takeSnapshot(screen, first);
+
+    CHECK(second->rows[0] == first->rows[0]);
+    CHECK(second->rows[1] == first->rows[2]);
+    CHECK(second->rows[2] == first->rows[3]);
+    CHECK(second->rows[3] != first->rows[1]);
+    CHECK(textOf(*second->rows[3]) == "    ");
+    CHECK(second->rows[4] == first->rows[4]);
+
+    // Scrolling down, such as by inserting lines.
+    screen.write("\033[2;1H\033[L");
+    auto const third = takeSnapshot(screen, second);
+    CHECK(textOf(*third->rows[1]) == "    ");
+    CHECK(third->rows[2] == second->rows[1]);
+    CHECK(third->rows[3] == second->rows[2]);
+    CHECK(third->rows[4] == second->rows[4]);
+
+    // Modifying a moved line does not modify the row it has been rendered to before.
+    screen.write("\033[3;1HX");
+    auto const fourth = takeSnapshot(screen, third);
+    CHECK(fourth->rows[2] != third->rows[2]);
+    CHECK(textOf(*fourth->rows[2]) == "Xc  ");
+    CHECK(textOf(*second->rows[1]) == "cc  ");
+}
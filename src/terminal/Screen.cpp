@@ -56,7 +56,7 @@ Screen::Screen(Size const& _size,
     logTrace_{ _logTrace },
     commandBuilder_{ _logger },
     parser_{
-        ref(commandBuilder_),
+        commandBuilder_,
         [this](string const& _msg) { logger_(ParserErrorEvent{_msg}); }
     },
     modes_{},
@@ -70,9 +70,18 @@ Screen::Screen(Size const& _size,
     debugExecutor_{},
     commandExecutor_ { &directExecutor_ }
 {
+    setRecordCommands(false);
     setMode(Mode::AutoWrap, true);
 }
 
+void Screen::setRecordCommands(bool _enabled)
+{
+    if (_enabled)
+        commandBuilder_.setSink({});
+    else
+        commandBuilder_.setSink([this](Command const& _command) { execute(_command); });
+}
+
 Debugger* Screen::debugger() noexcept
 {
     return static_cast<Debugger*>(debugExecutor_.get());
@@ -94,6 +103,10 @@ void Screen::resize(Size const& _newSize)
     primaryBuffer_.resize(_newSize);
     alternateBuffer_.resize(_newSize);
     size_ = _newSize;
+
+    // The history is re-wrapped as far as it is in view.
+    primaryBuffer_.reflowHistory(scrollOffset_);
+    scrollOffset_ = min(scrollOffset_, historyLineCount());
 }
 
 void Screen::write(Command const& _command)
@@ -107,6 +120,7 @@ void Screen::write(Command const& _command)
 
     buffer_->verifyState();
     instructionCounter_++;
+    commandCount_++;
 
     eventListener_.commands({_command});
 }
@@ -132,23 +146,28 @@ void Screen::write(char const * _data, size_t _size)
     // }
     // #endif
 
-    for_each(
-        commandBuilder_.commands(),
-        [&](Command const& _command) {
-            buffer_->verifyState();
-#if defined(LIBTERMINAL_LOG_TRACE)
-            auto const trace = to_mnemonic(_command, true, true);
-            logger_(TraceOutputEvent{trace});
-#endif
-            visit(*commandExecutor_, _command);
-            instructionCounter_++;
-            buffer_->verifyState();
-        }
-    );
+    if (commandBuilder_.hasSink())
+        // Commands have been executed while parsing already, except for trailing text.
+        commandBuilder_.flush();
+    else
+        for_each(commandBuilder_.commands(), [&](Command const& _command) { execute(_command); });
 
     eventListener_.commands(commandBuilder_.commands());
 }
 
+void Screen::execute(Command const& _command)
+{
+    buffer_->verifyState();
+#if defined(LIBTERMINAL_LOG_TRACE)
+    auto const trace = to_mnemonic(_command, true, true);
+    logger_(TraceOutputEvent{trace});
+#endif
+    visit(*commandExecutor_, _command);
+    instructionCounter_++;
+    commandCount_++;
+    buffer_->verifyState();
+}
+
 void Screen::write(std::u32string_view const& _text)
 {
     for (char32_t codepoint : _text)
@@ -165,13 +184,18 @@ void Screen::writeText(char32_t _char)
     instructionCounter_ = 0;
 }
 
+void Screen::writeText(std::u32string_view _text)
+{
+    buffer_->appendText(_text, instructionCounter_ == 1);
+    instructionCounter_ = 0;
+}
+
 string Screen::renderHistoryTextLine(cursor_pos_t _lineNumberIntoHistory) const
 {
     assert(1 <= _lineNumberIntoHistory && _lineNumberIntoHistory <= buffer_->historyLineCount());
     string line;
     line.reserve(size_.width);
-    auto const lineIter = next(buffer_->savedLines.rbegin(), _lineNumberIntoHistory - 1);
-    for (Cell const& cell : *lineIter)
+    for (Cell const& cell : buffer_->cellsOf(buffer_->readLine(1 - _lineNumberIntoHistory)))
         if (cell.codepointCount())
             line += cell.toUtf8();
         else
@@ -205,6 +229,8 @@ bool Screen::scrollUp(int _numLines)
     if (isAlternateScreen()) // TODO: make configurable
         return false;
 
+    buffer_->reflowHistory(scrollOffset_ + _numLines);
+
     if (auto const newOffset = min(scrollOffset_ + _numLines, historyLineCount()); newOffset != scrollOffset_)
     {
         scrollOffset_ = newOffset;
@@ -230,6 +256,8 @@ bool Screen::scrollDown(int _numLines)
 
 bool Screen::scrollMarkUp()
 {
+    buffer_->reflowHistory(buffer_->historyLineCount());
+
     if (auto const newScrollOffset = buffer_->findMarkerBackward(-scrollOffset_); newScrollOffset.has_value())
     {
         scrollOffset_ = 1 - newScrollOffset.value();
@@ -252,6 +280,8 @@ bool Screen::scrollMarkDown()
 
 bool Screen::scrollToTop()
 {
+    buffer_->reflowHistory(buffer_->historyLineCount());
+
     if (auto top = historyLineCount(); top != scrollOffset_)
     {
         scrollOffset_ = top;
@@ -333,6 +363,8 @@ void Screen::setBuffer(ScreenBuffer::Type _type)
 {
     if (bufferType() != _type)
     {
+        auto const generation = buffer_->generation();
+
         switch (_type)
         {
             case ScreenBuffer::Type::Main:
@@ -348,6 +380,8 @@ void Screen::setBuffer(ScreenBuffer::Type _type)
                 break;
         }
 
+        buffer_->touchAll(generation);
+
         if (selector_)
             selector_.reset();
 
@@ -453,17 +487,17 @@ void Screen::sendTerminalId()
 
 void Screen::clearToEndOfScreen()
 {
-    if (isAlternateScreen() && buffer_->cursor.position.row == 1 && buffer_->cursor.position.column == 1)
-        buffer_->hyperlinks.clear();
-
     clearToEndOfLine();
+    buffer_->touchLines(realCursorPosition().row, size_.height);
+    buffer_->discardLinesBelowPage();
 
     for_each(
         LIBTERMINAL_EXECUTION_COMMA(par)
         next(buffer_->currentLine),
-        end(buffer_->lines),
+        buffer_->grid.end(),
         [&](ScreenBuffer::Line& line) {
-            fill(begin(line), end(line), Cell{{}, buffer_->cursor.graphicsRendition});
+            fill(begin(line), end(line), Cell{{}, buffer_->blankStyle()});
+            line.wrapped = false;
         }
     );
 }
@@ -471,13 +505,15 @@ void Screen::clearToEndOfScreen()
 void Screen::clearToBeginOfScreen()
 {
     clearToBeginOfLine();
+    buffer_->touchLines(1, realCursorPosition().row);
 
     for_each(
         LIBTERMINAL_EXECUTION_COMMA(par)
-        begin(buffer_->lines),
+        buffer_->lineAt(1),
         buffer_->currentLine,
         [&](ScreenBuffer::Line& line) {
-            fill(begin(line), end(line), Cell{{}, buffer_->cursor.graphicsRendition});
+            fill(begin(line), end(line), Cell{{}, buffer_->blankStyle()});
+            line.wrapped = false;
         }
     );
 }
@@ -495,7 +531,7 @@ void Screen::clearScrollbackBuffer()
     if (selector_)
         selector_.reset();
 
-    buffer_->savedLines.clear();
+    buffer_->clearHistory();
 }
 
 void Screen::eraseCharacters(int _n)
@@ -504,33 +540,38 @@ void Screen::eraseCharacters(int _n)
     // It's not clear from the spec how to perform erase when inside margin and number of chars to be erased would go outside margins.
     // TODO: See what xterm does ;-)
     size_t const n = min(buffer_->size_.width - realCursorPosition().column + 1, _n == 0 ? 1 : _n);
-    fill_n(buffer_->currentColumn, n, Cell{{}, buffer_->cursor.graphicsRendition});
+    buffer_->touchLine(*buffer_->currentLine);
+    fill_n(buffer_->currentColumn, n, Cell{{}, buffer_->blankStyle()});
 }
 
 void Screen::clearToEndOfLine()
 {
+    buffer_->touchLine(*buffer_->currentLine);
     fill(
         buffer_->currentColumn,
         end(*buffer_->currentLine),
-        Cell{{}, buffer_->cursor.graphicsRendition}
+        Cell{{}, buffer_->blankStyle()}
     );
 }
 
 void Screen::clearToBeginOfLine()
 {
+    buffer_->touchLine(*buffer_->currentLine);
     fill(
         begin(*buffer_->currentLine),
         next(buffer_->currentColumn),
-        Cell{{}, buffer_->cursor.graphicsRendition}
+        Cell{{}, buffer_->blankStyle()}
     );
 }
 
 void Screen::clearLine()
 {
+    buffer_->touchLine(*buffer_->currentLine);
+    buffer_->currentLine->wrapped = false;
     fill(
         begin(*buffer_->currentLine),
         end(*buffer_->currentLine),
-        Cell{{}, buffer_->cursor.graphicsRendition}
+        Cell{{}, buffer_->blankStyle()}
     );
 }
 
@@ -619,20 +660,9 @@ void Screen::horizontalTabSet()
 void Screen::hyperlink(string const& _id, string const& _uri)
 {
     if (_uri.empty())
-        buffer_->currentHyperlink = nullptr;
-    else if (_id.empty())
-        buffer_->currentHyperlink = make_shared<HyperlinkInfo>(HyperlinkInfo{_id, _uri});
-    else if (auto i = buffer_->hyperlinks.find(_id); i != buffer_->hyperlinks.end())
-        buffer_->currentHyperlink = i->second;
+        buffer_->currentHyperlink = 0;
     else
-    {
-        buffer_->currentHyperlink = make_shared<HyperlinkInfo>(HyperlinkInfo{_id, _uri});
-        buffer_->hyperlinks[_id] = buffer_->currentHyperlink;
-    }
-    // TODO:
-    // Care about eviction.
-    // Move hyperlink store into ScreenBuffer, so it gets reset upon every switch into
-    // alternate screen (not for main screen!)
+        buffer_->currentHyperlink = buffer_->addHyperlink(_id, _uri);
 }
 
 void Screen::moveCursorUp(int _n)
@@ -1110,16 +1140,17 @@ void Screen::screenAlignmentPattern()
     moveCursorTo({1, 1});
 
     // fills the complete screen area with a test pattern
+    buffer_->touchAll();
     for_each(
         LIBTERMINAL_EXECUTION_COMMA(par)
-        begin(buffer_->lines),
-        end(buffer_->lines),
+        buffer_->lineAt(1),
+        buffer_->grid.end(),
         [&](ScreenBuffer::Line& line) {
             fill(
                 LIBTERMINAL_EXECUTION_COMMA(par)
                 begin(line),
                 end(line),
-                Cell{'E', buffer_->cursor.graphicsRendition}
+                Cell{'E', buffer_->blankStyle()}
             );
         }
     );
@@ -1282,6 +1313,7 @@ void Screen::dumpState()
 
 // {{{ DirectExecutor
 void DirectExecutor::visit(AppendChar const& v) { screen_.writeText(v.ch); }
+void DirectExecutor::visit(AppendText const& v) { screen_.writeText(v.text); }
 void DirectExecutor::visit(ApplicationKeypadMode const& v) { screen_.applicationKeypadMode(v.enable); }
 void DirectExecutor::visit(BackIndex const&) { screen_.backIndex(); }
 void DirectExecutor::visit(Backspace const&) { screen_.backspace(); }
@@ -1361,7 +1393,7 @@ void DirectExecutor::visit(SetTopBottomMargin const& v) { screen_.setTopBottomMa
 void DirectExecutor::visit(SetUnderlineColor const& v) { screen_.setUnderlineColor(v.color); }
 void DirectExecutor::visit(SingleShiftSelect const& v) { screen_.singleShiftSelect(v.table); }
 void DirectExecutor::visit(SoftTerminalReset const&) { screen_.resetSoft(); }
-void DirectExecutor::visit(InvalidCommand const& v) { if (logger_) logger_(InvalidOutputEvent{v.sequence.text(), "Unknown command"}); }
+void DirectExecutor::visit(InvalidCommand const& v) { if (logger_) logger_(InvalidOutputEvent{v.sequence->text(), "Unknown command"}); }
 // }}}
 
 // {{{ SynchronizedExecutor
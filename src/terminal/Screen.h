@@ -27,6 +27,7 @@
 #include <terminal/Size.h>
 
 #include <crispy/algorithm.h>
+#include <crispy/span.h>
 #include <crispy/times.h>
 
 #include <unicode/grapheme_segmenter.h>
@@ -46,6 +47,7 @@
 #include <stack>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace terminal {
@@ -66,6 +68,7 @@ class DirectExecutor : public CommandVisitor {
     {}
 
     void visit(AppendChar const& v) override;
+    void visit(AppendText const& v) override;
     void visit(ApplicationKeypadMode const& v) override;
     void visit(BackIndex const& v) override;
     void visit(Backspace const& v) override;
@@ -168,6 +171,7 @@ class SynchronizedExecutor : public DirectExecutor {
     }
 
     void visit(AppendChar const& v) override { enqueue(v); }
+    void visit(AppendText const& v) override { enqueue(v); }
     void visit(BackIndex const& v) override { enqueue(v); }
     void visit(Backspace const& v) override { enqueue(v); }
     void visit(ClearLine const& v) override { enqueue(v); }
@@ -261,6 +265,18 @@ class Screen {
     void setLogRaw(bool _enabled) { logRaw_ = _enabled; }
     bool logRaw() const noexcept { return logRaw_; }
 
+    /// Enables or disables materializing the parsed commands of each write() into a CommandList.
+    ///
+    /// When disabled (the default), commands are executed as soon as they have been parsed
+    /// and ScreenEvents::commands() is passed an empty list.
+    void setRecordCommands(bool _enabled);
+    bool recordCommands() const noexcept { return !commandBuilder_.hasSink(); }
+
+    /// Limits the payload size of a single OSC or DCS control string, such as an OSC 52 clipboard
+    /// update. Control strings exceeding this limit are discarded.
+    void setMaxPayloadSize(size_t _value) noexcept { commandBuilder_.setMaxPayloadSize(_value); }
+    size_t maxPayloadSize() const noexcept { return commandBuilder_.maxPayloadSize(); }
+
     constexpr Size cellPixelSize() const noexcept { return cellPixelSize_; }
 
     constexpr void setCellPixelSize(Size _cellPixelSize)
@@ -274,8 +290,25 @@ class Screen {
     }
 
     void setMaxHistoryLineCount(std::optional<size_t> _maxHistoryLineCount);
+
+    /// Sets the number of pages of history to keep in memory before spilling older history to disk,
+    /// or nullopt for keeping all history in memory.
+    void setMaxHistoryPagesInMemory(std::optional<size_t> _count) { primaryBuffer_.setMaxHistoryPagesInMemory(_count); }
     int historyLineCount() const noexcept { return buffer_->historyLineCount(); }
 
+    /// @returns the current generation of the screen's contents, advanced by every modification.
+    ///
+    /// Generations keep increasing across switching screen buffers.
+    uint64_t generation() const noexcept { return buffer_->generation(); }
+
+    /// Invokes @p _callback with each row (1 being the top row) of the main page that has been
+    /// modified after the given generation.
+    template <typename F>
+    void forEachChangedLine(uint64_t _generation, F const& _callback) const
+    {
+        buffer_->forEachChangedLine(_generation, _callback);
+    }
+
     /// Writes given data into the screen.
     void write(char const* _data, size_t _size);
 
@@ -287,11 +320,20 @@ class Screen {
     void write(std::u32string_view const& _text);
 
     void writeText(char32_t _char);
+    void writeText(std::u32string_view _text);
 
     /// Renders the full screen by passing every grid cell to the callback.
     template <typename RendererT>
     void render(RendererT _renderer, int _scrollOffset = 0) const;
 
+    /// Renders the full screen row by row, scrolled up by @p _scrollOffset lines into the history.
+    ///
+    /// @p _renderer is invoked once per row with the row number (1 being the top row),
+    /// the line number of that row (1 being the top line of the main page and 0 the newest
+    /// history line), and the row's cells, which are only valid during that call.
+    template <typename RowRendererT>
+    void renderRows(RowRendererT _renderer, int _scrollOffset = 0) const;
+
     /// Renders a single text line.
     std::string renderTextLine(cursor_pos_t _row) const { return buffer_->renderTextLine(_row); }
 
@@ -302,10 +344,14 @@ class Screen {
     ///
     /// @note Only the screenshot of the current buffer is taken, not both (main and alternate).
     ///
-    /// @returns necessary commands needed to draw the current screen state,
-    ///          including initial clear screen, and initial cursor hide.
+    /// @returns necessary commands needed to draw the current screen state, starting with
+    ///          clearing the screen, and ending with restoring the margins, modes, cursor position
+    ///          and graphics rendition.
     std::string screenshot() const { return buffer_->screenshot(); }
 
+    /// @returns the number of commands executed so far, such as for measuring throughput.
+    uint64_t commandCount() const noexcept { return commandCount_; }
+
     void setFocus(bool _focused) { focused_ = _focused; }
     bool focused() const noexcept { return focused_; }
 
@@ -442,6 +488,8 @@ class Screen {
     void moveCursorTo(Coordinate to);
 
     /// Gets a reference to the cell relative to screen origin (top left, 1:1).
+    ///
+    /// History lines spilled to disk are read-only and must be accessed via the const overload.
     Cell& at(Coordinate const& _coord) noexcept
     {
         return buffer_->at(_coord);
@@ -450,7 +498,24 @@ class Screen {
     /// Gets a reference to the cell relative to screen origin (top left, 1:1).
     Cell const& at(Coordinate const& _coord) const noexcept
     {
-        return const_cast<Screen&>(*this).at(_coord);
+        return std::as_const(*buffer_).at(_coord);
+    }
+
+    /// @returns the hyperlink of the cell at the given coordinate, or nullptr if there is none.
+    HyperlinkInfo* hyperlinkAt(Coordinate const& _coord) noexcept
+    {
+        return buffer_->hyperlinks.hyperlinkById(std::as_const(*buffer_).at(_coord).hyperlink());
+    }
+
+    HyperlinkInfo const* hyperlinkAt(Coordinate const& _coord) const noexcept
+    {
+        return const_cast<Screen&>(*this).hyperlinkAt(_coord);
+    }
+
+    /// @returns the hyperlink of the current screen buffer with the given id, or nullptr if there is none.
+    HyperlinkInfo const* hyperlinkById(HyperlinkId _id) const noexcept
+    {
+        return buffer_->hyperlinks.hyperlinkById(_id);
     }
 
     bool isPrimaryScreen() const noexcept { return buffer_ == &primaryBuffer_; }
@@ -468,7 +533,7 @@ class Screen {
     bool horizontalMarginsEnabled() const noexcept { return isModeEnabled(Mode::LeftRightMargin); }
 
     Margin const& margin() const noexcept { return buffer_->margin_; }
-    ScreenBuffer::Lines const& scrollbackLines() const noexcept { return buffer_->savedLines; }
+    auto scrollbackLines() const noexcept { return buffer_->savedLines(); }
 
     void setTabWidth(int _value)
     {
@@ -540,6 +605,9 @@ class Screen {
   private:
     void setBuffer(ScreenBuffer::Type _type);
 
+    /// Executes a single command on the current command executor.
+    void execute(Command const& _command);
+
     // interactive replies
     void reply(std::string const& message)
     {
@@ -565,8 +633,9 @@ class Screen {
     Size cellPixelSize_; ///< contains the pixel size of a single cell, or area(cellPixelSize_) == 0 if unknown.
 
     CommandBuilder commandBuilder_;
-    parser::Parser parser_;
+    parser::Parser<> parser_;
     int64_t instructionCounter_ = 0;
+    uint64_t commandCount_ = 0;
 
     VTType terminalId_ = VTType::VT525;
 
@@ -595,43 +664,27 @@ class Screen {
 template <typename RendererT>
 void Screen::render(RendererT _render, int _scrollOffset) const
 {
-    if (!_scrollOffset)
-    {
-        crispy::for_each(
-            crispy::times(1, size_.height) * crispy::times(1, size_.width),
-            [&](auto const& _pos) {
-                auto const [row, col] = _pos;
-                auto const pos = Coordinate{row, col};
-                _render({row, col}, at(pos));
-            }
-        );
-    }
-    else
+    renderRows(
+        [&](cursor_pos_t _row, cursor_pos_t /*_line*/, crispy::span<Cell const> _cells) {
+            cursor_pos_t column = 1;
+            for (Cell const& cell : _cells)
+                _render({_row, column++}, cell);
+        },
+        _scrollOffset
+    );
+}
+
+template <typename RowRendererT>
+void Screen::renderRows(RowRendererT _render, int _scrollOffset) const
+{
+    _scrollOffset = std::clamp(_scrollOffset, 0, buffer_->historyLineCount());
+
+    for (cursor_pos_t row = 1; row <= size_.height; ++row)
     {
-        _scrollOffset = std::min(_scrollOffset, buffer_->historyLineCount());
-        auto const historyLineCount = std::min(size_.height, static_cast<int>(_scrollOffset));
-        auto const mainLineCount = size_.height - historyLineCount;
-
-        cursor_pos_t rowNumber = 1;
-
-        // render first part from history
-        for (auto line = prev(end(buffer_->savedLines), _scrollOffset); rowNumber <= historyLineCount; ++line, ++rowNumber)
-        {
-            if (static_cast<int>(line->size()) < size_.width)
-                line->resize(size_.width);
-
-            auto column = begin(*line);
-            for (cursor_pos_t colNumber = 1; colNumber <= size_.width; ++colNumber, ++column)
-                _render({rowNumber, colNumber}, *column);
-        }
-
-        // render second part from main screen buffer
-        for (auto line = begin(buffer_->lines); line != next(begin(buffer_->lines), mainLineCount); ++line, ++rowNumber)
-        {
-            auto column = begin(*line);
-            for (cursor_pos_t colNumber = 1; colNumber <= size_.width; ++colNumber, ++column)
-                _render({rowNumber, colNumber}, *column);
-        }
+        // Reading line by line, as older history may have to be paged in, and history lines be decoded.
+        auto const line = row - _scrollOffset;
+        auto const& cells = buffer_->cellsOf(buffer_->readLine(line));
+        _render(row, line, crispy::span<Cell const>{cells.data(), cells.data() + size_.width});
     }
 }
 // }}}
@@ -19,9 +19,12 @@
 
 #include <crispy/times.h>
 #include <crispy/algorithm.h>
+#include <crispy/FNV.h>
 #include <crispy/utils.h>
 
 #include <algorithm>
+#include <array>
+#include <cstring>
 #include <stdexcept>
 #include <iostream>
 #include <optional>
@@ -38,6 +41,7 @@ using std::endl;
 using std::min;
 using std::max;
 using std::next;
+using std::prev;
 using std::nullopt;
 using std::optional;
 using std::string;
@@ -46,9 +50,297 @@ using crispy::for_each;
 
 namespace terminal {
 
+namespace // {{{ helpers
+{
+    uint64_t hashValue(Color const& _color) noexcept
+    {
+        auto const payload = [&]() -> uint64_t {
+            if (std::holds_alternative<RGBColor>(_color))
+            {
+                auto const rgb = std::get<RGBColor>(_color);
+                return (rgb.red << 16) | (rgb.green << 8) | rgb.blue;
+            }
+            else if (std::holds_alternative<IndexedColor>(_color))
+                return static_cast<uint64_t>(std::get<IndexedColor>(_color));
+            else if (std::holds_alternative<BrightColor>(_color))
+                return static_cast<uint64_t>(std::get<BrightColor>(_color));
+            else
+                return 0;
+        }();
+        return (static_cast<uint64_t>(_color.index()) << 32) | payload;
+    }
+} // }}}
+
+// {{{ CellStyle
+bool operator==(CellStyle const& a, CellStyle const& b) noexcept
+{
+    return a.attributes == b.attributes
+        && a.cluster == b.cluster;
+}
+
+size_t CellStyleHash::operator()(CellStyle const& _style) const noexcept
+{
+    auto constexpr fnv = crispy::FNV<uint64_t>{};
+
+    auto const& attributes = _style.attributes;
+    auto const values = std::array<uint64_t, 4>{
+        hashValue(attributes.foregroundColor),
+        hashValue(attributes.backgroundColor),
+        hashValue(attributes.underlineColor),
+        attributes.styles.mask()
+    };
+
+    auto hash = fnv(values.data(), values.size());
+    for (char32_t const codepoint : _style.cluster)
+        hash = fnv(hash, codepoint);
+
+    return static_cast<size_t>(hash);
+}
+
+CellStyle const& CellStyleTable::intern(CellStyle const& _style)
+{
+    return *styles_.insert(_style).first;
+}
+
+void CellStyleTable::sweep()
+{
+    for (auto i = styles_.begin(); i != styles_.end(); )
+    {
+        if (i->marked)
+        {
+            i->marked = false;
+            ++i;
+        }
+        else
+            i = styles_.erase(i);
+    }
+}
+// }}}
+
 std::string Cell::toUtf8() const
 {
-    return unicode::to_utf8(codepoints_.data(), codepointCount_);
+    auto const text = codepoints();
+    return unicode::to_utf8(text.data(), text.size());
+}
+
+// {{{ Line
+ScreenBuffer::LineBuffer ScreenBuffer::Line::compress()
+{
+    assert(!compressed_);
+
+    auto const looksAlike = [](Cell const& a, Cell const& b) noexcept {
+        return &a.style() == &b.style() && a.hyperlink() == b.hyperlink();
+    };
+
+    packed.clear();
+    packed.columns = buffer.size();
+
+    // Trailing empty cells looking alike are fully described by their style and hyperlink.
+    auto end = buffer.size();
+    if (end != 0 && buffer.back().empty())
+    {
+        Cell const& fill = buffer.back();
+        packed.fillStyle = &fill.style();
+        packed.fillHyperlink = fill.hyperlink();
+        while (end != 0 && buffer[end - 1].empty() && looksAlike(buffer[end - 1], fill))
+            --end;
+    }
+
+    for (size_t i = 0; i < end; ++i)
+    {
+        Cell const& cell = buffer[i];
+
+        if (packed.spans.empty() || packed.spans.back().style != &cell.style() || packed.spans.back().hyperlink != cell.hyperlink())
+            packed.spans.push_back(CompressedLine::Span{&cell.style(), cell.hyperlink(), 0});
+        packed.spans.back().length++;
+
+        if (cell.empty())
+            packed.text.push_back('\0');
+        else
+        {
+            uint8_t utf8[4];
+            auto const n = unicode::to_utf8(cell.codepoint(0), utf8);
+            packed.text.append(reinterpret_cast<char const*>(utf8), n);
+        }
+    }
+
+    // Storage retained from compressing a much longer line would defeat the purpose.
+    if (packed.text.capacity() > 2 * packed.text.size() + 64)
+        packed.text.shrink_to_fit();
+    if (packed.spans.capacity() > 2 * packed.spans.size() + 4)
+        packed.spans.shrink_to_fit();
+
+    compressed_ = true;
+
+    LineBuffer cells;
+    cells.swap(buffer);
+    return cells;
+}
+
+void ScreenBuffer::Line::inflate()
+{
+    assert(compressed_);
+
+    LineBuffer cells;
+    decode(cells, 0);
+    buffer.swap(cells);
+    packed.clear();
+    compressed_ = false;
+}
+
+void ScreenBuffer::Line::decode(LineBuffer& _output, size_t _columns) const
+{
+    _output.clear();
+
+    if (!compressed_)
+    {
+        _output.assign(buffer.begin(), buffer.end());
+        if (_output.size() < _columns)
+            _output.resize(_columns, Cell{});
+        return;
+    }
+
+    _output.reserve(std::max(packed.columns, _columns));
+
+    auto decoder = unicode::utf8_decoder_state{};
+    auto byte = packed.text.begin();
+    auto const nextCodepoint = [&]() -> char32_t {
+        for (;;)
+        {
+            auto const value = static_cast<uint8_t>(*byte++);
+            if (value < 0x80)
+                return value;
+            else if (auto const result = unicode::from_utf8(decoder, value); std::holds_alternative<unicode::Success>(result))
+                return std::get<unicode::Success>(result).value;
+        }
+    };
+
+    for (CompressedLine::Span const& span : packed.spans)
+        for (uint32_t i = 0; i < span.length; ++i)
+            _output.emplace_back(nextCodepoint(), *span.style, span.hyperlink);
+
+    _output.resize(std::max(packed.columns, _columns), Cell{{}, *packed.fillStyle, packed.fillHyperlink});
+}
+
+void ScreenBuffer::Line::reset(LineBuffer&& _storage, size_t _columns, Cell const& _fill)
+{
+    buffer = std::move(_storage);
+    buffer.assign(_columns, _fill);
+    packed.clear();
+    compressed_ = false;
+    marked = false;
+    wrapped = false;
+}
+// }}}
+
+CellStyle const& ScreenBuffer::internStyle(CellStyle const& _style)
+{
+    if (cellStyles.size() >= cellStyleCollectionThreshold_)
+        collectCellStyles();
+
+    return cellStyles.intern(_style);
+}
+
+void ScreenBuffer::collectCellStyles()
+{
+    auto const mark = [](CellStyle const* _style) {
+        // The default style is shared by all buffers and not part of any table.
+        if (_style != &DefaultCellStyle)
+            _style->marked = true;
+    };
+
+    auto const markLine = [&](Line const& _line) {
+        if (_line.compressed())
+        {
+            for (CompressedLine::Span const& span : _line.packed.spans)
+                mark(span.style);
+            mark(_line.packed.fillStyle);
+            return;
+        }
+
+        CellStyle const* last = nullptr;
+        for (Cell const& cell : _line.buffer)
+        {
+            // Neighbouring cells very likely share their style.
+            if (&cell.style() != last)
+            {
+                last = &cell.style();
+                mark(last);
+            }
+        }
+    };
+
+    std::for_each(grid.begin(), grid.end(), markLine);
+    for_each(linesBelowPage_, markLine);
+
+    for (SpilledPage const& page : spilledPages_)
+        for (CellStyle const* style : page.styles)
+            mark(style);
+
+    mark(blankStyle_);
+
+    cellStyles.sweep();
+
+    cellStyleCollectionThreshold_ = max(MinCellStyleCollectionThreshold, 2 * cellStyles.size());
+}
+
+HyperlinkId ScreenBuffer::addHyperlink(std::string const& _id, std::string const& _uri)
+{
+    if (auto const id = hyperlinks.add(_id, _uri); id != 0)
+        return id;
+
+    // With all hyperlinks in use at maximum capacity, scanning the grid again right away
+    // would most likely not free anything either.
+    if (hyperlinkCollectionBackoff_ != 0)
+    {
+        --hyperlinkCollectionBackoff_;
+        return 0;
+    }
+
+    // Growing the storage while most hyperlinks are still in use keeps the number of
+    // collections logarithmic in the number of live hyperlinks.
+    if (collectHyperlinks() < hyperlinks.capacity() / 4)
+        hyperlinks.reserve(2 * hyperlinks.capacity());
+
+    if (hyperlinks.full())
+        hyperlinkCollectionBackoff_ = hyperlinks.capacity() / 4;
+
+    return hyperlinks.add(_id, _uri);
+}
+
+size_t ScreenBuffer::collectHyperlinks()
+{
+    auto const markLine = [&](Line const& _line) {
+        if (_line.compressed())
+        {
+            for (CompressedLine::Span const& span : _line.packed.spans)
+                hyperlinks.mark(span.hyperlink);
+            hyperlinks.mark(_line.packed.fillHyperlink);
+            return;
+        }
+
+        HyperlinkId last = 0;
+        for (Cell const& cell : _line.buffer)
+        {
+            if (cell.hyperlink() != last)
+            {
+                last = cell.hyperlink();
+                hyperlinks.mark(last);
+            }
+        }
+    };
+
+    std::for_each(grid.begin(), grid.end(), markLine);
+    for_each(linesBelowPage_, markLine);
+
+    for (SpilledPage const& page : spilledPages_)
+        for (HyperlinkId const id : page.hyperlinks)
+            hyperlinks.mark(id);
+
+    hyperlinks.mark(currentHyperlink);
+
+    // Evicting a quarter at once amortizes the cost of scanning the grid.
+    return hyperlinks.sweep(std::max(hyperlinks.capacity() / 4, size_t{1}));
 }
 
 std::optional<int> ScreenBuffer::findMarkerBackward(int _currentCursorLine) const
@@ -65,7 +357,7 @@ std::optional<int> ScreenBuffer::findMarkerBackward(int _currentCursorLine) cons
         int row = _currentCursorLine - 1;
         while (row > 0)
         {
-            auto const currentLine = next(begin(lines), row - 1);
+            auto const currentLine = lineAt(row);
             if (currentLine->marked)
                 return {row};
 
@@ -77,7 +369,7 @@ std::optional<int> ScreenBuffer::findMarkerBackward(int _currentCursorLine) cons
     auto const scrollOffset = _currentCursorLine <= 0 ? -_currentCursorLine + 1 : 0;
 
     for (int i = scrollOffset; i < historyLineCount(); ++i)
-        if (Line const& line = savedLines.at(historyLineCount() - i - 1); line.marked)
+        if (isLineMarked(-i))
             return -i;
 
     return nullopt;
@@ -86,11 +378,11 @@ std::optional<int> ScreenBuffer::findMarkerBackward(int _currentCursorLine) cons
 std::optional<int> ScreenBuffer::findMarkerForward(int _currentCursorLine) const
 {
     for (int i = _currentCursorLine + 1; i <= 0; ++i)
-        if (int const ri = historyLineCount() + i - 1; savedLines.at(ri).marked)
+        if (isLineMarked(i))
             return {i};
 
     for (int i = max(_currentCursorLine + 1, 1); i <= size_.height; ++i)
-        if (Line const& line = lines.at(i - 1); line.marked)
+        if (Line const& line = *lineAt(i); line.marked)
             return {i};
 
     return nullopt;
@@ -98,60 +390,93 @@ std::optional<int> ScreenBuffer::findMarkerForward(int _currentCursorLine) const
 
 void ScreenBuffer::resize(Size const& _newSize)
 {
+    invalidateDecodedLines();
+
+    // The main buffer's text is re-wrapped to the new width, whereas the alternate buffer's
+    // full-screen applications redraw anyway.
+    if (type_ == Type::Main && _newSize.width != size_.width)
+        reflowPage(_newSize.width);
+
     if (_newSize.height > size_.height)
     {
-        // Grow line count by splicing available lines from history back into buffer, if available,
+        // Grow line count by taking available lines from history back into the main page, if available,
         // or create new ones until size_.height == _newSize.height.
         auto const extendCount = _newSize.height - size_.height;
-        auto const rowsToTakeFromSavedLines = min(extendCount, static_cast<int>(std::size(savedLines)));
+        reflowHistory(extendCount);
+        // Only history lines still in memory are taken back.
+        auto const rowsToTakeFromSavedLines = min(extendCount, inMemoryHistoryLineCount());
 
-        for_each(
-            crispy::times(rowsToTakeFromSavedLines),
-            [&](auto) {
-                savedLines.back().resize(_newSize.width);
-                lines.emplace_front(std::move(savedLines.back()));
-                savedLines.pop_back();
+        // The newest history lines become part of the main page just by growing its height.
+        std::for_each(
+            lineAt(1 - rowsToTakeFromSavedLines),
+            lineAt(1),
+            [&](Line& line) {
+                if (line.compressed())
+                    line.inflate();
+                line.resize(_newSize.width);
             }
         );
 
         cursor.position.row += rowsToTakeFromSavedLines;
 
+        // Lines previously moved below the page come back first.
         auto const fillLineCount = extendCount - rowsToTakeFromSavedLines;
-        generate_n(
-            back_inserter(lines),
-            fillLineCount,
-            [=]() { return Line{static_cast<size_t>(_newSize.width), Cell{}}; });
+        auto const restoreCount = min(static_cast<size_t>(fillLineCount), linesBelowPage_.size());
+        for (size_t i = 0; i < restoreCount; ++i)
+        {
+            Line& line = grid.emplace_back(std::move(linesBelowPage_[i]));
+            if (line.compressed())
+                line.inflate();
+            line.resize(_newSize.width);
+        }
+        linesBelowPage_.erase(linesBelowPage_.begin(), next(linesBelowPage_.begin(), static_cast<int>(restoreCount)));
+
+        for_each(
+            crispy::times(fillLineCount - static_cast<int>(restoreCount)),
+            [&](auto) { grid.emplace_back(static_cast<size_t>(_newSize.width), Cell{}); }
+        );
+
+        size_.height = _newSize.height;
     }
     else if (_newSize.height < size_.height)
     {
         // Shrink existing line count to _newSize.height
-        // by splicing the number of lines to be shrinked by into savedLines bottom.
+        // by moving the number of lines to be shrinked by into the history.
+        auto const n = size_.height - _newSize.height;
         if (cursor.position.row == size_.height)
         {
-            auto const n = size_.height - _newSize.height;
-            for_each(
-                crispy::times(n),
-                [&](auto) {
-                    lines.front().resize(_newSize.width);
-                    savedLines.emplace_back(std::move(lines.front()));
-                    lines.pop_front();
+            // The top lines of the main page become part of the history just by shrinking its height.
+            std::for_each(
+                lineAt(1),
+                lineAt(1 + n),
+                [&](Line& line) {
+                    line.resize(_newSize.width);
+                    line.compress();
                 }
             );
+            size_.height = _newSize.height;
             clampSavedLines();
+            spillHistory();
         }
         else
-            // Hard-cut below cursor by the number of lines to shrink.
-            lines.resize(_newSize.height);
-
-        assert(lines.size() == static_cast<size_t>(_newSize.height));
+        {
+            // Cut below cursor by the number of lines to shrink, keeping them below the page.
+            auto const pageEnd = prev(grid.end(), n);
+            std::for_each(pageEnd, grid.end(), [](Line& _line) { _line.compress(); });
+            linesBelowPage_.insert(linesBelowPage_.begin(),
+                                   std::make_move_iterator(pageEnd),
+                                   std::make_move_iterator(grid.end()));
+            grid.erase(prev(grid.cend(), n), grid.cend());
+            size_.height = _newSize.height;
+        }
     }
 
     if (_newSize.width > size_.width)
     {
         // Grow existing columns to _newSize.width.
         std::for_each(
-            begin(lines),
-            end(lines),
+            lineAt(1),
+            grid.end(),
             [=](auto& line) { line.resize(_newSize.width); }
         );
         if (wrapPending)
@@ -164,12 +489,12 @@ void ScreenBuffer::resize(Size const& _newSize)
         // Nothing should be done, I think, as we preserve prior (now exceeding) content.
         if (cursor.position.column == size_.width)
             wrapPending = true;
-
-        // truncating tabs
-        while (!tabs.empty() && tabs.back() > _newSize.width)
-            tabs.pop_back();
     }
 
+    // truncating tabs
+    while (!tabs.empty() && tabs.back() > _newSize.width)
+        tabs.pop_back();
+
     // Reset margin to their default.
     margin_ = Margin{
 		Margin::Range{1, _newSize.height},
@@ -180,11 +505,203 @@ void ScreenBuffer::resize(Size const& _newSize)
     size_ = _newSize;
 
     lastCursorPosition = clampCoordinate(lastCursorPosition);
-    auto lastLine = next(begin(lines), lastCursorPosition.row - 1);
+    auto lastLine = lineAt(lastCursorPosition.row);
     lastColumn = columnIteratorAt(begin(*lastLine), lastCursorPosition.column);
 
     cursor.position = clampCoordinate(cursor.position);
     updateCursorIterators();
+    touchAll();
+}
+
+std::vector<ScreenBuffer::Line> ScreenBuffer::reflow(size_t _first,
+                                                      size_t _last,
+                                                      size_t _width,
+                                                      crispy::span<ReflowCursor> _cursors) const
+{
+    auto const looksAlike = [](Cell const& a, Cell const& b) noexcept {
+        return &a.style() == &b.style() && a.hyperlink() == b.hyperlink();
+    };
+
+    auto lines = std::vector<Line>{};
+    auto cells = LineBuffer{};
+    auto decoded = LineBuffer{};
+    auto offsets = std::vector<optional<size_t>>(_cursors.size());    // cursor offsets into cells
+    auto moved = std::vector<optional<ReflowCursor>>(_cursors.size());
+
+    for (size_t i = _first; i != _last; )
+    {
+        // Joins the cells of the logical line starting at i.
+        bool const marked = grid[i].marked;
+        std::fill(offsets.begin(), offsets.end(), nullopt);
+        cells.clear();
+        do
+        {
+            for (size_t k = 0; k < _cursors.size(); ++k)
+                if (_cursors[k].line == i - _first)
+                    offsets[k] = cells.size() + _cursors[k].column + (_cursors[k].wrapPending ? 1 : 0);
+
+            grid[i].decode(decoded, 0);
+            cells.insert(cells.end(), decoded.begin(), decoded.end());
+            ++i;
+        }
+        while (i != _last && grid[i].wrapped);
+
+        // Trailing blank cells looking like the last one merely fill up the line.
+        auto const filler = !cells.empty() && cells.back().empty() ? cells.back() : Cell{};
+        auto length = cells.size();
+        while (length != 0 && cells[length - 1].empty() && looksAlike(cells[length - 1], filler))
+            --length;
+
+        lines.emplace_back(_width, filler);
+        lines.back().marked = marked;
+        size_t column = 0;
+
+        for (size_t source = 0; source < length; )
+        {
+            auto const span = static_cast<size_t>(max(cells[source].width(), 1));
+            auto const columns = min(span, _width);
+
+            if (column + columns > _width)
+            {
+                lines.emplace_back(_width, filler);
+                lines.back().wrapped = true;
+                column = 0;
+            }
+
+            for (size_t k = 0; k < _cursors.size(); ++k)
+                if (offsets[k] && !moved[k] && *offsets[k] < source + span)
+                    moved[k] = ReflowCursor{lines.size() - 1, column + min(*offsets[k] - source, columns - 1), false};
+
+            for (size_t n = 0; n < columns; ++n)
+                lines.back()[column + n] = source + n < cells.size() ? cells[source + n] : Cell{};
+
+            column += columns;
+            source += span;
+        }
+
+        // Positions behind the text keep their distance to it, within the bounds of the line.
+        for (size_t k = 0; k < _cursors.size(); ++k)
+        {
+            if (!offsets[k] || moved[k])
+                continue;
+
+            auto const target = column + (*offsets[k] - length);
+            if (target < _width)
+                moved[k] = ReflowCursor{lines.size() - 1, target, false};
+            else
+                moved[k] = ReflowCursor{lines.size() - 1, _width - 1, target == _width && *offsets[k] == length};
+        }
+    }
+
+    for (size_t k = 0; k < _cursors.size(); ++k)
+        if (moved[k])
+            _cursors[k] = *moved[k];
+
+    return lines;
+}
+
+void ScreenBuffer::reflowPage(cursor_pos_t _width)
+{
+    auto const width = static_cast<size_t>(_width);
+    auto const height = static_cast<size_t>(size_.height);
+    auto const pageTop = static_cast<size_t>(inMemoryHistoryLineCount());
+
+    // Lines cut off by a previous re-wrap continue the page.
+    grid.insert(grid.cend(), std::make_move_iterator(linesBelowPage_.begin()), std::make_move_iterator(linesBelowPage_.end()));
+    linesBelowPage_.clear();
+
+    // The page's first logical line may have begun in the history.
+    auto first = pageTop;
+    while (first != 0 && grid[first].wrapped)
+        --first;
+
+    auto positions = std::array<ReflowCursor, 2>{
+        ReflowCursor{pageTop - first, 0, false},
+        ReflowCursor{
+            pageTop - first + static_cast<size_t>(cursor.position.row - 1),
+            static_cast<size_t>(cursor.position.column - 1),
+            wrapPending
+        }
+    };
+    auto lines = reflow(first, grid.size(), width, {positions.data(), positions.data() + positions.size()});
+    auto const top = positions[0].line;
+    auto const cursorLine = positions[1].line;
+
+    // Blank lines below the cursor are dropped, and the page fills up with blank lines again
+    // at its bottom. If the text does not fit the page, the lines above the cursor move into
+    // the history, and only then lines below the cursor are moved below the page.
+    auto const isBlank = [](Line const& _line) {
+        return !_line.marked && std::all_of(_line.buffer.begin(), _line.buffer.end(),
+                                            [](Cell const& _cell) { return _cell.empty(); });
+    };
+    while (lines.size() > cursorLine + 1 && isBlank(lines.back()))
+        lines.pop_back();
+
+    auto const pageBegin = min(lines.size() - top > height ? lines.size() - height : top, cursorLine);
+    if (lines.size() > pageBegin + height)
+    {
+        auto const pageEnd = next(lines.begin(), static_cast<int>(pageBegin + height));
+        std::for_each(pageEnd, lines.end(), [](Line& _line) { _line.compress(); });
+        linesBelowPage_.assign(std::make_move_iterator(pageEnd), std::make_move_iterator(lines.end()));
+        lines.erase(pageEnd, lines.end());
+    }
+    while (lines.size() < pageBegin + height)
+        lines.emplace_back(width, Cell{});
+
+    for (size_t i = 0; i < pageBegin; ++i)
+        lines[i].compress();
+
+    grid.erase(next(grid.cbegin(), static_cast<int>(first)), grid.cend());
+    grid.insert(grid.cend(), std::make_move_iterator(lines.begin()), std::make_move_iterator(lines.end()));
+
+    // All older history lines are still to be re-wrapped, as they get viewed.
+    unreflowedHistoryLines_ = first;
+
+    size_.width = _width;
+    cursor.position.row = static_cast<cursor_pos_t>(cursorLine - pageBegin + 1);
+    cursor.position.column = static_cast<cursor_pos_t>(positions[1].column + 1);
+    wrapPending = positions[1].wrapPending;
+
+    clampSavedLines();
+    spillHistory();
+    updateCursorIterators();
+}
+
+void ScreenBuffer::reflowHistory(int _lineCount)
+{
+    if (unreflowedHistoryLines_ == 0
+            || inMemoryHistoryLineCount() - static_cast<int>(unreflowedHistoryLines_) >= _lineCount)
+        return;
+
+    invalidateDecodedLines();
+
+    while (unreflowedHistoryLines_ != 0
+            && inMemoryHistoryLineCount() - static_cast<int>(unreflowedHistoryLines_) < _lineCount)
+    {
+        // Re-wrapping at least a page of history at a time amortizes moving the newer lines.
+        // The range always ends at the beginning of a logical line, and is extended to start at one.
+        auto const last = unreflowedHistoryLines_;
+        auto first = last - min(last, HistoryPageLineCount);
+        while (first != 0 && grid[first].wrapped)
+            --first;
+
+        auto lines = reflow(first, last, static_cast<size_t>(size_.width), {});
+        for (Line& line : lines)
+            line.compress();
+
+        grid.erase(next(grid.cbegin(), static_cast<int>(first)), next(grid.cbegin(), static_cast<int>(last)));
+        grid.insert(next(grid.cbegin(), static_cast<int>(first)),
+                    std::make_move_iterator(lines.begin()),
+                    std::make_move_iterator(lines.end()));
+        unreflowedHistoryLines_ = first;
+    }
+
+    // Rows of the history do not address the same lines anymore.
+    ++generation_;
+
+    clampSavedLines();
+    spillHistory();
+    updateCursorIterators();
 }
 
 void ScreenBuffer::setMode(Mode _mode, bool _enable)
@@ -228,14 +745,56 @@ void ScreenBuffer::setCursor(Cursor const& _cursor)
 }
 
 Cell& ScreenBuffer::at(Coordinate const& _pos) noexcept
+{
+    // History lines spilled to disk are read-only, and only accessible via the const overload.
+    assert(crispy::ascending(1 - inMemoryHistoryLineCount(), _pos.row, size_.height));
+    assert(crispy::ascending(1, _pos.column, size_.width));
+
+    Line& line = *lineAt(_pos.row);
+    if (line.compressed())
+    {
+        invalidateDecodedLines();
+        line.inflate();
+    }
+
+    return line[_pos.column - 1];
+}
+
+Cell const& ScreenBuffer::at(Coordinate const& _pos) const noexcept
 {
     assert(crispy::ascending(1 - historyLineCount(), _pos.row, size_.height));
     assert(crispy::ascending(1, _pos.column, size_.width));
 
-    if (_pos.row > 0)
-        return (*next(begin(lines), _pos.row - 1))[_pos.column - 1];
-    else
-        return (*next(rbegin(savedLines), -_pos.row))[_pos.column - 1];
+    Line const& line = readLine(_pos.row);
+    if (!line.compressed())
+        return line[_pos.column - 1];
+
+    return cellsOf(line)[_pos.column - 1];
+}
+
+ScreenBuffer::LineBuffer const& ScreenBuffer::cellsOf(Line const& _line) const
+{
+    auto const columns = static_cast<size_t>(size_.width);
+
+    if (!_line.compressed() && _line.size() >= columns)
+        return _line.buffer;
+
+    for (DecodedLine const& decoded : decodedLines_)
+        if (decoded.line == &_line)
+            return decoded.cells;
+
+    DecodedLine& decoded = decodedLines_[nextDecodedLine_];
+    nextDecodedLine_ = (nextDecodedLine_ + 1) % decodedLines_.size();
+
+    decoded.line = &_line;
+    _line.decode(decoded.cells, columns);
+    return decoded.cells;
+}
+
+void ScreenBuffer::invalidateDecodedLines() const noexcept
+{
+    for (DecodedLine& decoded : decodedLines_)
+        decoded.line = nullptr;
 }
 
 void ScreenBuffer::linefeed(cursor_pos_t _newColumn)
@@ -266,7 +825,10 @@ void ScreenBuffer::appendChar(char32_t _ch, bool _consecutive)
     verifyState();
 
     if (wrapPending && cursor.autoWrap)
+    {
         linefeed(margin_.horizontal.from);
+        currentLine->wrapped = !isModeEnabled(Mode::LeftRightMargin);
+    }
 
     auto const ch =
         _ch < 127 ? cursor.charsets.map(static_cast<char>(_ch))
@@ -281,13 +843,76 @@ void ScreenBuffer::appendChar(char32_t _ch, bool _consecutive)
         writeCharToCurrentAndAdvance(ch);
     else
     {
-        auto const extendedWidth = lastColumn->appendCharacter(ch);
+        // The previous character may have been written at the end of the previous line.
+        touchLine(*lineAt(lastCursorPosition.row));
+        touchLine(*currentLine);
+
+        auto const extendedWidth = lastColumn->appendCharacter(ch, cellStyles);
 
         if (extendedWidth > 0)
             clearAndAdvance(extendedWidth);
     }
 }
 
+void ScreenBuffer::appendText(std::u32string_view _text, bool _consecutive)
+{
+    auto constexpr isPrintableASCII = [](char32_t _ch) constexpr { return 0x20 <= _ch && _ch < 0x7F; };
+
+    if (_text.empty())
+        return;
+
+    // The first codepoint may continue a grapheme cluster started by previously written text.
+    auto i = begin(_text);
+    appendChar(*i++, _consecutive);
+
+    while (i != end(_text))
+    {
+        // Grapheme clusters never join two printable US-ASCII characters, so only those
+        // can bypass the segmentation check. Anything else takes the generic path.
+        if (!isPrintableASCII(*i) || !isPrintableASCII(*std::prev(i))
+                || (isModeEnabled(Mode::LeftRightMargin) && !isCursorInsideMargins()))
+        {
+            appendChar(*i++, true);
+            continue;
+        }
+
+        if (wrapPending && cursor.autoWrap)
+        {
+            linefeed(margin_.horizontal.from);
+            currentLine->wrapped = !isModeEnabled(Mode::LeftRightMargin);
+        }
+
+        auto const rightColumn = isModeEnabled(Mode::LeftRightMargin) ? margin_.horizontal.to : size_.width;
+        auto const& style = textStyle();
+        touchLine(*currentLine);
+
+        do
+        {
+            Cell& cell = *currentColumn;
+            cell.setCharacter(cursor.charsets.map(static_cast<char>(*i++)), style, currentHyperlink);
+
+            lastColumn = currentColumn;
+            lastCursorPosition = cursor.position;
+
+            if (auto const width = cell.width(); width <= rightColumn - cursor.position.column)
+            {
+                cursor.position.column += width;
+                currentColumn++;
+                for (int k = 1; k < width; ++k)
+                    (currentColumn++)->reset(style, currentHyperlink);
+            }
+            else if (cursor.autoWrap)
+            {
+                wrapPending = true;
+                break;
+            }
+        }
+        while (i != end(_text) && isPrintableASCII(*i));
+    }
+
+    verifyState();
+}
+
 void ScreenBuffer::clearAndAdvance(int _offset)
 {
     if (_offset == 0)
@@ -300,8 +925,9 @@ void ScreenBuffer::clearAndAdvance(int _offset)
     {
         assert(n > 0);
         cursor.position.column += n;
+        auto const& style = textStyle();
         for (auto i = 0; i < n; ++i)
-            (currentColumn++)->reset(cursor.graphicsRendition, currentHyperlink);
+            (currentColumn++)->reset(style, currentHyperlink);
     }
     else if (cursor.autoWrap)
     {
@@ -311,10 +937,11 @@ void ScreenBuffer::clearAndAdvance(int _offset)
 
 void ScreenBuffer::writeCharToCurrentAndAdvance(char32_t _character)
 {
+    touchLine(*currentLine);
+
+    auto const& style = textStyle();
     Cell& cell = *currentColumn;
-    cell.setCharacter(_character);
-    cell.attributes() = cursor.graphicsRendition;
-    cell.setHyperlink(currentHyperlink);
+    cell.setCharacter(_character, style, currentHyperlink);
 
     lastColumn = currentColumn;
     lastCursorPosition = cursor.position;
@@ -331,7 +958,7 @@ void ScreenBuffer::writeCharToCurrentAndAdvance(char32_t _character)
         cursor.position.column += n;
         currentColumn++;
         for (int i = 1; i < n; ++i)
-            (currentColumn++)->reset(cursor.graphicsRendition, currentHyperlink);
+            (currentColumn++)->reset(style, currentHyperlink);
         verifyState();
     }
     else if (cursor.autoWrap)
@@ -350,6 +977,9 @@ void ScreenBuffer::scrollUp(cursor_pos_t v_n)
 
 void ScreenBuffer::scrollUp(cursor_pos_t v_n, Margin const& margin)
 {
+    if (margin.vertical.to == size_.height)
+        discardLinesBelowPage();
+
     if (margin.horizontal != Margin::Range{1, size_.width})
     {
         // a full "inside" scroll-up
@@ -358,9 +988,9 @@ void ScreenBuffer::scrollUp(cursor_pos_t v_n, Margin const& margin)
 
         if (n < marginHeight)
         {
-            auto targetLine = next(begin(lines), margin.vertical.from - 1);     // target line
-            auto sourceLine = next(begin(lines), margin.vertical.from - 1 + n); // source line
-            auto const bottomLine = next(begin(lines), margin.vertical.to);     // bottom margin's end-line iterator
+            auto targetLine = lineAt(margin.vertical.from);     // target line
+            auto sourceLine = lineAt(margin.vertical.from + n); // source line
+            auto const bottomLine = lineAt(margin.vertical.to + 1);     // bottom margin's end-line iterator
 
             for (; sourceLine != bottomLine; ++sourceLine, ++targetLine)
             {
@@ -373,16 +1003,16 @@ void ScreenBuffer::scrollUp(cursor_pos_t v_n, Margin const& margin)
         }
 
         // clear bottom n lines in margin.
-        auto const topLine = next(begin(lines), margin.vertical.to - n);
-        auto const bottomLine = next(begin(lines), margin.vertical.to);     // bottom margin's end-line iterator
-        for_each(
+        auto const topLine = lineAt(margin.vertical.to - n + 1);
+        auto const bottomLine = lineAt(margin.vertical.to + 1);     // bottom margin's end-line iterator
+        std::for_each(
             topLine,
             bottomLine,
             [&](ScreenBuffer::Line& line) {
                 fill_n(
                     next(begin(line), margin.horizontal.from - 1),
                     margin.horizontal.length(),
-                    Cell{{}, cursor.graphicsRendition}
+                    Cell{{}, blankStyle()}
                 );
             }
         );
@@ -392,24 +1022,47 @@ void ScreenBuffer::scrollUp(cursor_pos_t v_n, Margin const& margin)
         // full-screen scroll-up
         auto const n = min(v_n, size_.height);
 
-        if (n > 0)
-        {
-            for_each(
-                crispy::times(n),
-                [&](auto) {
-                    savedLines.emplace_back(std::move(lines.front()));
-                    lines.pop_front();
-                }
-            );
+        auto const blank = Cell{{}, blankStyle()};
+        auto const width = static_cast<size_t>(size_.width);
 
-            clampSavedLines();
+        invalidateDecodedLines();
 
-            generate_n(
-                back_inserter(lines),
-                n,
-                [this]() { return Line{static_cast<size_t>(size_.width), Cell{{}, cursor.graphicsRendition}}; }
-            );
+        for (int i = 0; i < n; ++i)
+        {
+            // With history spilled to disk, clampSavedLines() drops the oldest spilled lines instead.
+            bool const historyFull = spilledPages_.empty()
+                                  && maxHistoryLineCount_.has_value()
+                                  && static_cast<size_t>(historyLineCount()) >= maxHistoryLineCount_.value();
+            if (historyFull && maxHistoryLineCount_.value() == 0)
+            {
+                // Without any history, the top line is recycled as the new bottom line.
+                grid.rotate_left(1);
+                Line& line = grid.back();
+                line.resize(width);
+                line.marked = false;
+                line.wrapped = false;
+                fill(begin(line), end(line), blank);
+            }
+            else
+            {
+                // The top line of the main page becomes the newest history line, in compact form,
+                // handing its cell storage over to the new bottom line. That is the oldest history
+                // line if the history is full. Otherwise it is a line previously dropped from the history,
+                // whose compressed storage is reused when it gets compressed again, or a new line.
+                auto cells = lineAt(1)->compress();
+                if (historyFull)
+                {
+                    grid.rotate_left(1);
+                    dropUnreflowedLines(1);
+                }
+                else
+                    grid.recycle_back();
+                grid.back().reset(std::move(cells), width, blank);
+            }
         }
+
+        clampSavedLines();
+        spillHistory();
     }
     else
     {
@@ -418,23 +1071,33 @@ void ScreenBuffer::scrollUp(cursor_pos_t v_n, Margin const& margin)
         auto const n = min(v_n, marginHeight);
         if (n < marginHeight)
         {
-            rotate(
-                next(begin(lines), margin.vertical.from - 1),
-                next(begin(lines), margin.vertical.from - 1 + n),
-                next(begin(lines), margin.vertical.to)
+            std::rotate(
+                lineAt(margin.vertical.from),
+                lineAt(margin.vertical.from + n),
+                lineAt(margin.vertical.to + 1)
             );
         }
 
-        for_each(
+        std::for_each(
             LIBTERMINAL_EXECUTION_COMMA(par)
-            next(begin(lines), margin.vertical.to - n),
-            next(begin(lines), margin.vertical.to),
+            lineAt(margin.vertical.to - n + 1),
+            lineAt(margin.vertical.to + 1),
             [&](Line& line) {
-                fill(begin(line), end(line), Cell{{}, cursor.graphicsRendition});
+                fill(begin(line), end(line), Cell{{}, blankStyle()});
+                line.wrapped = false;
             }
         );
     }
 
+    if (margin.horizontal != Margin::Range{1, size_.width})
+        touchLines(margin.vertical.from, margin.vertical.to);
+    else
+    {
+        // Whole lines scrolled up keep their identity, only the blank lines at the bottom are new.
+        auto const n = min(v_n, margin.vertical.length());
+        moveLines(margin.vertical.from, margin.vertical.to - n);
+        touchLines(margin.vertical.to - n + 1, margin.vertical.to);
+    }
     updateCursorIterators();
 }
 
@@ -445,6 +1108,9 @@ void ScreenBuffer::scrollDown(cursor_pos_t v_n)
 
 void ScreenBuffer::scrollDown(cursor_pos_t v_n, Margin const& _margin)
 {
+    if (_margin.vertical.to == size_.height)
+        discardLinesBelowPage();
+
     auto const marginHeight = _margin.vertical.length();
     auto const n = min(v_n, marginHeight);
 
@@ -453,9 +1119,9 @@ void ScreenBuffer::scrollDown(cursor_pos_t v_n, Margin const& _margin)
         // full "inside" scroll-down
         if (n < marginHeight)
         {
-            auto sourceLine = next(begin(lines), _margin.vertical.to - n - 1);
-            auto targetLine = next(begin(lines), _margin.vertical.to - 1);
-            auto const sourceEndLine = next(begin(lines), _margin.vertical.from - 1);
+            auto sourceLine = lineAt(_margin.vertical.to - n);
+            auto targetLine = lineAt(_margin.vertical.to);
+            auto const sourceEndLine = lineAt(_margin.vertical.from);
 
             while (sourceLine != sourceEndLine)
             {
@@ -474,14 +1140,14 @@ void ScreenBuffer::scrollDown(cursor_pos_t v_n, Margin const& _margin)
                 next(begin(*targetLine), _margin.horizontal.from - 1)
             );
 
-            for_each(
-                next(begin(lines), _margin.vertical.from - 1),
-                next(begin(lines), _margin.vertical.from - 1 + n),
+            std::for_each(
+                lineAt(_margin.vertical.from),
+                lineAt(_margin.vertical.from + n),
                 [_margin, this](Line& line) {
                     fill_n(
                         next(begin(line), _margin.horizontal.from - 1),
                         _margin.horizontal.length(),
-                        Cell{{}, cursor.graphicsRendition}
+                        Cell{{}, blankStyle()}
                     );
                 }
             );
@@ -489,14 +1155,14 @@ void ScreenBuffer::scrollDown(cursor_pos_t v_n, Margin const& _margin)
         else
         {
             // clear everything in margin
-            for_each(
-                next(begin(lines), _margin.vertical.from - 1),
-                next(begin(lines), _margin.vertical.to),
+            std::for_each(
+                lineAt(_margin.vertical.from),
+                lineAt(_margin.vertical.to + 1),
                 [_margin, this](Line& line) {
                     fill_n(
                         next(begin(line), _margin.horizontal.from - 1),
                         _margin.horizontal.length(),
-                        Cell{{}, cursor.graphicsRendition}
+                        Cell{{}, blankStyle()}
                     );
                 }
             );
@@ -504,55 +1170,66 @@ void ScreenBuffer::scrollDown(cursor_pos_t v_n, Margin const& _margin)
     }
     else if (_margin.vertical == Margin::Range{1, size_.height})
     {
-        rotate(
-            begin(lines),
-            next(begin(lines), marginHeight - n),
-            end(lines)
+        std::rotate(
+            lineAt(1),
+            lineAt(marginHeight - n + 1),
+            grid.end()
         );
 
-        for_each(
-            begin(lines),
-            next(begin(lines), n),
+        std::for_each(
+            lineAt(1),
+            lineAt(n + 1),
             [this](Line& line) {
                 fill(
                     begin(line),
                     end(line),
-                    Cell{{}, cursor.graphicsRendition}
+                    Cell{{}, blankStyle()}
                 );
+                line.wrapped = false;
             }
         );
     }
     else
     {
         // scroll down only inside vertical margin with full horizontal extend
-        rotate(
-            next(begin(lines), _margin.vertical.from - 1),
-            next(begin(lines), _margin.vertical.to - n),
-            next(begin(lines), _margin.vertical.to)
+        std::rotate(
+            lineAt(_margin.vertical.from),
+            lineAt(_margin.vertical.to - n + 1),
+            lineAt(_margin.vertical.to + 1)
         );
 
-        for_each(
-            next(begin(lines), _margin.vertical.from - 1),
-            next(begin(lines), _margin.vertical.from - 1 + n),
+        std::for_each(
+            lineAt(_margin.vertical.from),
+            lineAt(_margin.vertical.from + n),
             [this](Line& line) {
                 fill(
                     begin(line),
                     end(line),
-                    Cell{{}, cursor.graphicsRendition}
+                    Cell{{}, blankStyle()}
                 );
+                line.wrapped = false;
             }
         );
     }
 
+    if (_margin.horizontal != Margin::Range{1, size_.width})
+        touchLines(_margin.vertical.from, _margin.vertical.to);
+    else
+    {
+        // Whole lines scrolled down keep their identity, only the blank lines at the top are new.
+        touchLines(_margin.vertical.from, _margin.vertical.from + n - 1);
+        moveLines(_margin.vertical.from + n, _margin.vertical.to);
+    }
     updateCursorIterators();
 }
 
 void ScreenBuffer::deleteChars(cursor_pos_t _lineNo, cursor_pos_t _n)
 {
-    auto line = next(begin(lines), _lineNo - 1);
+    auto line = lineAt(_lineNo);
     auto column = next(begin(*line), realCursorPosition().column - 1);
     auto rightMargin = next(begin(*line), margin_.horizontal.to);
     auto const n = min(_n, static_cast<cursor_pos_t>(distance(column, rightMargin)));
+    touchLine(*line);
     rotate(
         column,
         next(column, n),
@@ -563,7 +1240,7 @@ void ScreenBuffer::deleteChars(cursor_pos_t _lineNo, cursor_pos_t _n)
     fill(
         prev(rightMargin, n),
         rightMargin,
-        Cell{L' ', cursor.graphicsRendition}
+        Cell{L' ', blankStyle()}
     );
 }
 
@@ -572,10 +1249,11 @@ void ScreenBuffer::insertChars(cursor_pos_t _lineNo, cursor_pos_t _n)
 {
     auto const n = min(_n, margin_.horizontal.to - cursorPosition().column + 1);
 
-    auto line = next(begin(lines), _lineNo - 1);
+    auto line = lineAt(_lineNo);
     auto column0 = next(begin(*line), realCursorPosition().column - 1);
     auto column1 = next(begin(*line), margin_.horizontal.to - n);
     auto column2 = next(begin(*line), margin_.horizontal.to);
+    touchLine(*line);
 
     rotate(
         column0,
@@ -589,7 +1267,7 @@ void ScreenBuffer::insertChars(cursor_pos_t _lineNo, cursor_pos_t _n)
     fill_n(
         columnIteratorAt(begin(*line), cursor.position.column),
         n,
-        Cell{L' ', cursor.graphicsRendition}
+        Cell{L' ', blankStyle()}
     );
 }
 
@@ -620,11 +1298,232 @@ bool ScreenBuffer::incrementCursorColumn(cursor_pos_t _n)
 
 void ScreenBuffer::clampSavedLines()
 {
-    if (maxHistoryLineCount_.has_value())
-        while (savedLines.size() > maxHistoryLineCount_.value())
-            savedLines.pop_front();
+    if (maxHistoryLineCount_.has_value() && static_cast<size_t>(historyLineCount()) > maxHistoryLineCount_.value())
+    {
+        // The oldest lines are the spilled ones.
+        auto excess = static_cast<size_t>(historyLineCount()) - maxHistoryLineCount_.value();
+        auto const spilledExcess = min(excess, spilledLineCount());
+        dropSpilledLines(spilledExcess);
+        excess -= spilledExcess;
+
+        if (excess != 0)
+        {
+            invalidateDecodedLines();
+            grid.pop_front(excess);
+            dropUnreflowedLines(excess);
+            updateCursorIterators();
+        }
+    }
+}
+
+void ScreenBuffer::clearHistory()
+{
+    invalidateDecodedLines();
+    grid.pop_front(static_cast<size_t>(std::distance(grid.begin(), lineAt(1))));
+    spilledPages_.clear();
+    spillFile_.clear();
+    spilledLinesDropped_ = 0;
+    unreflowedHistoryLines_ = 0;
+    for (PagedInPage& page : pagedIn_)
+        page = PagedInPage{};
+    updateCursorIterators();
 }
 
+// {{{ history paging
+namespace
+{
+    /// Fixed-size part of a history line spilled to disk, followed by its text and spans.
+    ///
+    /// Styles are stored as indices into the styles of the page (SpilledPage::styles).
+    struct SpilledLineHeader {
+        uint32_t fillStyle;
+        uint32_t columns;
+        uint32_t textSize;
+        uint32_t spanCount;
+        HyperlinkId fillHyperlink;
+    };
+
+    struct SpilledSpan {
+        uint32_t style;
+        HyperlinkId hyperlink;
+        uint32_t length;
+    };
+
+    static_assert(std::is_trivially_copyable_v<SpilledLineHeader>);
+    static_assert(std::is_trivially_copyable_v<SpilledSpan>);
+
+    uint32_t styleIndex(std::vector<CellStyle const*> const& _styles, CellStyle const* _style)
+    {
+        auto const i = lower_bound(_styles.begin(), _styles.end(), _style);
+        assert(i != _styles.end() && *i == _style);
+        return static_cast<uint32_t>(std::distance(_styles.begin(), i));
+    }
+
+    void serialize(CompressedLine const& _line, std::vector<CellStyle const*> const& _styles, std::string& _output)
+    {
+        auto const header = SpilledLineHeader{
+            styleIndex(_styles, _line.fillStyle),
+            static_cast<uint32_t>(_line.columns),
+            static_cast<uint32_t>(_line.text.size()),
+            static_cast<uint32_t>(_line.spans.size()),
+            _line.fillHyperlink
+        };
+        _output.append(reinterpret_cast<char const*>(&header), sizeof(header));
+        _output.append(_line.text);
+        for (CompressedLine::Span const& span : _line.spans)
+        {
+            auto const spilled = SpilledSpan{styleIndex(_styles, span.style), span.hyperlink, span.length};
+            _output.append(reinterpret_cast<char const*>(&spilled), sizeof(spilled));
+        }
+    }
+
+    /// Deserializes the line at the front of @p _input, advancing it to the next line.
+    CompressedLine deserialize(std::string_view& _input, std::vector<CellStyle const*> const& _styles)
+    {
+        // The file is not necessarily aligned for the header and spans, hence the copying.
+        auto header = SpilledLineHeader{};
+        memcpy(&header, _input.data(), sizeof(header));
+        _input.remove_prefix(sizeof(header));
+
+        auto line = CompressedLine{};
+        line.fillStyle = _styles[header.fillStyle];
+        line.fillHyperlink = header.fillHyperlink;
+        line.columns = header.columns;
+
+        line.text.assign(_input.data(), header.textSize);
+        _input.remove_prefix(header.textSize);
+
+        line.spans.resize(header.spanCount);
+        for (CompressedLine::Span& span : line.spans)
+        {
+            auto spilled = SpilledSpan{};
+            memcpy(&spilled, _input.data(), sizeof(spilled));
+            _input.remove_prefix(sizeof(spilled));
+            span = CompressedLine::Span{_styles[spilled.style], spilled.hyperlink, spilled.length};
+        }
+
+        return line;
+    }
+}
+
+void ScreenBuffer::setMaxHistoryPagesInMemory(std::optional<size_t> _count)
+{
+    maxHistoryPagesInMemory_ = _count;
+    spillHistory();
+}
+
+void ScreenBuffer::spillHistory()
+{
+    if (!maxHistoryPagesInMemory_.has_value())
+        return;
+
+    // Spilling whole pages only once a page beyond the budget is complete
+    // keeps at least the budget's worth of history in memory.
+    auto const threshold = (maxHistoryPagesInMemory_.value() + 1) * HistoryPageLineCount;
+    if (static_cast<size_t>(inMemoryHistoryLineCount()) < threshold)
+        return;
+
+    auto bytes = std::string{};
+    while (static_cast<size_t>(inMemoryHistoryLineCount()) >= threshold)
+    {
+        auto page = SpilledPage{nextSpilledPageSerial_++, {}, {}, {}};
+        page.marks.reserve(HistoryPageLineCount);
+        bytes.clear();
+
+        for (size_t i = 0; i < HistoryPageLineCount; ++i)
+        {
+            Line& line = grid[i];
+            if (!line.compressed())
+                line.compress();
+
+            page.marks.push_back(line.marked);
+            page.styles.push_back(line.packed.fillStyle);
+            page.hyperlinks.push_back(line.packed.fillHyperlink);
+            for (CompressedLine::Span const& span : line.packed.spans)
+            {
+                page.styles.push_back(span.style);
+                page.hyperlinks.push_back(span.hyperlink);
+            }
+        }
+
+        sort(page.styles.begin(), page.styles.end());
+        page.styles.erase(unique(page.styles.begin(), page.styles.end()), page.styles.end());
+        sort(page.hyperlinks.begin(), page.hyperlinks.end());
+        page.hyperlinks.erase(unique(page.hyperlinks.begin(), page.hyperlinks.end()), page.hyperlinks.end());
+
+        for (size_t i = 0; i < HistoryPageLineCount; ++i)
+            serialize(grid[i].packed, page.styles, bytes);
+
+        spillFile_.push_back(bytes);
+        spilledPages_.emplace_back(std::move(page));
+        grid.pop_front(HistoryPageLineCount);
+        dropUnreflowedLines(HistoryPageLineCount);
+    }
+
+    invalidateDecodedLines();
+    updateCursorIterators();
+}
+
+void ScreenBuffer::dropSpilledLines(size_t _count)
+{
+    assert(_count <= spilledLineCount());
+
+    spilledLinesDropped_ += _count;
+    while (!spilledPages_.empty() && spilledLinesDropped_ >= HistoryPageLineCount)
+    {
+        spilledPages_.pop_front();
+        spillFile_.pop_front();
+        spilledLinesDropped_ -= HistoryPageLineCount;
+    }
+
+    if (spilledPages_.empty())
+        spilledLinesDropped_ = 0;
+}
+
+std::vector<ScreenBuffer::Line> const& ScreenBuffer::pageIn(size_t _page) const
+{
+    SpilledPage const& spilled = spilledPages_[_page];
+
+    for (PagedInPage const& page : pagedIn_)
+        if (page.serial == spilled.serial)
+            return page.lines;
+
+    PagedInPage& page = pagedIn_[nextPagedIn_];
+    nextPagedIn_ = (nextPagedIn_ + 1) % pagedIn_.size();
+
+    // The lines being replaced may still be referenced by the decoded lines cache.
+    invalidateDecodedLines();
+
+    page.serial = spilled.serial;
+    page.lines.clear();
+    page.lines.reserve(HistoryPageLineCount);
+
+    auto bytes = spillFile_[_page];
+    for (size_t i = 0; i < HistoryPageLineCount; ++i)
+        page.lines.emplace_back(deserialize(bytes, spilled.styles), spilled.marks[i]);
+
+    return page.lines;
+}
+
+ScreenBuffer::Line const& ScreenBuffer::readLine(cursor_pos_t _row) const
+{
+    if (_row > -inMemoryHistoryLineCount())
+        return *lineAt(_row);
+
+    auto const index = static_cast<size_t>(_row - 1 + historyLineCount()) + spilledLinesDropped_;
+    return pageIn(index / HistoryPageLineCount)[index % HistoryPageLineCount];
+}
+
+bool ScreenBuffer::isLineMarked(cursor_pos_t _row) const noexcept
+{
+    if (_row > -inMemoryHistoryLineCount())
+        return lineAt(_row)->marked;
+
+    auto const index = static_cast<size_t>(_row - 1 + historyLineCount()) + spilledLinesDropped_;
+    return spilledPages_[index / HistoryPageLineCount].marks[index % HistoryPageLineCount];
+}
+// }}}
+
 void ScreenBuffer::clearAllTabs()
 {
     tabs.clear();
@@ -663,8 +1562,8 @@ void ScreenBuffer::verifyState() const
         ));
     }
 
-    if (static_cast<size_t>(size_.height) != lines.size())
-        fail(fmt::format("Line count mismatch. Actual line count {} but should be {}.", lines.size(), size_.height));
+    if (historyLineCount() < 0)
+        fail(fmt::format("Line count mismatch. Actual line count {} but should be at least {}.", grid.size(), size_.height));
 
     // verify cursor positions
     [[maybe_unused]] auto const clampedCursorPos = clampToScreen(cursor.position);
@@ -673,7 +1572,7 @@ void ScreenBuffer::verifyState() const
     // FIXME: the above triggers on tmux vertical screen split (cursor.column off-by-one)
 
     // verify iterators
-    [[maybe_unused]] auto const line = next(begin(lines), cursor.position.row - 1);
+    [[maybe_unused]] auto const line = lineAt(cursor.position.row);
     [[maybe_unused]] auto const col = columnIteratorAt(cursor.position.column);
 
     if (line != currentLine)
@@ -757,32 +1656,109 @@ std::string ScreenBuffer::screenshot() const
     auto result = std::stringstream{};
     auto generator = OutputGenerator{ result };
 
+    auto const setGraphicsRendition = [&](GraphicsAttributes const& _attributes) {
+        static constexpr auto renditions = std::array{
+            std::pair{CharacterStyleMask::Bold, GraphicsRendition::Bold},
+            std::pair{CharacterStyleMask::Faint, GraphicsRendition::Faint},
+            std::pair{CharacterStyleMask::Italic, GraphicsRendition::Italic},
+            std::pair{CharacterStyleMask::Underline, GraphicsRendition::Underline},
+            std::pair{CharacterStyleMask::Blinking, GraphicsRendition::Blinking},
+            std::pair{CharacterStyleMask::Inverse, GraphicsRendition::Inverse},
+            std::pair{CharacterStyleMask::Hidden, GraphicsRendition::Hidden},
+            std::pair{CharacterStyleMask::CrossedOut, GraphicsRendition::CrossedOut},
+            std::pair{CharacterStyleMask::DoublyUnderlined, GraphicsRendition::DoublyUnderlined},
+            std::pair{CharacterStyleMask::CurlyUnderlined, GraphicsRendition::CurlyUnderlined},
+            std::pair{CharacterStyleMask::DottedUnderline, GraphicsRendition::DottedUnderline},
+            std::pair{CharacterStyleMask::DashedUnderline, GraphicsRendition::DashedUnderline},
+            std::pair{CharacterStyleMask::Framed, GraphicsRendition::Framed},
+            std::pair{CharacterStyleMask::Overline, GraphicsRendition::Overline},
+        };
+
+        generator(SetGraphicsRendition{GraphicsRendition::Reset});
+        for (auto const& [mask, rendition] : renditions)
+            if (_attributes.styles & mask)
+                generator(SetGraphicsRendition{rendition});
+        if (!std::holds_alternative<DefaultColor>(_attributes.foregroundColor))
+            generator(SetForegroundColor{ _attributes.foregroundColor });
+        if (!std::holds_alternative<DefaultColor>(_attributes.backgroundColor))
+            generator(SetBackgroundColor{ _attributes.backgroundColor });
+        if (!std::holds_alternative<DefaultColor>(_attributes.underlineColor))
+            generator(SetUnderlineColor{ _attributes.underlineColor });
+    };
+
+    if (type_ == Type::Alternate)
+        generator(SetMode{ Mode::UseAlternateScreen, true });
+    generator(SetGraphicsRendition{GraphicsRendition::Reset});
+    generator(ClearScreen{});
+    generator(MoveCursorTo{ 1, 1 });
+
+    auto current = GraphicsAttributes{};
     for (cursor_pos_t const row : crispy::times(1, size_.height))
     {
-        for (cursor_pos_t const col : crispy::times(1, size_.width))
+        for (cursor_pos_t col = 1; col <= size_.width; )
         {
             Cell const& cell = at({row, col});
 
-            //TODO: some kind of: generator(SetGraphicsRendition{ cell.attributes().styles });
-            if (cell.attributes().styles & CharacterStyleMask::Bold)
-                generator(SetGraphicsRendition{GraphicsRendition::Bold});
-            else
-                generator(SetGraphicsRendition{GraphicsRendition::Normal});
-
-            generator(SetForegroundColor{ cell.attributes().foregroundColor });
-            generator(SetBackgroundColor{ cell.attributes().backgroundColor });
+            if (cell.attributes() != current)
+            {
+                current = cell.attributes();
+                setGraphicsRendition(current);
+            }
 
             if (!cell.codepointCount())
                 generator(AppendChar{ U' ' });
             else
                 for (char32_t const ch : cell.codepoints())
                     generator(AppendChar{ ch });
+
+            // The columns covered by a wide character are filled by writing it.
+            col += max(cell.width(), 1);
+        }
+
+        // No line feed after the last row, which would scroll the page up.
+        if (row != size_.height)
+        {
+            generator(MoveCursorToBeginOfLine{});
+            generator(Linefeed{});
         }
-        generator(SetGraphicsRendition{GraphicsRendition::Reset});
-        generator(MoveCursorToBeginOfLine{});
-        generator(Linefeed{});
     }
 
+    // Margins and modes move the cursor home, so they come before restoring its position.
+    if (margin_.vertical != Margin::Range{1, size_.height})
+        generator(SetTopBottomMargin{ margin_.vertical.from, margin_.vertical.to });
+    if (isModeEnabled(Mode::LeftRightMargin))
+    {
+        generator(SetMode{ Mode::LeftRightMargin, true });
+        if (margin_.horizontal != Margin::Range{1, size_.width})
+            generator(SetLeftRightMargin{ margin_.horizontal.from, margin_.horizontal.to });
+    }
+
+    // Only modes differing from those of a new screen, where merely AutoWrap is enabled.
+    for (auto const mode : { Mode::Insert,
+                             Mode::AutomaticNewLine,
+                             Mode::UseApplicationCursorKeys,
+                             Mode::ReverseVideo,
+                             Mode::Origin,
+                             Mode::AutoWrap,
+                             Mode::BlinkingCursor,
+                             Mode::BracketedPaste,
+                             Mode::FocusTracking,
+                             Mode::MouseExtended,
+                             Mode::MouseSGR,
+                             Mode::MouseURXVT,
+                             Mode::MouseAlternateScroll })
+    {
+        if (isModeEnabled(mode) != (mode == Mode::AutoWrap))
+            generator(SetMode{ mode, isModeEnabled(mode) });
+    }
+    if (!cursor.visible)
+        generator(SetMode{ Mode::VisibleCursor, false });
+
+    auto const position = cursorPosition();
+    generator(MoveCursorTo{ position.row, position.column });
+    setGraphicsRendition(cursor.graphicsRendition);
+    generator.flush();
+
     return result.str();
 }
 
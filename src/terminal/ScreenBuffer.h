@@ -18,15 +18,21 @@
 #include <terminal/Commands.h>              // Coordinate, cursor_pos_t, Mode
 #include <terminal/Hyperlink.h>
 #include <terminal/Logger.h>
+#include <terminal/PageFile.h>
 #include <terminal/Size.h>
 
 #include <unicode/width.h>
 
+#include <crispy/range.h>
+#include <crispy/ring.h>
+#include <crispy/span.h>
 #include <crispy/times.h>
 
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <array>
+#include <cassert>
 #include <deque>
 #include <functional>
 #include <optional>
@@ -35,6 +41,7 @@
 #include <stack>
 #include <string>
 #include <string_view>
+#include <unordered_set>
 #include <vector>
 
 using std::pair;
@@ -187,6 +194,19 @@ struct GraphicsAttributes {
     }
 };
 
+constexpr bool operator==(GraphicsAttributes const& a, GraphicsAttributes const& b) noexcept
+{
+    return a.backgroundColor == b.backgroundColor
+        && a.foregroundColor == b.foregroundColor
+        && a.styles == b.styles
+        && a.underlineColor == b.underlineColor;
+}
+
+constexpr bool operator!=(GraphicsAttributes const& a, GraphicsAttributes const& b) noexcept
+{
+    return !(a == b);
+}
+
 /// Terminal cursor data structure.
 ///
 /// NB: Take care what to store here, as DECSC/DECRC will save/restore this struct.
@@ -203,41 +223,92 @@ struct Cursor
     // TODO: CharacterSet for GL and GR
 };
 
+/// Everything about a cell's appearance except for its first codepoint.
+///
+/// Cell styles are interned per ScreenBuffer (see CellStyleTable), so that all cells
+/// looking alike share a single instance, keeping the Cell itself small.
+struct CellStyle {
+    /// Graphics renditions, such as foreground/background color or other grpahics attributes.
+    GraphicsAttributes attributes{};
+
+    /// All codepoints of a grapheme cluster spanning more than one codepoint, empty otherwise.
+    std::u32string cluster{};
+
+    /// Garbage collection mark, not part of the style's identity.
+    mutable bool marked = false;
+};
+
+/// The style of all cells that have not been written to.
+inline CellStyle const DefaultCellStyle{};
+
+bool operator==(CellStyle const& a, CellStyle const& b) noexcept;
+
+struct CellStyleHash {
+    size_t operator()(CellStyle const& _style) const noexcept;
+};
+
+/// Interning table of all cell styles in use by a ScreenBuffer.
+///
+/// Interned styles keep their address for as long as they are in the table.
+class CellStyleTable {
+  public:
+    CellStyleTable() = default;
+    CellStyleTable(CellStyleTable const&) = delete;
+    CellStyleTable(CellStyleTable&&) = default;
+    CellStyleTable& operator=(CellStyleTable const&) = delete;
+    CellStyleTable& operator=(CellStyleTable&&) = default;
+
+    /// @returns the interned instance equal to @p _style, inserting it if not present yet.
+    CellStyle const& intern(CellStyle const& _style);
+
+    /// Removes all styles that have not been marked, and clears the marks of the others.
+    void sweep();
+
+    size_t size() const noexcept { return styles_.size(); }
+
+  private:
+    std::unordered_set<CellStyle, CellStyleHash> styles_;
+};
+
 /// Grid cell with character and graphics rendition information.
 class Cell {
   public:
     static size_t constexpr MaxCodepoints = 9;
 
-    Cell(char32_t _ch, GraphicsAttributes _attrib) noexcept :
-        codepoints_{},
-        attributes_{std::move(_attrib)},
-        width_{1},
-        codepointCount_{0}
+    /// Constructs a cell from its first codepoint, with all further codepoints of a
+    /// grapheme cluster (if any) taken from @p _style.
+    Cell(char32_t _ch, CellStyle const& _style, HyperlinkId _hyperlink = 0) noexcept :
+        hyperlink_{_hyperlink},
+        style_{&_style}
     {
         setCharacter(_ch);
+        if (!_style.cluster.empty())
+            codepointCount_ = static_cast<uint8_t>(_style.cluster.size());
     }
 
     constexpr Cell() noexcept :
-        codepoints_{},
-        attributes_{},
+        codepoint_{0},
         width_{1},
-        codepointCount_{0}
+        codepointCount_{0},
+        hyperlink_{0},
+        style_{&DefaultCellStyle}
     {}
 
     void reset() noexcept
     {
-        attributes_ = {};
         codepointCount_ = 0;
         width_ = 1;
-        hyperlink_ = nullptr;
+        hyperlink_ = 0;
+        style_ = &DefaultCellStyle;
     }
 
-    void reset(GraphicsAttributes _attribs, HyperlinkRef const& _hyperlink) noexcept
+    /// Clears the cell, using given style, which must not contain a grapheme cluster.
+    void reset(CellStyle const& _style, HyperlinkId _hyperlink = 0) noexcept
     {
-        attributes_ = std::move(_attribs);
         codepointCount_ = 0;
         width_ = 1;
         hyperlink_ = _hyperlink;
+        style_ = &_style;
     }
 
     Cell(Cell const&) noexcept = default;
@@ -245,46 +316,62 @@ class Cell {
     Cell& operator=(Cell const&) noexcept = default;
     Cell& operator=(Cell&&) noexcept = default;
 
-    constexpr std::u32string_view codepoints() const noexcept
+    std::u32string_view codepoints() const noexcept
+    {
+        if (codepointCount_ <= 1)
+            return std::u32string_view{&codepoint_, codepointCount_};
+        else
+            return style_->cluster;
+    }
+
+    char32_t codepoint(size_t i) const noexcept
     {
-        return std::u32string_view{codepoints_.data(), codepointCount_};
+        if (i == 0)
+            return codepoint_;
+        else if (i < codepointCount_)
+            return style_->cluster[i];
+        else
+            return 0;
     }
 
-    constexpr char32_t codepoint(size_t i) const noexcept { return codepoints_[i]; }
     constexpr int codepointCount() const noexcept { return codepointCount_; }
 
     constexpr bool empty() const noexcept { return codepointCount_ == 0; }
 
     constexpr int width() const noexcept { return width_; }
 
-    constexpr GraphicsAttributes const& attributes() const noexcept { return attributes_; }
-    constexpr GraphicsAttributes& attributes() noexcept { return attributes_; }
+    CellStyle const& style() const noexcept { return *style_; }
+    GraphicsAttributes const& attributes() const noexcept { return style_->attributes; }
 
-    void setCharacter(char32_t _codepoint) noexcept
+    /// Sets the cell's only codepoint and style, which must not contain a grapheme cluster.
+    void setCharacter(char32_t _codepoint, CellStyle const& _style, HyperlinkId _hyperlink = 0) noexcept
     {
-        codepoints_[0] = _codepoint;
-        if (_codepoint)
-        {
-            codepointCount_ = 1;
-            width_ = std::max(unicode::width(_codepoint), 1);
-        }
-        else
-        {
-            codepointCount_ = 0;
-            width_ = 1;
-        }
+        hyperlink_ = _hyperlink;
+        style_ = &_style;
+        setCharacter(_codepoint);
+    }
+
+    /// Replaces the cell's style with an equal one, such as a copy owned elsewhere.
+    void setStyle(CellStyle const& _style) noexcept
+    {
+        style_ = &_style;
     }
 
     void setWidth(int _width) noexcept
     {
-        width_ = _width;
+        width_ = static_cast<uint8_t>(_width);
     }
 
-    int appendCharacter(char32_t _codepoint) noexcept
+    /// Appends a codepoint to the grapheme cluster of this cell.
+    ///
+    /// @param _styles the table to intern the cell's resulting style in.
+    int appendCharacter(char32_t _codepoint, CellStyleTable& _styles)
     {
         if (codepointCount_ < MaxCodepoints)
         {
-            codepoints_[codepointCount_] = _codepoint;
+            auto style = CellStyle{style_->attributes, std::u32string(codepoints())};
+            style.cluster.push_back(_codepoint);
+            style_ = &_styles.intern(style);
             codepointCount_++;
 
             constexpr bool AllowWidthChange = false; // TODO: make configurable
@@ -304,7 +391,7 @@ class Cell {
             if (width != width_ && AllowWidthChange)
             {
                 int const diff = width - width_;
-                width_ = width;
+                width_ = static_cast<uint8_t>(width);
                 return diff;
             }
         }
@@ -313,15 +400,29 @@ class Cell {
 
     std::string toUtf8() const;
 
-    HyperlinkRef hyperlink() const noexcept { return hyperlink_; }
-    void setHyperlink(HyperlinkRef const& _hyperlink) { hyperlink_ = _hyperlink; }
+    /// @returns the id of the hyperlink in the screen buffer's HyperlinkStorage, 0 if none.
+    constexpr HyperlinkId hyperlink() const noexcept { return hyperlink_; }
+    void setHyperlink(HyperlinkId _hyperlink) noexcept { hyperlink_ = _hyperlink; }
 
   private:
-    /// Unicode codepoint to be displayed.
-    std::array<char32_t, MaxCodepoints> codepoints_;
+    void setCharacter(char32_t _codepoint) noexcept
+    {
+        codepoint_ = _codepoint;
+        if (_codepoint)
+        {
+            codepointCount_ = 1;
+            width_ = static_cast<uint8_t>(std::max(unicode::width(_codepoint), 1));
+        }
+        else
+        {
+            codepointCount_ = 0;
+            width_ = 1;
+        }
+    }
 
-    /// Graphics renditions, such as foreground/background color or other grpahics attributes.
-    GraphicsAttributes attributes_;
+  private:
+    /// First (usually only) Unicode codepoint to be displayed.
+    char32_t codepoint_;
 
     /// number of cells this cell spans. Usually this is 1, but it may be also 0 or >= 2.
     uint8_t width_;
@@ -329,7 +430,43 @@ class Cell {
     /// Number of combined codepoints stored in this cell.
     uint8_t codepointCount_;
 
-    HyperlinkRef hyperlink_ = nullptr;
+    /// Hyperlink id within the HyperlinkStorage of the ScreenBuffer this cell belongs to, or 0.
+    HyperlinkId hyperlink_;
+
+    /// Interned style, owned by the CellStyleTable of the ScreenBuffer this cell belongs to.
+    CellStyle const* style_;
+};
+
+static_assert(sizeof(Cell) <= 16, "Cells must be kept small, as there are lots of them.");
+
+/// Compact encoding of the cells of a line, as used for lines in the history.
+///
+/// A cell is fully described by its first codepoint, its style and its hyperlink,
+/// as its width follows from the former and further codepoints are part of the style.
+/// Consecutive cells of equal style and hyperlink are stored as a single span,
+/// and trailing empty cells of equal style and hyperlink are not stored at all.
+struct CompressedLine {
+    struct Span {
+        CellStyle const* style;
+        HyperlinkId hyperlink;
+        uint32_t length;                    // number of cells
+    };
+
+    std::string text;                       // first codepoint of each stored cell, UTF-8 encoded, NUL if empty
+    std::vector<Span> spans;                // styles of the stored cells
+    CellStyle const* fillStyle = &DefaultCellStyle;  // style of the trailing empty cells
+    HyperlinkId fillHyperlink = 0;          // hyperlink of the trailing empty cells
+    size_t columns = 0;                     // total number of cells
+
+    void clear() noexcept
+    {
+        // Keeps the capacity, as compressing is usually followed by compressing another line.
+        text.clear();
+        spans.clear();
+        fillStyle = &DefaultCellStyle;
+        fillHyperlink = 0;
+        columns = 0;
+    }
 };
 
 /**
@@ -347,12 +484,28 @@ struct ScreenBuffer {
         LineBuffer buffer;
         bool marked = false;
 
+        /// Whether this line continues the previous one, the cursor having wrapped around
+        /// at the right margin, rather than starting a new logical line.
+        bool wrapped = false;
+
+        /// Generation of the screen buffer at the last modification of this line, if on the main page.
+        uint64_t generation = 0;
+
+        /// Identity of the line's contents, renewed by every modification but kept while the line
+        /// is merely moved, such as by scrolling. Unique within the screen buffer, 0 for none.
+        uint64_t id = 0;
+
         using iterator = LineBuffer::iterator;
         using const_iterator = LineBuffer::const_iterator;
         using reverse_iterator = LineBuffer::reverse_iterator;
         using size_type = LineBuffer::size_type;
 
+        /// Cells of this line in compact form if compressed(), otherwise unused but retaining
+        /// the storage of the last compression.
+        CompressedLine packed;
+
         Line(size_t _numCols, Cell const& _defaultCell) : buffer{_numCols, _defaultCell} {}
+        Line(CompressedLine _packed, bool _marked) : marked{_marked}, packed{std::move(_packed)}, compressed_{true} {}
         Line() = default;
         Line(Line const&) = default;
         Line(Line&&) = default;
@@ -363,8 +516,29 @@ struct ScreenBuffer {
         LineBuffer const* operator->()  const noexcept { return &buffer; }
         auto& operator[](std::size_t _index) { return buffer[_index]; }
         auto const& operator[](std::size_t _index) const { return buffer[_index]; }
-        auto size() const noexcept { return buffer.size(); }
-        void resize(size_type _size) { buffer.resize(_size); }
+        auto size() const noexcept { return compressed_ ? packed.columns : buffer.size(); }
+        void resize(size_type _size) { assert(!compressed_); buffer.resize(_size); }
+
+        /// Whether the cells are stored in compact form in packed rather than in buffer.
+        ///
+        /// The cells of a compressed line must not be accessed directly, but through
+        /// decode() or ScreenBuffer::cellsOf().
+        bool compressed() const noexcept { return compressed_; }
+
+        /// Encodes the cells into packed and releases their storage.
+        ///
+        /// @returns the released cell storage, for reuse by another line.
+        LineBuffer compress();
+
+        /// Decodes a compressed line back into buffer.
+        void inflate();
+
+        /// Writes the line's cells into @p _output, padded to at least @p _columns cells.
+        void decode(LineBuffer& _output, size_t _columns) const;
+
+        /// Makes this an uncompressed line of @p _columns copies of @p _fill,
+        /// using @p _storage for the cells.
+        void reset(LineBuffer&& _storage, size_t _columns, Cell const& _fill);
 
         iterator begin() { return buffer.begin(); }
         iterator end() { return buffer.end(); }
@@ -372,11 +546,19 @@ struct ScreenBuffer {
         reverse_iterator rend() { return buffer.rend(); }
         const_iterator cbegin() const { return buffer.cbegin(); }
         const_iterator cend() const { return buffer.cend(); }
+
+      private:
+        bool compressed_ = false;
     };
     using ColumnIterator = Line::iterator;
 
-	using Lines = std::deque<Line>;
+    /// All lines of a screen buffer, the history (oldest first) followed by the main page.
+    ///
+    /// Scrolling with a full history rotates the oldest history line to the bottom of the
+    /// main page, reusing its storage rather than allocating a new line.
+	using Lines = crispy::ring<Line>;
     using LineIterator = Lines::iterator;
+    using ConstLineIterator = Lines::const_iterator;
 
     using Renderer = std::function<void(Coordinate const&, Cell const&)>;
 
@@ -389,21 +571,146 @@ struct ScreenBuffer {
 			  {1, _size.height},
 			  {1, _size.width}
 		  },
-		  lines{ static_cast<size_t>(_size.height), Line{static_cast<size_t>(_size.width), Cell{}} }
+		  grid{ static_cast<size_t>(_size.height), Line{static_cast<size_t>(_size.width), Cell{}} }
 	{
 		verifyState();
 	}
 
     void reset()
     {
+        auto const maxHistoryPagesInMemory = maxHistoryPagesInMemory_;
+        auto const generation = generation_;
+        auto const lastLineId = lastLineId_;
         *this = ScreenBuffer(type_, size_, modes_.get(), maxHistoryLineCount_);
+        maxHistoryPagesInMemory_ = maxHistoryPagesInMemory;
+        lastLineId_ = lastLineId;
+        touchAll(generation);
+    }
+
+    /// @returns the current generation, advanced by every modification of the main page.
+    uint64_t generation() const noexcept { return generation_; }
+
+    /// Marks the given line of the main page as modified.
+    void touchLine(Line& _line) noexcept
+    {
+        _line.generation = ++generation_;
+        _line.id = ++lastLineId_;
+    }
+
+    /// Marks the lines @p _from to @p _to (inclusive) of the main page as modified.
+    void touchLines(cursor_pos_t _from, cursor_pos_t _to) noexcept
+    {
+        auto const generation = ++generation_;
+        std::for_each(lineAt(_from), lineAt(_to + 1), [&](Line& _line) {
+            _line.generation = generation;
+            _line.id = ++lastLineId_;
+        });
     }
 
+    /// Marks the lines @p _from to @p _to (inclusive) of the main page as moved, their contents unchanged.
+    void moveLines(cursor_pos_t _from, cursor_pos_t _to) noexcept
+    {
+        auto const generation = ++generation_;
+        std::for_each(lineAt(_from), lineAt(_to + 1), [=](Line& _line) { _line.generation = generation; });
+    }
+
+    /// Marks all lines of the main page as modified, in a generation beyond @p _minGeneration.
+    ///
+    /// Passing the generation of another buffer keeps generations increasing when switching buffers.
+    void touchAll(uint64_t _minGeneration = 0) noexcept
+    {
+        generation_ = std::max(generation_, _minGeneration);
+        touchLines(1, size_.height);
+    }
+
+    /// Invokes @p _callback with the row of each line of the main page modified after @p _generation.
+    template <typename F>
+    void forEachChangedLine(uint64_t _generation, F const& _callback) const
+    {
+        cursor_pos_t row = 1;
+        for (auto line = lineAt(1); line != grid.cend(); ++line, ++row)
+            if (line->generation > _generation)
+                _callback(row);
+    }
+
+    /// @returns the number of all history lines, including those spilled to disk.
     int historyLineCount() const noexcept
     {
-        return static_cast<int>(savedLines.size());
+        return static_cast<int>(spilledLineCount()) + inMemoryHistoryLineCount();
+    }
+
+    /// @returns the number of history lines in grid.
+    int inMemoryHistoryLineCount() const noexcept
+    {
+        return static_cast<int>(grid.size()) - size_.height;
+    }
+
+    /// @returns an iterator to the given line in grid, 1 being the top line of the main page,
+    ///          and 0 down to (1 - inMemoryHistoryLineCount()) addressing the history, newest first.
+    LineIterator lineAt(cursor_pos_t _row) noexcept
+    {
+        return std::next(grid.begin(), inMemoryHistoryLineCount() + _row - 1);
+    }
+
+    ConstLineIterator lineAt(cursor_pos_t _row) const noexcept
+    {
+        return std::next(grid.cbegin(), inMemoryHistoryLineCount() + _row - 1);
+    }
+
+    /// @returns the identity (see Line::id) of the given line, 0 for history lines spilled to disk.
+    uint64_t lineId(cursor_pos_t _row) const noexcept
+    {
+        return _row > -inMemoryHistoryLineCount() ? lineAt(_row)->id : 0;
+    }
+
+    /// @returns the given line, like lineAt(), but down to (1 - historyLineCount()),
+    ///          paging in history lines spilled to disk.
+    ///
+    /// Lines paged in are valid until the grid is modified or more pages are paged in.
+    Line const& readLine(cursor_pos_t _row) const;
+
+    /// @returns whether the given line (1 - historyLineCount() up to the page height) is marked,
+    ///          without paging in any history.
+    bool isLineMarked(cursor_pos_t _row) const noexcept;
+
+    /// @returns the lines of the main page.
+    auto mainPage() noexcept { return crispy::range(lineAt(1), grid.end()); }
+    auto mainPage() const noexcept { return crispy::range(lineAt(1), grid.cend()); }
+
+    /// @returns the history lines in grid, oldest first.
+    auto savedLines() const noexcept { return crispy::range(grid.cbegin(), lineAt(1)); }
+
+    /// Erases all history lines.
+    void clearHistory();
+
+    /// Discards the lines kept below the page since the page has been re-wrapped, if any.
+    void discardLinesBelowPage() noexcept { linesBelowPage_.clear(); }
+
+    /// Number of history lines per page, the unit of spilling history to disk.
+    static constexpr size_t HistoryPageLineCount = 256;
+
+    /// Sets the number of pages of history to keep in memory, with older history being spilled to disk,
+    /// or nullopt for keeping all history in memory.
+    void setMaxHistoryPagesInMemory(std::optional<size_t> _count);
+
+    /// @returns the number of history lines spilled to disk.
+    size_t spilledLineCount() const noexcept
+    {
+        return spilledPages_.size() * HistoryPageLineCount - spilledLinesDropped_;
     }
 
+    /// Spills the oldest history lines in grid to disk, as far as they exceed the in-memory page budget.
+    void spillHistory();
+
+    /// Re-wraps the newest @p _lineCount history lines in grid to the page width, unless done already.
+    ///
+    /// Resizing the width only re-wraps the main page right away. The history follows lazily,
+    /// newest first, as it gets viewed or searched. Lines spilled to disk are never re-wrapped.
+    void reflowHistory(int _lineCount);
+
+    /// @returns the number of the oldest history lines in grid not re-wrapped to the page width yet.
+    size_t unreflowedHistoryLineCount() const noexcept { return unreflowedHistoryLines_; }
+
     /// Finds the previous marker right next to the given line position.
     ///
     /// @paramn _currentCursorLine the line number of the current cursor (1..N) for screen area, or
@@ -418,25 +725,149 @@ struct ScreenBuffer {
 	Size size_;
     std::reference_wrapper<Modes> modes_;
     std::optional<size_t> maxHistoryLineCount_;
+    std::optional<size_t> maxHistoryPagesInMemory_;
+    uint64_t generation_ = 0;
+    uint64_t lastLineId_ = 0;
 	Margin margin_;
 	Cursor cursor{};
-	Lines lines;
-	Lines savedLines{};
+	Lines grid;
 	bool wrapPending{false};
 	int tabWidth{8};
     std::vector<cursor_pos_t> tabs;
 
-	LineIterator currentLine{std::begin(lines)};
+	LineIterator currentLine{lineAt(1)};
 	ColumnIterator currentColumn{currentLine->begin()};
 
     ColumnIterator lastColumn{currentColumn};
     Coordinate lastCursorPosition{};
 
-    HyperlinkRef currentHyperlink = {};
-    // TODO: use a deque<> instead, always push_back, lookup reverse, evict in front.
-    std::unordered_map<std::string, HyperlinkRef> hyperlinks;
+    /// Hyperlink to be assigned to newly written text, 0 if none.
+    HyperlinkId currentHyperlink = 0;
+
+    /// Hyperlinks referred to by cells in grid.
+    HyperlinkStorage hyperlinks{};
+
+    /// Registers a hyperlink, evicting unused hyperlinks first if the storage is full.
+    ///
+    /// The storage grows whenever a collection frees less than a quarter of it.
+    ///
+    /// @returns the hyperlink's id, or 0 if the storage is at its maximum capacity
+    ///          with all hyperlinks still in use.
+    HyperlinkId addHyperlink(std::string const& _id, std::string const& _uri);
+
+    /// Evicts the least recently used hyperlinks not referred to by any cell.
+    ///
+    /// @returns the number of evicted hyperlinks.
+    size_t collectHyperlinks();
+
+    /// Styles of all cells in grid.
+    CellStyleTable cellStyles{};
+
+    /// @returns the interned style for erasing cells with the current graphics rendition.
+    CellStyle const& blankStyle()
+    {
+        if (blankStyle_->attributes != cursor.graphicsRendition)
+            blankStyle_ = &internStyle(CellStyle{cursor.graphicsRendition, {}});
+        return *blankStyle_;
+    }
+
+    /// @returns the interned style for writing text with the current graphics rendition.
+    ///
+    /// The current hyperlink is not part of the style but stored in each written cell.
+    CellStyle const& textStyle() { return blankStyle(); }
+
+    /// Interns @p _style, collecting unused styles first if the table has grown considerably.
+    CellStyle const& internStyle(CellStyle const& _style);
+
+    /// Removes all styles from cellStyles that are not in use anymore.
+    void collectCellStyles();
+
+    static constexpr size_t MinCellStyleCollectionThreshold = 4096;
+
+    /// Drops all cached cells of decoded lines, to be called whenever lines of grid are modified.
+    void invalidateDecodedLines() const noexcept;
+
+    struct DecodedLine {
+        Line const* line = nullptr;
+        LineBuffer cells;
+    };
+
+    mutable std::array<DecodedLine, 4> decodedLines_{};     // cells of recently decoded lines
+    mutable size_t nextDecodedLine_ = 0;                    // next entry of decodedLines_ to be replaced
+
+    /// Metadata of a page of history lines spilled to disk, kept in memory.
+    struct SpilledPage {
+        uint64_t serial;                        // identifies the page within pagedIn_
+        std::vector<CellStyle const*> styles;   // styles in use by the page (sorted), kept alive while spilled and referred to by index from its lines
+        std::vector<HyperlinkId> hyperlinks;    // hyperlinks in use by the page, kept alive while spilled
+        std::vector<bool> marks;                // Line::marked of each line
+    };
+
+    struct PagedInPage {
+        uint64_t serial = 0;
+        std::vector<Line> lines;
+    };
+
+    /// @returns the lines of the given spilled page, decoding them if not paged in yet.
+    std::vector<Line> const& pageIn(size_t _page) const;
+
+    /// Drops the oldest @p _count spilled history lines.
+    void dropSpilledLines(size_t _count);
+
+    /// Position within the lines being re-wrapped, by line index and column (both 0-based).
+    struct ReflowCursor {
+        size_t line;
+        size_t column;
+        bool wrapPending;
+    };
+
+    /// @returns the lines in grid from @p _first to @p _last (exclusive), re-wrapped to @p _width columns.
+    ///
+    /// The range must start at the beginning of a logical line. Trailing blank cells of logical lines
+    /// are dropped, and wide characters not fitting at the end of a line move to the next one.
+    /// The positions in @p _cursors, relative to @p _first, are moved along with the text.
+    std::vector<Line> reflow(size_t _first, size_t _last, size_t _width, crispy::span<ReflowCursor> _cursors) const;
+
+    /// Re-wraps the main page to @p _width columns, moving lines between the page and the history
+    /// as needed, while keeping the cursor on the page.
+    ///
+    /// Lines not fitting below the cursor are kept in linesBelowPage_ rather than being cut off.
+    void reflowPage(cursor_pos_t _width);
+
+    /// Lines that did not fit the page below the cursor after re-wrapping it, top to bottom.
+    ///
+    /// They are re-wrapped along with the page and moved back onto it as soon as there is room,
+    /// and discarded once the bottom of the page is scrolled or erased.
+    std::vector<Line> linesBelowPage_;
+
+    /// Accounts for the oldest @p _count history lines in grid having been removed.
+    void dropUnreflowedLines(size_t _count) noexcept
+    {
+        unreflowedHistoryLines_ -= std::min(_count, unreflowedHistoryLines_);
+    }
+
+    size_t unreflowedHistoryLines_ = 0;     // oldest lines in grid not re-wrapped to the page width yet
+
+    PageFile spillFile_;                    // serialized lines of spilled pages, oldest first
+    std::deque<SpilledPage> spilledPages_;  // metadata of the pages in spillFile_
+    size_t spilledLinesDropped_ = 0;        // lines of the first spilled page that have been dropped already
+    uint64_t nextSpilledPageSerial_ = 1;
+    mutable std::array<PagedInPage, 2> pagedIn_{};  // recently paged in pages
+    mutable size_t nextPagedIn_ = 0;                // next entry of pagedIn_ to be replaced
+
+    CellStyle const* blankStyle_ = &DefaultCellStyle;          // cached result of blankStyle()
+    size_t cellStyleCollectionThreshold_ = MinCellStyleCollectionThreshold;
+    size_t hyperlinkCollectionBackoff_ = 0;  // failing hyperlink additions to go before collecting again
 
 	void appendChar(char32_t _codepoint, bool _consecutive);
+
+    /// Appends a run of codepoints, equivalent to calling appendChar() for each of them.
+    ///
+    /// Runs of printable US-ASCII are written directly into the current line, computing
+    /// margins and wrapping once per line segment rather than once per cell.
+    ///
+    /// @param _consecutive whether or not the first codepoint directly follows previously appended text.
+    void appendText(std::u32string_view _text, bool _consecutive);
 	void writeCharToCurrentAndAdvance(char32_t _codepoint);
     void clearAndAdvance(int _offset);
 
@@ -495,7 +926,7 @@ struct ScreenBuffer {
 
     void updateCursorIterators()
     {
-        currentLine = next(begin(lines), cursor.position.row - 1);
+        currentLine = lineAt(cursor.position.row);
         updateColumnIterator();
     }
 
@@ -535,12 +966,21 @@ struct ScreenBuffer {
 			return {1, 1};
 	}
 
+    /// @returns the cell at the given position, inflating its line if it is compressed.
+    ///
+    /// Only rows down to (1 - inMemoryHistoryLineCount()) can be modified.
+    /// History lines spilled to disk must be read via the const overload.
 	Cell& at(Coordinate const& _coord) noexcept;
 
-    Cell const& at(Coordinate const& _pos) const noexcept
-    {
-        return const_cast<ScreenBuffer*>(this)->at(_pos);
-    }
+    /// @returns the cell at the given position, which is only valid until the next call
+    ///          if it is part of a compressed history line.
+    Cell const& at(Coordinate const& _pos) const noexcept;
+
+    /// @returns the cells of @p _line, padded to at least the screen width, decoding them if needed.
+    ///
+    /// Decoded cells are cached for a few lines, and are valid until the grid is modified
+    /// or cellsOf() is called for more lines than fit into the cache.
+    LineBuffer const& cellsOf(Line const& _line) const;
 
 	/// Returns identity if DECOM is disabled (default), but returns translated coordinates if DECOM is enabled.
 	Coordinate toRealCoordinate(Coordinate const& pos) const noexcept
@@ -597,25 +1037,12 @@ inline auto end(ScreenBuffer::Line const& _line) { return _line.cend(); }
 inline ScreenBuffer::Line::const_iterator cbegin(ScreenBuffer::Line const& _line) { return _line.cbegin(); }
 inline ScreenBuffer::Line::const_iterator cend(ScreenBuffer::Line const& _line) { return _line.cend(); }
 
-constexpr bool operator==(GraphicsAttributes const& a, GraphicsAttributes const& b) noexcept
-{
-    return a.backgroundColor == b.backgroundColor
-        && a.foregroundColor == b.foregroundColor
-        && a.styles == b.styles
-        && a.underlineColor == b.underlineColor;
-}
-
-constexpr bool operator!=(GraphicsAttributes const& a, GraphicsAttributes const& b) noexcept
-{
-    return !(a == b);
-}
-
-constexpr bool operator==(Cell const& a, Cell const& b) noexcept
+inline bool operator==(Cell const& a, Cell const& b) noexcept
 {
     if (a.codepointCount() != b.codepointCount())
         return false;
 
-    if (!(a.attributes() == b.attributes()))
+    if (&a.style() != &b.style() && !(a.attributes() == b.attributes()))
         return false;
 
     for (auto const i : crispy::times(a.codepointCount()))
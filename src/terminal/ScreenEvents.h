@@ -17,6 +17,9 @@ class ScreenEvents {
     virtual std::optional<RGBColor> requestDynamicColor(DynamicColorName /*_name*/) { return std::nullopt; }
     virtual void bell() {}
     virtual void bufferChanged(ScreenBuffer::Type) {}
+    /// Invoked after each write to the screen.
+    ///
+    /// @p _commands is only populated when command recording is enabled (see Screen::setRecordCommands()).
     virtual void commands(CommandList const& /*_commands*/) {}
     virtual void copyToClipboard(std::string_view const& /*_data*/) {}
     virtual void dumpState() {}
@@ -145,6 +145,72 @@ TEST_CASE("AppendChar.emoji_exclamationmark", "[screen]")
     CHECK(screen.at({1, 3}).attributes().backgroundColor == IndexedColor::Blue);
 }
 
+TEST_CASE("Screen.cellStyles", "[screen]")
+{
+    auto screen = MockScreen{{3, 2}};
+    auto const colorOf = [](int i) { return RGBColor{static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i), 0}; };
+
+    // Every line uses its own color, while history is cleared regularly, leaving most styles unused.
+    for (int i = 0; i < 20050; ++i)
+    {
+        auto const color = colorOf(i);
+        screen.write(fmt::format("\033[38;2;{};{};{}mA\u0301B\r\n", color.red, color.green, color.blue));
+        if (i % 100 == 99)
+            screen.clearScrollbackBuffer();
+    }
+
+    CHECK(screen.currentBuffer().cellStyles.size() <= ScreenBuffer::MinCellStyleCollectionThreshold);
+
+    // Styles in use must have survived.
+    CHECK(screen.at({1, 1}).attributes().foregroundColor == Color{colorOf(20049)});
+    CHECK(screen.at({1, 1}).codepoints() == U"A\u0301");
+    CHECK(screen.at({1, 2}).attributes().foregroundColor == Color{colorOf(20049)});
+    CHECK(screen.at({1, 2}).codepoints() == U"B");
+    CHECK(screen.at({0, 2}).attributes().foregroundColor == Color{colorOf(20048)});
+}
+
+TEST_CASE("Screen.hyperlinks", "[screen]")
+{
+    auto screen = MockScreen{{4, 2}};
+    screen.setMaxHistoryLineCount(0);
+
+    screen.write("\033]8;id=x;file:///x\033\\AB\033]8;;\033\\C");
+    CHECK(screen.at({1, 1}).hyperlink() != 0);
+    CHECK(screen.at({1, 2}).hyperlink() == screen.at({1, 1}).hyperlink());
+    CHECK(screen.at({1, 3}).hyperlink() == 0);
+    REQUIRE(screen.hyperlinkAt({1, 1}) != nullptr);
+    CHECK(screen.hyperlinkAt({1, 1})->uri == "file:///x");
+    CHECK(screen.hyperlinkAt({1, 3}) == nullptr);
+
+    // Hyperlinks scrolled off the screen get evicted once the storage is full.
+    for (int i = 0; i < 5000; ++i)
+        screen.write(fmt::format("\r\n\033]8;;file:///{}\033\\{:04}\033]8;;\033\\", i, i));
+
+    auto const& hyperlinks = screen.currentBuffer().hyperlinks;
+    CHECK(hyperlinks.size() <= hyperlinks.capacity());
+    REQUIRE(screen.hyperlinkAt({2, 1}) != nullptr);
+    CHECK(screen.hyperlinkAt({2, 1})->uri == "file:///4999");
+    REQUIRE(screen.hyperlinkAt({1, 4}) != nullptr);
+    CHECK(screen.hyperlinkAt({1, 4})->uri == "file:///4998");
+}
+
+TEST_CASE("Screen.hyperlinks_grow", "[screen]")
+{
+    auto screen = MockScreen{{4, 2}};
+    screen.setMaxHistoryLineCount(5000);
+
+    // All hyperlinks stay referenced from the history, so the storage has to grow.
+    auto constexpr count = 3 * HyperlinkStorage::DefaultCapacity;
+    for (size_t i = 0; i < count; ++i)
+        screen.write(fmt::format("\r\n\033]8;;file:///{}\033\\{:04}\033]8;;\033\\", i, i));
+
+    auto const& hyperlinks = screen.currentBuffer().hyperlinks;
+    CHECK(hyperlinks.size() == count);
+    CHECK(hyperlinks.capacity() >= count);
+    REQUIRE(screen.hyperlinkAt({2, 1}) != nullptr);
+    CHECK(screen.hyperlinkAt({2, 1})->uri == fmt::format("file:///{}", count - 1));
+}
+
 TEST_CASE("AppendChar.emoji_VS16_fixed_width", "[screen]")
 {
     auto screen = MockScreen{{5, 1}};
@@ -289,6 +355,49 @@ TEST_CASE("AppendChar_WideChar", "[screen]")
     CHECK(screen.cursorPosition() == Coordinate{1, 3});
 }
 
+TEST_CASE("AppendText", "[screen]")
+{
+    auto const check = [](auto const& _setup, u32string_view _text) {
+        auto bulk = MockScreen{{5, 3}};
+        auto single = MockScreen{{5, 3}};
+        bulk.write(_setup);
+        single.write(_setup);
+
+        bulk.write(AppendText{u32string(_text)});
+        for (char32_t const ch : _text)
+            single.write(AppendChar{ch});
+
+        logScreenText(bulk, "bulk");
+        logScreenText(single, "single");
+        CHECK(bulk.renderText() == single.renderText());
+        CHECK(bulk.cursorPosition() == single.cursorPosition());
+    };
+
+    check(string_view{""}, U"ABCDEFGHIJKLMNOPQ");
+    check(string_view{"\033[?7l"}, U"ABCDEFGH");
+    check(string_view{""}, U"AB\U0001F600CDE\u00F6\u0308FGH");
+    check(string_view{"\033[?69h\033[2;4s\033[2;1H"}, U"ABCDEFGHIJ");
+    check(string_view{"\033[?69h\033[2;4s\033[2;3H"}, U"ABCDEFGHIJ");
+    check(string_view{"\033(0"}, U"lqqkxmj");
+}
+
+TEST_CASE("Screen.recordCommands", "[screen]")
+{
+    auto constexpr input = string_view{"AB\033[2;3HC\r\nD\033[1mE\u00F6"};
+
+    auto fused = MockScreen{{5, 3}};
+    REQUIRE_FALSE(fused.recordCommands());
+    fused.write(input);
+
+    auto recorded = MockScreen{{5, 3}};
+    recorded.setRecordCommands(true);
+    REQUIRE(recorded.recordCommands());
+    recorded.write(input);
+
+    CHECK(fused.renderText() == recorded.renderText());
+    CHECK(fused.cursorPosition() == recorded.cursorPosition());
+}
+
 TEST_CASE("AppendChar_AutoWrap", "[screen]")
 {
     auto screen = MockScreen{{3, 2}};
@@ -751,6 +860,181 @@ TEST_CASE("ClearScrollbackBuffer", "[screen]")
     REQUIRE("12345" == screen.renderHistoryTextLine(1));
 }
 
+TEST_CASE("ScrollUp.bounded_history", "[screen]")
+{
+    auto screen = MockScreen{{3, 2}};
+    screen.setMaxHistoryLineCount(2);
+
+    // Once the history is full, every further line recycles the oldest one.
+    for (int i = 0; i < 100; ++i)
+        screen.write(fmt::format("{:03}\r\n", i));
+
+    CHECK(screen.historyLineCount() == 2);
+    CHECK("099\n   \n" == screen.renderText());
+    CHECK("098" == screen.renderHistoryTextLine(1));
+    CHECK("097" == screen.renderHistoryTextLine(2));
+    CHECK(screen.cursorPosition() == Coordinate{2, 1});
+
+    screen.write("X");
+    CHECK("099\nX  \n" == screen.renderText());
+
+    screen.setMaxHistoryLineCount(0);
+    CHECK(screen.historyLineCount() == 0);
+    screen.write("\r\nY");
+    CHECK("X  \nY  \n" == screen.renderText());
+}
+
+TEST_CASE("ScrollUp.compressed_history", "[screen]")
+{
+    auto screen = MockScreen{{8, 2}};
+
+    // Styled text, a grapheme cluster, a wide character, a hyperlink and a colored trailing blank.
+    screen.write("\033[31mAB\033[mC\u00E4\u0301\U0001F600\r\n");
+    screen.write("\033]8;;file:///x\033\\xy\033]8;;\033\\\033[44m\033[K\033[m\r\n");
+
+    REQUIRE(screen.historyLineCount() == 1);
+    auto const& buffer = screen.currentBuffer();
+    CHECK(buffer.lineAt(0)->compressed());
+    CHECK_FALSE(buffer.lineAt(1)->compressed());
+
+    CHECK("ABC\u00E4\u0301\U0001F600   " == screen.renderHistoryTextLine(1));
+    CHECK(screen.at({0, 1}).attributes().foregroundColor == Color{IndexedColor::Red});
+    CHECK(screen.at({0, 2}).codepoints() == U"B");
+    CHECK(screen.at({0, 3}).attributes().foregroundColor == Color{DefaultColor{}});
+    CHECK(screen.at({0, 4}).codepoints() == U"\u00E4\u0301");
+    CHECK(screen.at({0, 5}).codepoints() == U"\U0001F600");
+    CHECK(screen.at({0, 5}).width() == 2);
+    CHECK(screen.at({0, 6}).empty());
+    CHECK(screen.at({0, 8}).empty());
+
+    screen.write("\r\n");
+    REQUIRE(screen.historyLineCount() == 2);
+    CHECK(screen.renderHistoryTextLine(1) == "xy      ");
+    CHECK(screen.at({0, 1}).hyperlink() != 0);
+    CHECK(screen.at({0, 2}).hyperlink() == screen.at({0, 1}).hyperlink());
+    CHECK(screen.at({0, 3}).hyperlink() == 0);
+    CHECK(screen.at({0, 8}).attributes().backgroundColor == Color{IndexedColor::Blue});
+
+    // History lines taken back into the main page are decoded again.
+    screen.resize({8, 4});
+    CHECK_FALSE(buffer.lineAt(1)->compressed());
+    CHECK("ABC\u00E4\u0301\U0001F600   \nxy      \n        \n        \n" == screen.renderText());
+    CHECK(screen.at({1, 1}).attributes().foregroundColor == Color{IndexedColor::Red});
+    CHECK(screen.at({2, 8}).attributes().backgroundColor == Color{IndexedColor::Blue});
+}
+
+TEST_CASE("ScrollUp.spilled_history", "[screen]")
+{
+    auto screen = MockScreen{{4, 2}};
+    screen.setMaxHistoryLineCount(1000);
+    screen.setMaxHistoryPagesInMemory(0);
+
+    auto const text = [](int _n) { return fmt::format("{:04}", _n); };
+    for (int i = 0; i < 600; ++i)
+    {
+        if (i == 10)
+            screen.setMark();
+        if (i == 5)
+            screen.write("\033[31m" + text(i) + "\033[m\r\n");
+        else
+            screen.write(text(i) + "\r\n");
+    }
+
+    // All but the newest incomplete page of history has been spilled.
+    REQUIRE(screen.historyLineCount() == 599);
+    CHECK(screen.currentBuffer().spilledLineCount() == 512);
+    CHECK(screen.currentBuffer().inMemoryHistoryLineCount() == 87);
+
+    CHECK(screen.renderHistoryTextLine(1) == text(598));
+    CHECK(screen.renderHistoryTextLine(100) == text(499));
+    CHECK(screen.renderHistoryTextLine(300) == text(299));
+    CHECK(screen.renderHistoryTextLine(599) == text(0));
+    CHECK(as_const(screen).at({-593, 1}).attributes().foregroundColor == Color{IndexedColor::Red});
+    CHECK(as_const(screen).at({-592, 1}).attributes().foregroundColor == Color{DefaultColor{}});
+    CHECK(screen.findMarkerBackward(1) == -588);
+    CHECK(screen.findMarkerForward(-590) == -588);
+
+    // Rendering pages history back in, scrolled to the very top.
+    auto rendered = string{};
+    screen.render([&](Coordinate const& _pos, Cell const& _cell) {
+        rendered += _cell.empty() ? string(" ") : _cell.toUtf8();
+        if (_pos.column == 4)
+            rendered += '\n';
+    }, 599);
+    CHECK(rendered == text(0) + "\n" + text(1) + "\n");
+
+    // Clamping drops the oldest spilled lines first.
+    screen.setMaxHistoryLineCount(300);
+    REQUIRE(screen.historyLineCount() == 300);
+    CHECK(screen.currentBuffer().spilledLineCount() == 213);
+    CHECK(screen.renderHistoryTextLine(1) == text(598));
+    CHECK(screen.renderHistoryTextLine(300) == text(299));
+
+    screen.clearScrollbackBuffer();
+    CHECK(screen.historyLineCount() == 0);
+    CHECK(screen.currentBuffer().spilledLineCount() == 0);
+
+    screen.write("x\r\n");
+    REQUIRE(screen.historyLineCount() == 1);
+    CHECK(screen.renderHistoryTextLine(1) == text(599));
+}
+
+TEST_CASE("Screen.forEachChangedLine", "[screen]")
+{
+    auto screen = MockScreen{{5, 4}};
+    auto const changedSince = [&](uint64_t _generation) {
+        auto rows = vector<cursor_pos_t>{};
+        screen.forEachChangedLine(_generation, [&](cursor_pos_t _row) { rows.push_back(_row); });
+        return rows;
+    };
+
+    auto generation = screen.generation();
+    CHECK(changedSince(generation).empty());
+
+    SECTION("write") {
+        screen.write("\033[2;1Hab");
+        CHECK(screen.generation() > generation);
+        CHECK(changedSince(generation) == vector<cursor_pos_t>{2});
+
+        generation = screen.generation();
+        screen.write("\033[3;1H\033[K");
+        CHECK(changedSince(generation) == vector<cursor_pos_t>{3});
+
+        generation = screen.generation();
+        screen.write("\033[4;2H");
+        CHECK(changedSince(generation).empty());
+    }
+
+    SECTION("insert and delete characters") {
+        screen.write("\033[1;2H\033[@");
+        CHECK(changedSince(generation) == vector<cursor_pos_t>{1});
+
+        generation = screen.generation();
+        screen.write("\033[4;2H\033[P");
+        CHECK(changedSince(generation) == vector<cursor_pos_t>{4});
+    }
+
+    SECTION("scroll within margins") {
+        screen.write("\033[2;3r\033[3;1H\n");
+        CHECK(changedSince(generation) == vector<cursor_pos_t>{2, 3});
+    }
+
+    SECTION("erase below") {
+        screen.write("\033[3;1H\033[J");
+        CHECK(changedSince(generation) == vector<cursor_pos_t>{3, 4});
+    }
+
+    SECTION("switching buffers") {
+        screen.write("\033[?1049h");
+        CHECK(changedSince(generation) == vector<cursor_pos_t>{1, 2, 3, 4});
+
+        generation = screen.generation();
+        screen.write("\033[?1049l");
+        CHECK(screen.generation() > generation);
+        CHECK(changedSince(generation) == vector<cursor_pos_t>{1, 2, 3, 4});
+    }
+}
+
 TEST_CASE("EraseCharacters", "[screen]")
 {
     auto screen = MockScreen{{5, 5}};
@@ -1742,6 +2026,37 @@ TEST_CASE("render into history", "[screen]")
     }
 }
 
+TEST_CASE("renderRows", "[screen]")
+{
+    auto screen = MockScreen{{5, 2}};
+    screen.write("12345\r\n67890\r\nABCDE\r\nFGHIJ\r\nKLMNO");
+
+    auto const renderRows = [&](int _scrollOffset) {
+        auto rows = vector<tuple<cursor_pos_t, cursor_pos_t, string>>{};
+        screen.renderRows(
+            [&](cursor_pos_t _row, cursor_pos_t _line, crispy::span<Cell const> _cells) {
+                auto text = string{};
+                for (Cell const& cell : _cells)
+                    text += cell.toUtf8();
+                rows.emplace_back(_row, _line, text);
+            },
+            _scrollOffset
+        );
+        return rows;
+    };
+
+    using Rows = vector<tuple<cursor_pos_t, cursor_pos_t, string>>;
+    CHECK(renderRows(0) == Rows{{1, 1, "FGHIJ"}, {2, 2, "KLMNO"}});
+    CHECK(renderRows(1) == Rows{{1, 0, "ABCDE"}, {2, 1, "FGHIJ"}});
+    CHECK(renderRows(3) == Rows{{1, -2, "12345"}, {2, -1, "67890"}});
+    CHECK(renderRows(4) == Rows{{1, -2, "12345"}, {2, -1, "67890"}});
+
+    // Rows are exactly as wide as the screen, also after shrinking its width.
+    screen.resize({3, 2});
+    CHECK(renderRows(0) == Rows{{1, 1, "KLM"}, {2, 2, "NO"}});
+    CHECK(renderRows(1) == Rows{{1, 0, "IJ"}, {2, 1, "KLM"}});
+}
+
 TEST_CASE("HorizontalTabClear.AllTabs", "[screen]")
 {
     auto screen = MockScreen{{5, 3}};
@@ -2268,7 +2583,9 @@ TEST_CASE("resize", "[screen]")
 
     SECTION("shrink columns") {
         screen.resize({1, 2});
-        REQUIRE("A\nC\n" == screen.renderText());
+        REQUIRE("C\nD\n" == screen.renderText());
+        REQUIRE("B" == screen.renderHistoryTextLine(1));
+        REQUIRE("A" == screen.renderHistoryTextLine(2));
         REQUIRE(screen.cursorPosition() == Coordinate{2, 1});
     }
 
@@ -2285,9 +2602,10 @@ TEST_CASE("resize", "[screen]")
         REQUIRE("ABX\nCDY\n" == screen.renderText());
         REQUIRE(screen.cursorPosition() == Coordinate{1, 3});
 
-        // 3.) shrink
+        // 3.) shrink, re-wrapping the text while keeping the cursor on the page
         screen.resize({2, 2});
-        REQUIRE("AB\nCD\n" == screen.renderText());
+        REQUIRE("X \nCD\n" == screen.renderText());
+        REQUIRE("AB" == screen.renderHistoryTextLine(1));
         REQUIRE(screen.cursorPosition() == Coordinate{1, 2});
 
         // 4.) regrow (and see if pre-filled data were retained)
@@ -2305,7 +2623,7 @@ TEST_CASE("resize", "[screen]")
 
     SECTION("grow rows, shrink columns") {
         screen.resize({1, 3});
-        REQUIRE("A\nC\n \n" == screen.renderText());
+        REQUIRE("B\nC\nD\n" == screen.renderText());
     }
 
     SECTION("shrink rows, grow columns") {
@@ -2315,12 +2633,111 @@ TEST_CASE("resize", "[screen]")
 
     SECTION("shrink rows, shrink columns") {
         screen.resize({1, 1});
-        REQUIRE("C\n" == screen.renderText());
+        REQUIRE("D\n" == screen.renderText());
     }
 
     // TODO: what do we want to do when re resize to {0, y}, {x, 0}, {0, 0}?
 }
 
+TEST_CASE("resize.reflow", "[screen]")
+{
+    auto screen = MockScreen{{4, 3}};
+    auto const& buffer = screen.currentBuffer();
+    screen.write("ABCDEFGH");
+    REQUIRE("ABCD\nEFGH\n    \n" == screen.renderText());
+    CHECK_FALSE(buffer.lineAt(1)->wrapped);
+    CHECK(buffer.lineAt(2)->wrapped);
+    CHECK_FALSE(buffer.lineAt(3)->wrapped);
+
+    SECTION("soft-wrapped lines are joined") {
+        screen.resize({8, 3});
+        REQUIRE("ABCDEFGH\n        \n        \n" == screen.renderText());
+        CHECK(screen.cursorPosition() == Coordinate{1, 8});
+
+        // The pending wrap is retained.
+        screen.write("I");
+        REQUIRE("ABCDEFGH\nI       \n        \n" == screen.renderText());
+
+        screen.resize({3, 3});
+        REQUIRE("ABC\nDEF\nGHI\n" == screen.renderText());
+        CHECK(screen.cursorPosition() == Coordinate{3, 3});
+        CHECK(screen.historyLineCount() == 0);
+    }
+
+    SECTION("hard line breaks are kept") {
+        screen.write("\r\nxy");
+        screen.resize({8, 3});
+        REQUIRE("ABCDEFGH\nxy      \n        \n" == screen.renderText());
+        CHECK(screen.cursorPosition() == Coordinate{2, 3});
+
+        screen.resize({3, 3});
+        REQUIRE("DEF\nGH \nxy \n" == screen.renderText());
+        CHECK(screen.renderHistoryTextLine(1) == "ABC");
+        CHECK(screen.cursorPosition() == Coordinate{3, 3});
+    }
+
+    SECTION("lines below the cursor are kept") {
+        screen.write(MoveCursorTo{1, 1});
+        screen.resize({2, 3});
+        REQUIRE("AB\nCD\nEF\n" == screen.renderText());
+        CHECK(screen.cursorPosition() == Coordinate{1, 1});
+        CHECK(screen.historyLineCount() == 0);
+
+        SECTION("re-wrapping again") {
+            screen.resize({4, 3});
+            REQUIRE("ABCD\nEFGH\n    \n" == screen.renderText());
+        }
+
+        SECTION("growing the page") {
+            screen.resize({2, 4});
+            REQUIRE("AB\nCD\nEF\nGH\n" == screen.renderText());
+        }
+
+        SECTION("shrinking and regrowing the page") {
+            screen.resize({2, 2});
+            REQUIRE("AB\nCD\n" == screen.renderText());
+            screen.resize({2, 4});
+            REQUIRE("AB\nCD\nEF\nGH\n" == screen.renderText());
+        }
+
+        SECTION("scrolling the page") {
+            screen.write(MoveCursorTo{3, 1});
+            screen.write("\n");
+            screen.resize({2, 4});
+            REQUIRE("AB\nCD\nEF\n  \n" == screen.renderText());
+        }
+    }
+
+    SECTION("erased lines do not continue") {
+        screen.write(MoveCursorTo{2, 1});
+        screen.write(ClearLine{});
+        screen.resize({8, 3});
+        REQUIRE("ABCD    \n        \n        \n" == screen.renderText());
+    }
+}
+
+TEST_CASE("resize.reflow_history_lazily", "[screen]")
+{
+    auto screen = MockScreen{{4, 2}};
+    auto const& buffer = screen.currentBuffer();
+    screen.write("ABCDEFGH\r\n1234\r\nxy");
+    REQUIRE("1234\nxy  \n" == screen.renderText());
+    REQUIRE(screen.historyLineCount() == 2);
+
+    // Only the main page is re-wrapped right away.
+    screen.resize({8, 2});
+    REQUIRE("1234    \nxy      \n" == screen.renderText());
+    CHECK(screen.historyLineCount() == 2);
+    CHECK(buffer.unreflowedHistoryLineCount() == 2);
+
+    // Viewing the history re-wraps it.
+    CHECK(screen.scrollUp(1));
+    CHECK(buffer.unreflowedHistoryLineCount() == 0);
+    CHECK(screen.historyLineCount() == 1);
+    CHECK(screen.renderHistoryTextLine(1) == "ABCDEFGH");
+    CHECK(screen.renderTextLine(0) == "ABCDEFGH");
+}
+
 // TODO: SetForegroundColor
 // TODO: SetBackgroundColor
 // TODO: SetGraphicsRendition
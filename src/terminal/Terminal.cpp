@@ -40,6 +40,11 @@ Terminal::Terminal(Size _winSize,
     eventListener_{ _eventListener },
     logger_{ move(_logger) },
     pty_{ _winSize },
+#if defined(__linux__)
+    ptyWriter_{ pty_, [this]() { watchPtyWritable(); } },
+#else
+    ptyWriter_{ pty_ },
+#endif
     cursorDisplay_{ CursorDisplay::Steady }, // TODO: pass via param
     cursorShape_{ CursorShape::Block }, // TODO: pass via param
     cursorBlinkInterval_{ _cursorBlinkInterval },
@@ -55,37 +60,128 @@ Terminal::Terminal(Size _winSize,
         true, // logs raw output by default?
         true, // logs trace output by default?
         _maxHistoryLineCount
-    },
-    screenUpdateThread_{ [this]() { screenUpdateThread(); } }
+    }
 {
+    {
+        lock_guard<decltype(screenLock_)> _l{ screenLock_ };
+        publishSnapshot();
+    }
+
+#if defined(__linux__)
+    // All terminals share a single I/O thread, rather than blocking a thread each on reading.
+    // Input is written by the very same thread, whenever the PTY accepts more.
+    auto const id = PtyReactor::shared().add(
+        pty_.master(),
+        [this](char const* _data, size_t _size) { processOutput(_data, _size); },
+        [this]() { eventListener_.onClosed(); },
+        [this]() { return ptyWriter_.flush(); }
+    );
+    ptyReactorId_ = id;
+
+    // Replies to output processed before the id was known are not written otherwise.
+    if (ptyWriter_.pendingSize() != 0)
+        PtyReactor::shared().watchWritable(id);
+#else
+    ptyReaderThread_ = thread{ [this]() { ptyReaderThread(); } };
+    screenUpdateThread_ = thread{ [this]() { screenUpdateThread(); } };
+#endif
 }
 
 Terminal::~Terminal()
 {
+#if defined(__linux__)
+    if (auto const id = ptyReactorId_.exchange(0); id != 0)
+        PtyReactor::shared().remove(id);
+#else
+    ptyReaderThread_.join();
     screenUpdateThread_.join();
+#endif
 }
 
-void Terminal::screenUpdateThread()
+void Terminal::close()
 {
-    constexpr size_t BufSize = 32 * 1024;
-    vector<char> buf;
-    buf.resize(BufSize);
+#if defined(__linux__)
+    // The PTY must not be closed while being watched, as its handle may be reused right away.
+    if (auto const id = ptyReactorId_.exchange(0); id != 0)
+        PtyReactor::shared().remove(id);
+#endif
+    ptyWriter_.stop();
+    pty_.close();
+}
 
+#if defined(__linux__)
+void Terminal::watchPtyWritable()
+{
+    if (auto const id = ptyReactorId_.load(); id != 0)
+        PtyReactor::shared().watchWritable(id);
+}
+#else
+void Terminal::ptyReaderThread()
+{
     for (;;)
     {
-        if (auto const n = pty_.read(buf.data(), buf.size()); n != -1)
+        auto space = ptyOutput_.write_span();
+        if (space.empty())
+        {
+            auto _l = unique_lock{ ptyOutputLock_ };
+            ptyOutputChanged_.wait(_l, [this]() { return !ptyOutput_.full(); });
+            continue;
+        }
+
+        auto const n = pty_.read(space.begin(), space.size());
         {
-            //log("outputThread.data: {}", crispy::escape(buf, buf + n));
-            lock_guard<decltype(screenLock_)> _l{ screenLock_ };
-            screen_.write(buf.data(), n);
+            auto _l = lock_guard{ ptyOutputLock_ };
+            if (n != -1)
+                ptyOutput_.commit(static_cast<size_t>(n));
+            else
+                ptyClosed_ = true;
         }
-        else
+        ptyOutputChanged_.notify_all();
+
+        if (n == -1)
+            break;
+    }
+}
+
+void Terminal::screenUpdateThread()
+{
+    for (;;)
+    {
+        auto const chunk = ptyOutput_.read_span();
+        if (chunk.empty())
         {
+            auto _l = unique_lock{ ptyOutputLock_ };
+            ptyOutputChanged_.wait(_l, [this]() { return ptyClosed_ || !ptyOutput_.empty(); });
+            if (!ptyOutput_.empty())
+                continue;
+
+            _l.unlock();
             eventListener_.onClosed();
             break;
         }
+
+        processOutput(chunk.begin(), chunk.size());
+        {
+            auto _l = lock_guard{ ptyOutputLock_ };
+            ptyOutput_.consume(chunk.size());
+        }
+        ptyOutputChanged_.notify_all();
     }
 }
+#endif
+
+void Terminal::processOutput(char const* _data, size_t _size)
+{
+    //log("outputThread.data: {}", crispy::escape(_data, _data + _size));
+    lock_guard<decltype(screenLock_)> _l{ screenLock_ };
+    if (recorder_)
+        recorder_->output(_data, _size);
+
+    screen_.write(_data, _size);
+
+    if (snapshotRequested_.exchange(false))
+        publishSnapshot();
+}
 
 bool Terminal::send(KeyInputEvent const& _keyEvent, chrono::steady_clock::time_point _now)
 {
@@ -299,14 +395,15 @@ bool Terminal::send(InputEvent const& _inputEvent, chrono::steady_clock::time_po
 
 void Terminal::sendPaste(string_view const& _text)
 {
-    inputGenerator_.generatePaste(_text);
-    flushInput();
+    // Pastes are queued as they are, to be written piecewise while regular input may get ahead.
+    logger_(RawInputEvent{fmt::format("paste: {} bytes", _text.size())});
+    ptyWriter_.writePaste(string(_text), inputGenerator_.bracketedPaste());
 }
 
 void Terminal::flushInput()
 {
     inputGenerator_.swap(pendingInput_);
-    pty_.write(pendingInput_.data(), pendingInput_.size());
+    ptyWriter_.write(string_view(pendingInput_.data(), pendingInput_.size()));
     logger_(RawInputEvent{crispy::escape(begin(pendingInput_), end(pendingInput_))});
     pendingInput_.clear();
 }
@@ -346,6 +443,31 @@ void Terminal::updateCursorVisibilityState(std::chrono::steady_clock::time_point
     }
 }
 
+shared_ptr<RenderSnapshot const> Terminal::renderSnapshot(chrono::steady_clock::time_point _now) const
+{
+    if (auto _l = unique_lock<decltype(screenLock_)>{ screenLock_, try_to_lock }; _l.owns_lock())
+    {
+        updateCursorVisibilityState(_now);
+        publishSnapshot();
+    }
+    else
+    {
+        // The published snapshot is rendered now, and the requested one with the next frame.
+        snapshotRequested_ = true;
+        changes_++;
+    }
+
+    return atomic_load(&snapshot_);
+}
+
+void Terminal::publishSnapshot() const
+{
+    auto snapshot = takeSnapshot(screen_, atomic_load(&snapshot_));
+    snapshot->cursorShape = cursorShape_;
+    snapshot->cursorBlinkVisible = cursorBlinkVisible();
+    atomic_store(&snapshot_, shared_ptr<RenderSnapshot const>(move(snapshot)));
+}
+
 std::chrono::milliseconds Terminal::nextRender(chrono::steady_clock::time_point _now) const
 {
     auto const diff = chrono::duration_cast<chrono::milliseconds>(_now - lastCursorBlink_);
@@ -371,9 +493,33 @@ void Terminal::resizeScreen(Size _cells, optional<Size> _pixels)
     if (_pixels)
         screen_.setCellPixelSize(*_pixels / _cells);
 
+    if (recorder_)
+        recorder_->resize(_cells);
+
     pty_.resizeScreen(_cells, _pixels);
 }
 
+void Terminal::startRecording(string const& _path)
+{
+    lock_guard<decltype(screenLock_)> _l{ screenLock_ };
+    recorder_ = make_unique<PtyRecorder>(_path, screen_.size());
+
+    auto const screenshot = screen_.screenshot();
+    recorder_->output(screenshot.data(), screenshot.size());
+}
+
+void Terminal::stopRecording()
+{
+    lock_guard<decltype(screenLock_)> _l{ screenLock_ };
+    recorder_.reset();
+}
+
+bool Terminal::recording() const
+{
+    lock_guard<decltype(screenLock_)> _l{ screenLock_ };
+    return recorder_ != nullptr;
+}
+
 void Terminal::setCursorDisplay(CursorDisplay _display)
 {
     cursorDisplay_ = _display;
@@ -430,7 +576,7 @@ void Terminal::notify(std::string_view const& _title, std::string_view const& _b
 
 void Terminal::reply(string_view const& reply)
 {
-    pty_.write(reply.data(), reply.size());
+    ptyWriter_.write(reply);
 }
 
 void Terminal::resetDynamicColor(DynamicColorName _name)
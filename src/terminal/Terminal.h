@@ -17,13 +17,20 @@
 #include <terminal/Logger.h>
 #include <terminal/InputGenerator.h>
 #include <terminal/PseudoTerminal.h>
+#include <terminal/PtyRecording.h>
+#include <terminal/PtyReactor.h>
+#include <terminal/PtyWriter.h>
+#include <terminal/RenderSnapshot.h>
 #include <terminal/ScreenEvents.h>
 #include <terminal/Screen.h>
 
+#include <crispy/spsc_buffer.h>
+
 #include <fmt/format.h>
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -75,9 +82,22 @@ class Terminal : public ScreenEvents {
     /// Retrieves reference to the underlying PTY device.
     PseudoTerminal& device() noexcept { return pty_; }
 
+    /// Stops processing the output of the PTY device and closes it, hanging up on the process.
+    void close();
+
     Size screenSize() const noexcept { return pty_.screenSize(); }
     void resizeScreen(Size _cells, std::optional<Size> _pixels);
 
+    // {{{ recording
+    /// Starts recording the PTY output to the file at @p _path, to be replayed with vtreplay.
+    ///
+    /// The recording starts with a screenshot of the current screen.
+    /// Throws std::runtime_error if the file cannot be created.
+    void startRecording(std::string const& _path);
+    void stopRecording();
+    bool recording() const;
+    // }}}
+
     // {{{ input proxy
     // Sends given input event to connected slave.
     bool send(KeyInputEvent const& _inputEvent, std::chrono::steady_clock::time_point _now);
@@ -100,6 +120,8 @@ class Terminal : public ScreenEvents {
     void setLogRawOutput(bool _enabled) { screen_.setLogRaw(_enabled); }
     void setTabWidth(int _tabWidth) { screen_.setTabWidth(_tabWidth); }
     void setMaxHistoryLineCount(std::optional<size_t> _maxHistoryLineCount) { screen_.setMaxHistoryLineCount(_maxHistoryLineCount); }
+    void setMaxHistoryPagesInMemory(std::optional<size_t> _count) { screen_.setMaxHistoryPagesInMemory(_count); }
+    void setMaxPayloadSize(size_t _value) { screen_.setMaxPayloadSize(_value); }
     int historyLineCount() const noexcept { return screen_.historyLineCount(); }
     std::string const& windowTitle() const noexcept { return screen_.windowTitle(); }
     ScreenBuffer::Type screenBufferType() const noexcept { return screen_.bufferType(); }
@@ -157,10 +179,21 @@ class Terminal : public ScreenEvents {
 
     uint64_t preRender(std::chrono::steady_clock::time_point _now) const
     {
-        auto const changes = changes_.exchange(0);
+        auto const changes = takeChanges();
         updateCursorVisibilityState(_now);
         return changes;
     }
+
+    /// @returns the number of changes since the last call, resetting it.
+    uint64_t takeChanges() const noexcept { return changes_.exchange(0); }
+
+    /// @returns a snapshot of the screen to render, without ever waiting for the screen lock.
+    ///
+    /// The snapshot is taken right away, along with advancing the cursor's blink state to @p _now,
+    /// unless the screen is busy being updated. In that case the most recently published snapshot
+    /// is returned, and the screen update thread publishes a new one right after its current update,
+    /// to be picked up by the next frame.
+    std::shared_ptr<RenderSnapshot const> renderSnapshot(std::chrono::steady_clock::time_point _now) const;
     // }}}
 
     void lock() const { screenLock_.lock(); }
@@ -181,7 +214,13 @@ class Terminal : public ScreenEvents {
 
     bool shouldDisplayCursor() const noexcept
     {
-        return cursor().visible && (cursorDisplay_ != CursorDisplay::Blink || cursorBlinkState_);
+        return cursor().visible && cursorBlinkVisible();
+    }
+
+    /// Whether a blinking cursor is currently in its visible phase, or the cursor is not blinking at all.
+    bool cursorBlinkVisible() const noexcept
+    {
+        return cursorDisplay_ != CursorDisplay::Blink || cursorBlinkState_;
     }
 
     std::chrono::steady_clock::time_point lastCursorBlink() const noexcept
@@ -205,11 +244,26 @@ class Terminal : public ScreenEvents {
 
   private:
     void flushInput();
+#if defined(__linux__)
+    /// Has the shared PtyReactor flush ptyWriter_ once pty_ accepts more input.
+    void watchPtyWritable();
+#else
+    /// Reads the PTY's output into ptyOutput_, so that the PTY keeps being drained while parsing.
+    void ptyReaderThread();
+
+    /// Parses the PTY's output from ptyOutput_.
     void screenUpdateThread();
+#endif
+
+    /// Writes output read from the PTY device to the screen.
+    void processOutput(char const* _data, size_t _size);
     void onScreenReply(std::string_view const& reply);
     void onScreenCommands(std::vector<Command> const& commands);
     void updateCursorVisibilityState(std::chrono::steady_clock::time_point _now) const;
 
+    /// Replaces the published snapshot with a new one, to be called with the screen locked.
+    void publishSnapshot() const;
+
     template <typename... RemainingPasses>
     void renderPass(Screen::Renderer const& pass, RemainingPasses... remainingPasses) const
     {
@@ -250,6 +304,9 @@ class Terminal : public ScreenEvents {
     Logger logger_;
     PseudoTerminal pty_;
 
+    /// Writes input to pty_ without blocking the caller.
+    PtyWriter ptyWriter_;
+
     CursorDisplay cursorDisplay_;
     CursorShape cursorShape_;
     std::chrono::milliseconds cursorBlinkInterval_;
@@ -272,7 +329,33 @@ class Terminal : public ScreenEvents {
     InputGenerator::Sequence pendingInput_;
     Screen screen_;
     std::recursive_mutex mutable screenLock_;
+
+    /// Snapshot most recently published for rendering, only to be accessed via std::atomic_load()
+    /// and std::atomic_store(), as it is published and taken by different threads.
+    mutable std::shared_ptr<RenderSnapshot const> snapshot_;
+
+    /// Whether the render thread is waiting for the screen update thread to publish a snapshot.
+    mutable std::atomic<bool> snapshotRequested_{false};
+
+    /// Records the PTY output and screen size changes while set, guarded by screenLock_.
+    std::unique_ptr<PtyRecorder> recorder_;
+
+#if defined(__linux__)
+    /// Registration of pty_ with the shared PtyReactor, processing its output and writing
+    /// its input, or 0 while not registered.
+    std::atomic<PtyReactor::Id> ptyReactorId_{0};
+#else
+    /// Output read by ptyReaderThread_, yet to be processed by screenUpdateThread_.
+    crispy::spsc_buffer<char> ptyOutput_{ 256 * 1024 };
+
+    /// Only used for waiting on ptyOutputChanged_, never held while reading or processing output.
+    std::mutex ptyOutputLock_;
+    std::condition_variable ptyOutputChanged_;
+    bool ptyClosed_ = false;
+
+    std::thread ptyReaderThread_;
     std::thread screenUpdateThread_;
+#endif
 };
 
 }  // namespace terminal
@@ -47,7 +47,7 @@ TerminalProcess::~TerminalProcess()
     // Maybe the process is still alive, but we need to disconnect from the PTY,
     // so that the Process will be notified via SIGHUP.
     // NB: We MUST close the PTY device before waiting for the process to terminate.
-    terminal().device().close();
+    terminal().close();
 
     // Wait until the process is actually terminated.
     (void) Process::wait();
@@ -52,6 +52,25 @@ void BackgroundRenderer::renderCell(Coordinate const& _pos, RGBColor const& _col
     }
 }
 
+void BackgroundRenderer::renderRow(cursor_pos_t _row, crispy::span<Cell const> _cells)
+{
+    // Neighbouring cells mostly share their interned style, and thus their colors.
+    CellStyle const* style = nullptr;
+    RGBColor color{};
+
+    cursor_pos_t column = 1;
+    for (Cell const& cell : _cells)
+    {
+        if (&cell.style() != style)
+        {
+            style = &cell.style();
+            color = cell.attributes().makeColors(colorProfile_, false).second;
+        }
+        renderCell(Coordinate{_row, column++}, color);
+    }
+    renderPendingCells();
+}
+
 void BackgroundRenderer::renderOnce(Coordinate const& _pos, RGBColor const& _color, unsigned _count)
 {
     renderPendingCells();
@@ -44,6 +44,9 @@ class BackgroundRenderer {
     void renderCell(Coordinate const& _pos, Cell const& _cell);
     void renderCell(Coordinate const& _pos, RGBColor const& _color);
 
+    /// Queues up a render of the backgrounds of a whole row of cells, starting at column 1.
+    void renderRow(cursor_pos_t _row, crispy::span<Cell const> _cells);
+
     void renderOnce(Coordinate const& _pos, RGBColor const& _color, unsigned _count);
 
     void renderPendingCells();
@@ -260,15 +260,44 @@ void DecorationRenderer::rebuild()
     // TODO: Encircle
 }
 
+void DecorationRenderer::renderRow(cursor_pos_t _row, crispy::span<Cell const> _cells, HyperlinkId _hoveredHyperlink)
+{
+    auto constexpr decorationStyles = CharacterStyleMask::Underline
+                                    | CharacterStyleMask::DoublyUnderlined
+                                    | CharacterStyleMask::CurlyUnderlined
+                                    | CharacterStyleMask::DottedUnderline
+                                    | CharacterStyleMask::DashedUnderline
+                                    | CharacterStyleMask::Overline
+                                    | CharacterStyleMask::CrossedOut
+                                    | CharacterStyleMask::Framed
+                                    | CharacterStyleMask::Encircled;
+
+    cursor_pos_t column = 1;
+    for (Cell const& cell : _cells)
+    {
+        // Most cells are neither hyperlinked nor decorated.
+        if (cell.hyperlink())
+        {
+            auto const state = cell.hyperlink() == _hoveredHyperlink ? HyperlinkState::Hover
+                                                                     : HyperlinkState::Inactive;
+            renderCell(Coordinate{_row, column}, cell, state);
+        }
+        else if (cell.attributes().styles & decorationStyles)
+            renderCell(Coordinate{_row, column}, cell, nullopt);
+        ++column;
+    }
+}
+
 void DecorationRenderer::renderCell(Coordinate const& _pos,
-                                    Cell const& _cell)
+                                    Cell const& _cell,
+                                    optional<HyperlinkState> _hyperlink)
 {
-    if (_cell.hyperlink())
+    if (_hyperlink)
     {
-        auto const& color = _cell.hyperlink()->state == HyperlinkState::Hover
+        auto const& color = *_hyperlink == HyperlinkState::Hover
                             ? colorProfile_.hyperlinkDecoration.hover
                             : colorProfile_.hyperlinkDecoration.normal;
-        auto const decoration = _cell.hyperlink()->state == HyperlinkState::Hover
+        auto const decoration = *_hyperlink == HyperlinkState::Hover
                             ? hyperlinkHover_
                             : hyperlinkNormal_;
         renderDecoration(decoration, _pos, 1, color);
@@ -20,6 +20,8 @@
 
 #include <terminal/Screen.h>
 
+#include <optional>
+
 namespace terminal::view {
 
 struct ScreenCoordinates;
@@ -84,7 +86,12 @@ class DecorationRenderer {
         hyperlinkHover_ = _hover;
     }
 
-    void renderCell(Coordinate const& _pos, Cell const& _cell);
+    /// @param _hyperlink the state of the hyperlink of @p _cell, or nullopt if it has none.
+    void renderCell(Coordinate const& _pos, Cell const& _cell, std::optional<HyperlinkState> _hyperlink);
+
+    /// Renders the decorations of a whole row of cells, starting at column 1,
+    /// with cells of @p _hoveredHyperlink being decorated as hovered.
+    void renderRow(cursor_pos_t _row, crispy::span<Cell const> _cells, HyperlinkId _hoveredHyperlink);
 
     void renderDecoration(Decorator _decoration,
                           Coordinate const& _pos,
@@ -14,10 +14,10 @@
 #include <terminal_view/OpenGLRenderer.h>
 #include <terminal_view/TextRenderer.h>
 
-#include <crispy/algorithm.h>
-
 #include <algorithm>
+#include <cstddef>
 
+using crispy::atlas::RectangleInstance;
 using std::min;
 
 namespace terminal::view {
@@ -81,19 +81,24 @@ OpenGLRenderer::OpenGLRenderer(ShaderConfig const& _textShaderConfig,
 
     glGenBuffers(1, &rectVBO_);
     glBindBuffer(GL_ARRAY_BUFFER, rectVBO_);
-    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
 
-    auto constexpr BufferStride = 7 * sizeof(GLfloat);
-    auto const VertexOffset = (void const*) (0 * sizeof(GLfloat));
-    auto const ColorOffset = (void const*) (3 * sizeof(GLfloat));
+    // Each rectangle is one instance, expanded into a quad by the vertex shader.
+    auto constexpr Stride = sizeof(RectangleInstance);
+    auto const offset = [](size_t _offset) { return reinterpret_cast<void const*>(_offset); };
 
-    // 0 (vec3): vertex buffer
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, BufferStride, VertexOffset);
-    glEnableVertexAttribArray(0);
+    // 0 (vec2): position
+    glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, Stride, offset(offsetof(RectangleInstance, x)));
+    // 1 (vec2): size
+    glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_FALSE, Stride, offset(offsetof(RectangleInstance, width)));
+    // 2 (vec4): color
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, Stride, offset(offsetof(RectangleInstance, color)));
 
-    // 1 (vec4): color buffer
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, BufferStride, ColorOffset);
-    glEnableVertexAttribArray(1);
+    for (GLuint location = 0; location <= 2; ++location)
+    {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
 }
 
 OpenGLRenderer::~OpenGLRenderer()
@@ -157,49 +162,47 @@ void OpenGLRenderer::destroyAtlas(crispy::atlas::DestroyAtlas const& _param)
 
 void OpenGLRenderer::renderRectangle(unsigned _x, unsigned _y, unsigned _width, unsigned _height, QVector4D const& _color)
 {
-    GLfloat const x = _x;
-    GLfloat const y = _y;
-    GLfloat const z = 0.0f;
-    GLfloat const r = _width;
-    GLfloat const s = _height;
-    GLfloat const cr = _color[0];
-    GLfloat const cg = _color[1];
-    GLfloat const cb = _color[2];
-    GLfloat const ca = _color[3];
-
-    GLfloat const vertices[6 * 7] = {
-        // first triangle
-        x,     y + s, z, cr, cg, cb, ca,
-        x,     y,     z, cr, cg, cb, ca,
-        x + r, y,     z, cr, cg, cb, ca,
-
-        // second triangle
-        x,     y + s, z, cr, cg, cb, ca,
-        x + r, y,     z, cr, cg, cb, ca,
-        x + r, y + s, z, cr, cg, cb, ca
-    };
-
-    crispy::copy(vertices, back_inserter(rectBuffer_));
+    rectInstances_.emplace_back(crispy::atlas::makeRectangleInstance(static_cast<int>(_x), static_cast<int>(_y),
+                                                                     _width, _height, _color));
+}
+
+void OpenGLRenderer::uploadRectangles()
+{
+    if (rectInstances_.size() > rectCapacity_)
+    {
+        rectCapacity_ = std::max(rectInstances_.size(), 2 * rectCapacity_);
+        glBufferData(GL_ARRAY_BUFFER, rectCapacity_ * sizeof(RectangleInstance), nullptr, GL_DYNAMIC_DRAW);
+        uploadedRectInstances_.clear();
+    }
+
+    crispy::atlas::forEachChangedRange(uploadedRectInstances_, rectInstances_, 16, [&](size_t _offset, size_t _count) {
+        glBufferSubData(GL_ARRAY_BUFFER,
+                        static_cast<GLintptr>(_offset * sizeof(RectangleInstance)),
+                        static_cast<GLsizeiptr>(_count * sizeof(RectangleInstance)),
+                        rectInstances_.data() + _offset);
+    });
+
+    uploadedRectInstances_ = rectInstances_;
 }
 
 void OpenGLRenderer::execute()
 {
     // render filled rects
     //
-    if (!rectBuffer_.empty())
+    if (!rectInstances_.empty())
     {
         rectShader_->bind();
         rectShader_->setUniformValue(rectProjectionLocation_, projectionMatrix_);
 
         glBindVertexArray(rectVAO_);
         glBindBuffer(GL_ARRAY_BUFFER, rectVBO_);
-        glBufferData(GL_ARRAY_BUFFER, rectBuffer_.size() * sizeof(GLfloat), rectBuffer_.data(), GL_STREAM_DRAW);
+        uploadRectangles();
 
-        glDrawArrays(GL_TRIANGLES, 0, rectBuffer_.size() / 7);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(rectInstances_.size()));
 
         rectShader_->release();
         glBindVertexArray(0);
-        rectBuffer_.clear();
+        rectInstances_.clear();
     }
 
     // render textures
@@ -219,6 +222,10 @@ void OpenGLRenderer::execute()
 
     textureRenderer_.execute();
 
+    // Textures used so far may be evicted again.
+    monochromeAtlasAllocator_.nextFrame();
+    coloredAtlasAllocator_.nextFrame();
+
     textShader_->release();
 }
 
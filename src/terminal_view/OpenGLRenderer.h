@@ -14,6 +14,7 @@
 #pragma once
 
 #include <crispy/Atlas.h>
+#include <crispy/AtlasInstance.h>
 #include <crispy/AtlasRenderer.h>
 #include <terminal/Size.h>
 
@@ -21,7 +22,9 @@
 #include <QtGui/QOpenGLExtraFunctions>
 #include <QtGui/QOpenGLShaderProgram>
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace terminal::view {
 
@@ -56,12 +59,23 @@ class OpenGLRenderer :
     crispy::atlas::TextureAtlasAllocator& monochromeAtlasAllocator() noexcept { return monochromeAtlasAllocator_; }
     crispy::atlas::TextureAtlasAllocator& coloredAtlasAllocator() noexcept { return coloredAtlasAllocator_; }
 
+    /// @return the number of textures evicted from any atlas so far.
+    uint64_t atlasEvictions() const noexcept
+    {
+        return monochromeAtlasAllocator_.evictions() + coloredAtlasAllocator_.evictions();
+    }
+
+    /// Instances scheduled for the next execute() call, which may be appended to directly.
+    std::vector<crispy::atlas::TextureInstance>& textureInstances() noexcept { return textureRenderer_.instances(); }
+    std::vector<crispy::atlas::RectangleInstance>& rectangleInstances() noexcept { return rectInstances_; }
+
     void execute();
 
   private:
     void initialize();
     unsigned maxTextureDepth();
     unsigned maxTextureSize();
+    void uploadRectangles();
 
   private:
     bool initialized_ = false;
@@ -82,7 +96,9 @@ class OpenGLRenderer :
 
     // filled rectangles
     //
-    std::vector<GLfloat> rectBuffer_;
+    std::vector<crispy::atlas::RectangleInstance> rectInstances_;
+    std::vector<crispy::atlas::RectangleInstance> uploadedRectInstances_; // as in rectVBO_
+    size_t rectCapacity_ = 0;
     std::unique_ptr<QOpenGLShaderProgram> rectShader_;
     GLint rectProjectionLocation_;
     GLuint rectVAO_;
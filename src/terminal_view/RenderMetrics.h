@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include <fmt/format.h>
@@ -9,21 +11,40 @@ struct RenderMetrics {
     unsigned cellBackgroundRenderCount = 0;
     unsigned cachedText = 0; //!< number of text words that were rendered using the cache.
     unsigned shapedText = 0; //!< number of text segments that went through text shaping
+    unsigned renderedRows = 0; //!< number of rows rendered, as they changed since the previous frame
+    unsigned reusedRows = 0; //!< number of rows whose instances of the previous frame were reused
 
+    // Text shaping cache statistics, accumulated over the lifetime of the renderer.
+    uint64_t shapingCacheHits = 0;
+    uint64_t shapingCacheMisses = 0;
+    uint64_t shapingCacheEvictions = 0;
+    size_t shapingCacheSize = 0;     //!< number of text segments currently cached
+
+    /// Resets the counters of the current frame.
     constexpr void clear() noexcept
     {
         cellBackgroundRenderCount = 0;
         shapedText = 0;
         cachedText = 0;
+        renderedRows = 0;
+        reusedRows = 0;
     }
 
     std::string to_string() const
     {
         return fmt::format(
-            "background renders: {}, shaped text: {}, cached text: {}",
+            "background renders: {}, shaped text: {}, cached text: {}, "
+            "rendered rows: {}, reused rows: {}, "
+            "shaping cache: {} entries, {} hits, {} misses, {} evictions",
             cellBackgroundRenderCount,
             shapedText,
-            cachedText
+            cachedText,
+            renderedRows,
+            reusedRows,
+            shapingCacheSize,
+            shapingCacheHits,
+            shapingCacheMisses,
+            shapingCacheEvictions
         );
     }
 };
@@ -16,7 +16,7 @@
 
 #include <functional>
 
-using std::scoped_lock;
+using crispy::atlas::toInstanceCoordinate;
 using std::chrono::steady_clock;
 
 namespace terminal::view {
@@ -91,11 +91,13 @@ void Renderer::clearCache()
     decorationRenderer_.clearCache();
     cursorRenderer_.clearCache();
     textRenderer_.clearCache();
+    rowCache_.clear();
 }
 
 void Renderer::setFont(FontConfig const& _fonts)
 {
     textRenderer_.setFont(_fonts);
+    rowCache_.clear();
 }
 
 bool Renderer::setFontSize(int _fontSize)
@@ -129,6 +131,7 @@ void Renderer::setProjection(QMatrix4x4 const& _projectionMatrix)
 void Renderer::setBackgroundOpacity(terminal::Opacity _opacity)
 {
     backgroundOpacity_ = _opacity;
+    rowCache_.clear();
 }
 
 void Renderer::setColorProfile(terminal::ColorProfile const& _colors)
@@ -137,6 +140,7 @@ void Renderer::setColorProfile(terminal::ColorProfile const& _colors)
     textRenderer_.setColorProfile(_colors);
     decorationRenderer_.setColorProfile(_colors);
     cursorRenderer_.setColor(canonicalColor(colorProfile_.cursor));
+    rowCache_.clear();
 }
 
 uint64_t Renderer::render(Terminal& _terminal,
@@ -144,47 +148,38 @@ uint64_t Renderer::render(Terminal& _terminal,
                           terminal::Coordinate const& _currentMousePosition,
                           bool _pressure)
 {
-    auto const pressure = _pressure && _terminal.screenBufferType() == ScreenBuffer::Type::Main;
+    auto const changes = _terminal.takeChanges();
+
+    // Everything is rendered from a snapshot, so the screen can be updated meanwhile.
+    auto const snapshot = _terminal.renderSnapshot(_now);
+
+    auto const pressure = _pressure && snapshot->bufferType == ScreenBuffer::Type::Main;
     metrics_.clear();
     textRenderer_.setPressure(pressure);
 
-    screenCoordinates_.screenSize = _terminal.screenSize();
+    screenCoordinates_.screenSize = snapshot->size;
 
-    if (!pressure)
-        renderCursor(_terminal);
+    renderCursor(*snapshot, pressure);
 
-    uint64_t changes = 0;
-    {
-        auto _l = scoped_lock{_terminal};
-        textRenderer_.setReverseVideo(_terminal.screen().isModeEnabled(terminal::Mode::ReverseVideo));
-        if (!pressure && _terminal.screen().contains(_currentMousePosition))
-        {
-            auto& cellAtMouse = _terminal.screen().at(_currentMousePosition);
-            if (cellAtMouse.hyperlink())
-            {
-                cellAtMouse.hyperlink()->state = HyperlinkState::Hover; // TODO: Left-Ctrl pressed?
-            }
+    textRenderer_.setReverseVideo(snapshot->reverseVideo);
 
-            changes = _terminal.preRender(_now);
+    // TODO: Left-Ctrl pressed?
+    auto const hoveredHyperlink = !pressure && snapshot->contains(_currentMousePosition)
+                                ? snapshot->at(_currentMousePosition).hyperlink()
+                                : HyperlinkId{0};
 
-            _terminal.screen().render([this](Coordinate const& _pos, Cell const& _cell) { renderCell(_pos, _cell); },
-                                      _terminal.screen().scrollOffset());
-
-            if (cellAtMouse.hyperlink())
-                cellAtMouse.hyperlink()->state = HyperlinkState::Inactive;
-        }
-        else
-        {
-            changes = _terminal.preRender(_now);
-            _terminal.screen().render([this](Coordinate const& pos, Cell const& _cell) { renderCell(pos, _cell); },
-                                      _terminal.screen().scrollOffset());
-        }
+    auto const parameters = RowCacheParameters{screenCoordinates_, snapshot->reverseVideo, pressure, hoveredHyperlink};
+    if (parameters != rowCacheParameters_)
+    {
+        rowCache_.clear();
+        rowCacheParameters_ = parameters;
     }
 
-    backgroundRenderer_.renderPendingCells();
+    renderRows(*snapshot, hoveredHyperlink);
+
     backgroundRenderer_.finish();
 
-    renderSelection(_terminal);
+    renderSelection(*snapshot);
 
     textRenderer_.flushPendingSegments();
     textRenderer_.finish();
@@ -194,40 +189,50 @@ uint64_t Renderer::render(Terminal& _terminal,
     return changes;
 }
 
-void Renderer::renderCursor(Terminal const& _terminal)
+void Renderer::renderCursor(RenderSnapshot const& _snapshot, bool _pressure)
 {
+    // The cursor is rendered below the text, and thus always takes the first texture instance,
+    // even when hidden. Otherwise blinking it would move the instances of all rows by one,
+    // making them all to be uploaded again.
+    auto& textures = renderTarget_.textureInstances();
+    auto const textureCount = textures.size();
+
     // TODO: check if CursorStyle has changed, and update render context accordingly.
-    if (_terminal.shouldDisplayCursor() && _terminal.isLineVisible(_terminal.cursor().position.row))
+    auto const& cursorPosition = _snapshot.cursor.position;
+    if (!_pressure && _snapshot.cursor.visible && _snapshot.cursorBlinkVisible && _snapshot.isLineVisible(cursorPosition.row))
     {
-        Cell const& cursorCell = *_terminal.at(_terminal.cursor().position);
+        auto const row = cursorPosition.row + _snapshot.scrollOffset;
+        Cell const& cursorCell = _snapshot.at({row, cursorPosition.column});
 
-        auto const cursorShape = _terminal.screen().focused() ? _terminal.cursorShape()
-                                                              : CursorShape::Rectangle;
+        auto const cursorShape = _snapshot.focused ? _snapshot.cursorShape
+                                                   : CursorShape::Rectangle;
 
         cursorRenderer_.setShape(cursorShape);
 
         cursorRenderer_.render(
-            screenCoordinates_.map(_terminal.cursor().position.column, _terminal.cursor().position.row + _terminal.scrollOffset()),
+            screenCoordinates_.map(cursorPosition.column, row),
             cursorCell.width()
         );
     }
+
+    // An instance of zero size renders nothing.
+    if (textures.size() == textureCount)
+        textures.emplace_back(crispy::atlas::TextureInstance{});
 }
 
-void Renderer::renderSelection(Terminal const& _terminal)
+void Renderer::renderSelection(RenderSnapshot const& _snapshot)
 {
-    if (_terminal.screen().isSelectionAvailable())
+    if (!_snapshot.selection.empty())
     {
         // TODO: don't abouse BackgroundRenderer here, maybe invent RectRenderer?
         backgroundRenderer_.setOpacity(colorProfile_.selectionOpacity);
-        Screen const& screen = _terminal.screen();
-        auto const selection = screen.selection();
-        for (Selector::Range const& range : selection) // _terminal.screen().selection())
+        for (Selector::Range const& range : _snapshot.selection)
         {
             // TODO: see if we can extract and then unit-test this display rendering of selection
-            auto const relativeLineNr = range.line - _terminal.historyLineCount();// - _terminal.scrollOffset();
-            if (_terminal.isLineVisible(relativeLineNr))
+            auto const relativeLineNr = range.line - _snapshot.historyLineCount;
+            if (_snapshot.isLineVisible(relativeLineNr))
             {
-                auto const pos = Coordinate{relativeLineNr + _terminal.scrollOffset(), range.fromColumn};
+                auto const pos = Coordinate{relativeLineNr + _snapshot.scrollOffset, range.fromColumn};
                 auto const count = 1 + range.toColumn - range.fromColumn;
                 backgroundRenderer_.renderOnce(pos, colorProfile_.selection, count);
                 ++metrics_.cellBackgroundRenderCount;
@@ -238,11 +243,92 @@ void Renderer::renderSelection(Terminal const& _terminal)
     }
 }
 
-void Renderer::renderCell(Coordinate const& _pos, Cell const& _cell)
+void Renderer::renderRows(RenderSnapshot const& _snapshot, HyperlinkId _hoveredHyperlink)
+{
+    auto const evictions = renderTarget_.atlasEvictions();
+
+    // Only rows that changed since the previous frame are rendered, all others keep their instances.
+    cursor_pos_t rowNumber = 1;
+    for (auto const& row : _snapshot.rows)
+    {
+        if (auto node = rowCache_.extract(row.get()); !node.empty())
+        {
+            nextRowCache_.insert(move(node));
+            ++metrics_.reusedRows;
+        }
+        else
+        {
+            auto& instances = nextRowCache_[row.get()];
+            instances.row = row;
+            renderRow(rowNumber, *row, _hoveredHyperlink, instances);
+        }
+        ++rowNumber;
+    }
+    swap(rowCache_, nextRowCache_);
+    nextRowCache_.clear();
+
+    // Rendering new glyphs may have evicted the ones of reused rows from the texture atlas.
+    if (metrics_.reusedRows != 0 && renderTarget_.atlasEvictions() != evictions)
+    {
+        metrics_.renderedRows = 0;
+        metrics_.reusedRows = 0;
+        rowNumber = 1;
+        for (auto const& row : _snapshot.rows)
+            renderRow(rowNumber++, *row, _hoveredHyperlink, rowCache_[row.get()]);
+    }
+
+    auto& textures = renderTarget_.textureInstances();
+    auto& rectangles = renderTarget_.rectangleInstances();
+
+    rowNumber = 1;
+    for (auto const& row : _snapshot.rows)
+    {
+        RowInstances& instances = rowCache_[row.get()];
+
+        // Rows move up and down as the viewport is being scrolled.
+        if (auto const y = screenCoordinates_.map(1, rowNumber).y(); y != instances.y)
+        {
+            auto const offset = y - instances.y;
+            for (auto& texture : instances.textures)
+                texture.y = toInstanceCoordinate(texture.y + offset);
+            for (auto& rectangle : instances.rectangles)
+                rectangle.y = toInstanceCoordinate(rectangle.y + offset);
+            instances.y = y;
+        }
+
+        textures.insert(textures.end(), instances.textures.begin(), instances.textures.end());
+        rectangles.insert(rectangles.end(), instances.rectangles.begin(), instances.rectangles.end());
+        ++rowNumber;
+    }
+}
+
+void Renderer::renderRow(cursor_pos_t _row,
+                         RenderRow const& _renderRow,
+                         HyperlinkId _hoveredHyperlink,
+                         RowInstances& _instances)
+{
+    auto& textures = renderTarget_.textureInstances();
+    auto& rectangles = renderTarget_.rectangleInstances();
+    auto const textureCount = textures.size();
+    auto const rectangleCount = rectangles.size();
+
+    renderRow(_row, _renderRow.span(), _hoveredHyperlink);
+
+    // Move the row's instances out of the frame, they're added back in row order.
+    _instances.y = screenCoordinates_.map(1, _row).y();
+    _instances.textures.assign(textures.begin() + static_cast<ptrdiff_t>(textureCount), textures.end());
+    _instances.rectangles.assign(rectangles.begin() + static_cast<ptrdiff_t>(rectangleCount), rectangles.end());
+    textures.resize(textureCount);
+    rectangles.resize(rectangleCount);
+
+    ++metrics_.renderedRows;
+}
+
+void Renderer::renderRow(cursor_pos_t _row, crispy::span<Cell const> _cells, HyperlinkId _hoveredHyperlink)
 {
-    backgroundRenderer_.renderCell(_pos, _cell);
-    decorationRenderer_.renderCell(_pos, _cell);
-    textRenderer_.schedule(_pos, _cell);
+    backgroundRenderer_.renderRow(_row, _cells);
+    decorationRenderer_.renderRow(_row, _cells, _hoveredHyperlink);
+    textRenderer_.schedule(_row, _cells);
 }
 
 void Renderer::dumpState(std::ostream& _textOutput) const
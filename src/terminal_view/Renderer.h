@@ -25,14 +25,19 @@
 #include <terminal_view/OpenGLRenderer.h>
 
 #include <terminal/Logger.h>
+#include <terminal/RenderSnapshot.h>
 #include <terminal/Terminal.h>
 
+#include <crispy/AtlasInstance.h>
+
 #include <crispy/text/Font.h>
 
 #include <fmt/format.h>
 
 #include <chrono>
 #include <memory>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 
@@ -76,8 +81,12 @@ class Renderer {
     void setHyperlinkDecoration(Decorator _normal, Decorator _hover)
     {
         decorationRenderer_.setHyperlinkDecoration(_normal, _hover);
+        rowCache_.clear();
     }
 
+    /// Limits the number of shaped text segments the text renderer keeps cached.
+    void setTextShapingCacheCapacity(size_t _capacity) { textRenderer_.setCacheCapacity(_capacity); }
+
     constexpr void setScreenSize(Size const& _screenSize) noexcept
     {
         screenCoordinates_.screenSize = _screenSize;
@@ -118,13 +127,54 @@ class Renderer {
     void dumpState(std::ostream& _textOutput) const;
 
   private:
-    void renderCell(Coordinate const& _pos, Cell const& _cell);
-    void renderCursor(Terminal const& _terminal);
-    void renderSelection(Terminal const& _terminal);
+    /// The instances a row was rendered into, kept for as long as the row stays unchanged.
+    struct RowInstances {
+        std::shared_ptr<RenderRow const> row;   // keeps the row, and thus its address, alive
+        int y = 0;                              // window y coordinate the row was rendered at
+        std::vector<crispy::atlas::TextureInstance> textures;
+        std::vector<crispy::atlas::RectangleInstance> rectangles;
+    };
+
+    /// Everything besides the row itself that the instances of a row depend on.
+    struct RowCacheParameters {
+        ScreenCoordinates screenCoordinates;
+        bool reverseVideo;
+        bool pressure;
+        HyperlinkId hoveredHyperlink;
+
+        bool operator==(RowCacheParameters const& _rhs) const noexcept
+        {
+            auto const tie = [](RowCacheParameters const& _p) {
+                return std::tie(_p.screenCoordinates.screenSize,
+                                _p.screenCoordinates.cellWidth,
+                                _p.screenCoordinates.cellHeight,
+                                _p.screenCoordinates.textBaseline,
+                                _p.screenCoordinates.leftMargin,
+                                _p.screenCoordinates.bottomMargin,
+                                _p.reverseVideo,
+                                _p.pressure,
+                                _p.hoveredHyperlink);
+            };
+            return tie(*this) == tie(_rhs);
+        }
+        bool operator!=(RowCacheParameters const& _rhs) const noexcept { return !(*this == _rhs); }
+    };
+
+    void renderRows(RenderSnapshot const& _snapshot, HyperlinkId _hoveredHyperlink);
+    void renderRow(cursor_pos_t _row, RenderRow const& _renderRow, HyperlinkId _hoveredHyperlink, RowInstances& _instances);
+    void renderRow(cursor_pos_t _row, crispy::span<Cell const> _cells, HyperlinkId _hoveredHyperlink);
+    void renderCursor(RenderSnapshot const& _snapshot, bool _pressure);
+    void renderSelection(RenderSnapshot const& _snapshot);
 
   private:
     RenderMetrics metrics_;
 
+    // Instances of the rows rendered by the previous frame, keyed by the row of the snapshot,
+    // which is shared between snapshots for as long as its line is unchanged.
+    std::unordered_map<RenderRow const*, RowInstances> rowCache_;
+    std::unordered_map<RenderRow const*, RowInstances> nextRowCache_;
+    RowCacheParameters rowCacheParameters_{};
+
     ScreenCoordinates screenCoordinates_;
     Logger logger_;
 
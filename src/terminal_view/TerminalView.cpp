@@ -245,7 +245,7 @@ void TerminalView::wait()
     if (!process_.alive())
         return;
 
-    process_.terminal().device().close();
+    process_.terminal().close();
     (void) process_.wait();
 }
 
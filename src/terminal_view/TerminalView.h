@@ -97,6 +97,7 @@ class TerminalView : private Terminal::Events {
     void setBackgroundOpacity(terminal::Opacity _opacity) { renderer_.setBackgroundOpacity(_opacity); }
     void setHyperlinkDecoration(Decorator _normal, Decorator _hover) { renderer_.setHyperlinkDecoration(_normal, _hover); }
     void setProjection(QMatrix4x4 const& _projectionMatrix) { return renderer_.setProjection(_projectionMatrix); }
+    void setTextShapingCacheCapacity(size_t _capacity) { renderer_.setTextShapingCacheCapacity(_capacity); }
 
     /// Renders the screen buffer to the current OpenGL screen.
     uint64_t render(std::chrono::steady_clock::time_point const& _now, bool _pressure);
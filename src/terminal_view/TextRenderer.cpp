@@ -53,16 +53,18 @@ TextRenderer::TextRenderer(RenderMetrics& _renderMetrics,
                            ScreenCoordinates const& _screenCoordinates,
                            ColorProfile const& _colorProfile,
                            FontConfig const& _fonts,
-                           Size const& _cellSize) :
+                           Size const& _cellSize,
+                           size_t _cacheCapacity) :
     renderMetrics_{ _renderMetrics },
     screenCoordinates_{ _screenCoordinates },
     colorProfile_{ _colorProfile },
     fonts_{ _fonts },
+    cache_{ _cacheCapacity },
     cellSize_{ _cellSize },
     textShaper_{},
     commandListener_{ _commandListener },
-    monochromeAtlas_{ _monochromeAtlasAllocator },
-    colorAtlas_{ _colorAtlasAllocator }
+    monochromeAtlas_{ _monochromeAtlasAllocator, true },
+    colorAtlas_{ _colorAtlasAllocator, true }
 {
 }
 
@@ -73,11 +75,12 @@ void TextRenderer::clearCache()
 
     textShaper_.clearCache();
 
-    cacheKeyStorage_.clear();
     cache_.clear();
-#if !defined(NDEBUG)
-    cacheHits_.clear();
-#endif
+}
+
+void TextRenderer::setCacheCapacity(size_t _capacity)
+{
+    cache_.set_capacity(_capacity);
 }
 
 void TextRenderer::setCellSize(Size const& _cellSize)
@@ -163,6 +166,18 @@ void TextRenderer::schedule(Coordinate const& _pos, Cell const& _cell)
     }
 }
 
+void TextRenderer::schedule(cursor_pos_t _row, crispy::span<Cell const> _cells)
+{
+    cursor_pos_t column = 1;
+    for (Cell const& cell : _cells)
+        schedule(Coordinate{_row, column++}, cell);
+
+    // Text never continues on the next row, and this way a row renders to instances of its own.
+    flushPendingSegments();
+    state_ = State::Empty;
+    codepoints_.clear();
+}
+
 void TextRenderer::flushPendingSegments()
 {
     if (codepoints_.empty())
@@ -189,33 +204,15 @@ void TextRenderer::flushPendingSegments()
 GlyphPositionList const& TextRenderer::cachedGlyphPositions()
 {
     auto const codepoints = u32string_view(codepoints_.data(), codepoints_.size());
-    if (auto const cached = cache_.find(CacheKey{codepoints, attributes_.styles}); cached != cache_.end())
+    auto const styles = attributes_.styles.mask();
+
+    if (auto const cached = cache_.try_get(codepoints, styles); cached != nullptr)
     {
         METRIC_INCREMENT(cachedText);
-#if !defined(NDEBUG)
-        cacheHits_[cached->first]++;
-#endif
-        return cached->second;
+        return *cached;
     }
     else
-    {
-        cacheKeyStorage_.emplace_back(u32string{codepoints});
-
-        // std::cout << fmt::format("TextRenderer.newEntry({}): {}\n",
-        //         cacheKeyStorage_.size(),
-        //         unicode::to_utf8(cacheKeyStorage_.back()).c_str());
-
-        auto const cacheKeyFromStorage = CacheKey{
-            cacheKeyStorage_.back(),
-            attributes_.styles
-        };
-
-#if !defined(NDEBUG)
-        cacheHits_[cacheKeyFromStorage] = 0;
-#endif
-
-        return cache_[cacheKeyFromStorage] = requestGlyphPositions();
-    }
+        return cache_.emplace(codepoints, styles, requestGlyphPositions());
 }
 
 GlyphPositionList TextRenderer::requestGlyphPositions()
@@ -303,6 +300,11 @@ void TextRenderer::finish()
 {
     state_ = State::Empty;
     codepoints_.clear();
+
+    renderMetrics_.shapingCacheHits = cache_.hits();
+    renderMetrics_.shapingCacheMisses = cache_.misses();
+    renderMetrics_.shapingCacheEvictions = cache_.evictions();
+    renderMetrics_.shapingCacheSize = cache_.size();
 }
 
 void TextRenderer::render(QPoint _pos,
@@ -439,26 +441,16 @@ void TextRenderer::renderTexture(QPoint const& _pos,
 
 void TextRenderer::debugCache(std::ostream& _textOutput) const
 {
-    std::map<u32string, CacheKey> orderedKeys;
-
-    for (auto && [key, val] : cache_)
-    {
-        (void) val;
-        orderedKeys[u32string(key.text)] = key;
-    }
-
-    _textOutput << fmt::format("TextRenderer: {} cache entries:\n", orderedKeys.size());
-    for (auto && [word, key] : orderedKeys)
-    {
-#if !defined(NDEBUG)
-        auto hits = int64_t{};
-        if (auto i = cacheHits_.find(key); i != cacheHits_.end())
-            hits = i->second;
-        _textOutput << fmt::format("{:>5} : {}\n", hits, unicode::to_utf8(word));
-#else
-        _textOutput << fmt::format("  {}\n", unicode::to_utf8(word));
-#endif
-    }
+    std::multimap<u32string, uint32_t> orderedKeys;
+    cache_.for_each([&](u32string_view _text, uint32_t _styles, GlyphPositionList const&) {
+        orderedKeys.emplace(u32string(_text), _styles);
+    });
+
+    _textOutput << fmt::format("TextRenderer: {}/{} cache entries ({} hits, {} misses, {} evictions):\n",
+                               cache_.size(), cache_.capacity(),
+                               cache_.hits(), cache_.misses(), cache_.evictions());
+    for (auto && [word, styles] : orderedKeys)
+        _textOutput << fmt::format("  {:>4x} : {}\n", styles, unicode::to_utf8(word));
 }
 
 } // end namespace
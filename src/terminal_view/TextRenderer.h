@@ -21,6 +21,7 @@
 #include <crispy/Atlas.h>
 #include <crispy/AtlasRenderer.h>
 #include <crispy/FNV.h>
+#include <crispy/lru_string_cache.h>
 #include <crispy/text/Font.h>
 #include <crispy/text/TextShaper.h>
 
@@ -31,7 +32,6 @@
 #include <QtGui/QVector4D>
 
 #include <functional>
-#include <list>
 #include <unordered_map>
 #include <vector>
 
@@ -55,32 +55,6 @@ namespace terminal::view
 
         return false;
     }
-
-    struct CacheKey {
-        std::u32string_view text;
-        CharacterStyleMask styles;
-
-        bool operator==(CacheKey const& _rhs) const noexcept
-        {
-            return text == _rhs.text && styles == _rhs.styles;
-        }
-
-        bool operator!=(CacheKey const& _rhs) const noexcept
-        {
-            return !(*this == _rhs);
-        }
-
-        bool operator<(CacheKey const& _rhs) const noexcept
-        {
-            if (text < _rhs.text)
-                return true;
-
-            if (static_cast<unsigned>(styles) < static_cast<unsigned>(_rhs.styles))
-                return true;
-
-            return false;
-        }
-    };
 }
 
 namespace std
@@ -92,15 +66,6 @@ namespace std
             return hash<crispy::text::Font>{}(_glyphId.font.get()) + _glyphId.glyphIndex;
         }
     };
-
-    template <>
-    struct hash<terminal::view::CacheKey> {
-        size_t operator()(terminal::view::CacheKey const& _key) const noexcept
-        {
-            auto fnv = crispy::FNV<char32_t>{};
-            return static_cast<size_t>(fnv(fnv(_key.text.data(), _key.text.size()), static_cast<char32_t>(_key.styles)));
-        }
-    };
 }
 
 namespace terminal::view {
@@ -110,6 +75,9 @@ struct RenderMetrics;
 /// Text Rendering Pipeline
 class TextRenderer {
   public:
+    /// Default maximum number of shaped text segments to keep cached.
+    static constexpr size_t DefaultCacheCapacity = 8192;
+
     TextRenderer(RenderMetrics& _renderMetrics,
                  crispy::atlas::CommandListener& _commandListener,
                  crispy::atlas::TextureAtlasAllocator& _monochromeAtlasAllocator,
@@ -117,7 +85,8 @@ class TextRenderer {
                  ScreenCoordinates const& _screenCoordinates,
                  ColorProfile const& _colorProfile,
                  FontConfig const& _fonts,
-                 Size const& _cellSize);
+                 Size const& _cellSize,
+                 size_t _cacheCapacity = DefaultCacheCapacity);
 
     void setFont(FontConfig const& _fonts);
 
@@ -129,12 +98,19 @@ class TextRenderer {
     void setReverseVideo(bool _reverse) noexcept { reverseVideo_ = _reverse; }
 
     void schedule(Coordinate const& _pos, Cell const& _cell);
+
+    /// Schedules a whole row of cells for rendering, starting at column 1.
+    void schedule(cursor_pos_t _row, crispy::span<Cell const> _cells);
     void flushPendingSegments();
     void finish();
 
     void debugCache(std::ostream& _textOutput) const;
     void clearCache();
 
+    /// Limits the number of shaped text segments to keep cached, which clears the cache.
+    void setCacheCapacity(size_t _capacity);
+    size_t cacheCapacity() const noexcept { return cache_.capacity(); }
+
   private:
     void reset(Coordinate const& _pos, GraphicsAttributes const& _attr);
     void extend(Cell const& _cell, cursor_pos_t _column);
@@ -199,13 +175,9 @@ class TextRenderer {
     //
     bool pressure_ = false;
 
-    // text shaping cache
+    // text shaping cache, keyed by the codepoints and styles of a text segment
     //
-    std::list<std::u32string> cacheKeyStorage_;
-    std::unordered_map<CacheKey, crispy::text::GlyphPositionList> cache_;
-#if !defined(NDEBUG)
-    std::unordered_map<CacheKey, int64_t> cacheHits_;
-#endif
+    crispy::lru_string_cache<char32_t, crispy::text::GlyphPositionList> cache_;
 
     // target surface rendering
     //
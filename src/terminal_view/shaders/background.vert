@@ -1,11 +1,17 @@
 uniform mat4 u_projection;
-layout (location = 0) in mediump vec3 vs_vertex;    // target vertex coordinates
-layout (location = 1) in mediump vec4 vs_colors;    // custom foreground colors
+
+// One instance per rectangle, expanded into a quad drawn as a triangle strip of 4 vertices.
+layout (location = 0) in mediump vec2 vs_position;  // target position
+layout (location = 1) in mediump vec2 vs_size;      // target size
+layout (location = 2) in mediump vec4 vs_colors;    // custom foreground colors
 
 out mediump vec4 fs_textColor;
 
 void main()
 {
-    gl_Position = u_projection * vec4(vs_vertex.xyz, 1.0);
+    // corner of the quad: (0, 0), (1, 0), (0, 1), (1, 1)
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+
+    gl_Position = u_projection * vec4(vs_position + corner * vs_size, 0.0, 1.0);
     fs_textColor = vs_colors;
 }
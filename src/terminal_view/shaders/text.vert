@@ -3,23 +3,24 @@ uniform mat4 vs_projection;                         // projection matrix (flips
 uniform vec2 vs_cellSize;                           // size of a single cell.
 uniform vec2 vs_margin;                             // contains the left and bottom margin
 
-layout (location = 0) in mediump vec3 vs_vertex;    // target vertex coordinates
-layout (location = 1) in mediump vec4 vs_texCoords; // 3D-atlas texture coordinates
-layout (location = 2) in mediump vec4 vs_colors;    // custom foreground colors
+// One instance per texture, expanded into a quad drawn as a triangle strip of 4 vertices.
+layout (location = 0) in mediump vec2 vs_position;  // target position
+layout (location = 1) in mediump vec2 vs_size;      // target size
+layout (location = 2) in mediump vec4 vs_texCoords; // atlas coordinates: x, y, width, height
+layout (location = 3) in mediump vec2 vs_layer;     // atlas layer and user value (colored or not)
+layout (location = 4) in mediump vec4 vs_colors;    // custom foreground colors
 
 out mediump vec4 fs_TexCoord;
 out mediump vec4 fs_textColor;
 
 void main()
 {
-    #if 1
-    gl_Position = vs_projection * vec4(vs_vertex.xyz, 1.0);
-    #else
-    //OLD: gl_Position = vs_projection * vec4(vs_vertex.xyz, 1.0);
-    vec2 coord = vs_margin + vs_cellSize * vs_vertex.xy;
-    gl_Position = vs_projection * vec4(coord, 0.0, 1.0);
-    #endif
+    // corner of the quad: (0, 0), (1, 0), (0, 1), (1, 1)
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
 
-    fs_TexCoord = vs_texCoords;
+    gl_Position = vs_projection * vec4(vs_position + corner * vs_size, 0.0, 1.0);
+
+    // The atlas' y-axis points the opposite way of the target's.
+    fs_TexCoord = vec4(vs_texCoords.xy + vec2(corner.x, 1.0 - corner.y) * vs_texCoords.zw, vs_layer);
     fs_textColor = vs_colors;
 }